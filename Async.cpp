@@ -0,0 +1,272 @@
+#include "Async.h"
+#include "MathBlas.h"
+#include "Parallel.h"
+#include <algorithm>
+
+// Columns of the inverse, and rows of a product, computed by each thread of
+// the pool between two checkpoints.
+static const Index CHECKPOINT_BLOCK = 64;
+
+// Share of the work of an inversion spent in the factorisation (2/3 n^3 of
+// the 8/3 n^3 flops), the rest goes to the solves.
+static const double INVERSE_FACT_SHARE = 0.25;
+
+// Share of the work of a solve spent in the factorisation: the substitutions
+// are 2 n^2 flops against 2/3 n^3, but memory-bound, so they are given a
+// small share rather than a vanishing one.
+static const double SOLVE_FACT_SHARE = 0.95;
+
+// ERRORS
+JobCancelled::JobCancelled(const std::string& what)
+    : std::runtime_error(what)
+{}
+
+DeadlineExceeded::DeadlineExceeded(const std::string& what)
+    : JobCancelled(what)
+{}
+
+// JOB CONTROL
+JobControl::JobControl() : stop(false), deadline(0), fraction(0) {}
+
+void JobControl::cancel()
+{
+    stop = true;
+}
+
+bool JobControl::cancelled() const
+{
+    return stop;
+}
+
+void JobControl::set_deadline(std::chrono::steady_clock::time_point t)
+{
+    deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   t.time_since_epoch()).count();
+}
+
+void JobControl::set_timeout(double seconds)
+{
+    set_deadline(std::chrono::steady_clock::now()
+                 + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::duration<double>(seconds)));
+}
+
+void JobControl::set_progress_callback(const ProgressCallback& fn)
+{
+    callback = fn;
+}
+
+double JobControl::progress() const
+{
+    return fraction;
+}
+
+void JobControl::report(double done)
+{
+    fraction = done;
+    if (callback)
+        callback(done);
+}
+
+void JobControl::checkpoint(double done)
+{
+    report(done);
+
+    if (TaskScheduler::in_worker())
+        default_scheduler().run_urgent();
+
+    if (stop)
+        throw JobCancelled("job cancelled");
+
+    long long t = deadline;
+    if (t != 0 && std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                          .count() >= t)
+        throw DeadlineExceeded("job deadline exceeded");
+}
+
+// SUBMISSION
+// Runs fn(control) as a task of the pool, its result or its error going to
+// the returned job. The operands are captured by fn through shared pointers,
+// since the task is copied on its way to the queues. fn runs in a fork
+// scope, so the parallel kernels it calls use the other workers as when
+// called synchronously.
+template <typename T>
+static Job<T> submit_job(Priority priority, std::shared_ptr<JobControl> control,
+                         const std::function<T(JobControl&)>& fn)
+{
+    if (!control)
+        control = std::make_shared<JobControl>();
+
+    std::shared_ptr<std::promise<T> > result =
+        std::make_shared<std::promise<T> >();
+    Job<T> job(result->get_future(), control);
+
+    TaskScheduler::Task task = [result, control, fn] {
+        try {
+            TaskScheduler::ForkScope scope;
+            control->checkpoint(0);
+            T value = fn(*control);
+            control->report(1.0);
+            result->set_value(std::move(value));
+        }
+        catch (...) {
+            result->set_exception(std::current_exception());
+        }
+    };
+
+    if (priority == URGENT_PRIORITY)
+        default_scheduler().submit_urgent(task);
+    else
+        default_scheduler().submit(task);
+
+    return job;
+}
+
+// factorise f.lu in place, its progress mapped to [from, to]
+static void fact_job(PivotedLU& f, JobControl& control, double from,
+                     double to)
+{
+    lu_fact_pivoted(view(f.lu), f.ipiv, [&control, from, to](double done) {
+        control.checkpoint(from + done * (to - from));
+    });
+}
+
+// work between two checkpoints: a block of CHECKPOINT_BLOCK rows or columns
+// per thread of the pool
+static Index checkpoint_step(Index n)
+{
+    return CHECKPOINT_BLOCK * num_chunks(n, CHECKPOINT_BLOCK);
+}
+
+// solve for the columns of b in blocks, progress mapped to [from, to]
+static void solve_job(const PivotedLU& f, MatrixView<double> b,
+                      JobControl& control, double from, double to)
+{
+    Index n = b.getNcols(), step = checkpoint_step(n);
+
+    for (Index j = 0; j < n; j += step)
+    {
+        Index w = std::min(step, n - j);
+        parallel_for(w, num_chunks(w, CHECKPOINT_BLOCK),
+                     [&](Index lo, Index hi, int) {
+            lu_solve_pivoted(view(f.lu), f.ipiv,
+                             b.block(0, j + lo, b.getNrows(), hi - lo));
+        });
+        control.checkpoint(from + (double)(j + w) / n * (to - from));
+    }
+}
+
+static void check_square(const MathMatrix& a)
+{
+    if (a.getNrows() != a.getNcols())
+        throw std::invalid_argument("matrix not square");
+}
+
+// ASYNCHRONOUS JOBS
+Job<PivotedLU> async_lu_fact(const MathMatrix& a, Priority priority,
+                             std::shared_ptr<JobControl> control)
+{
+    check_square(a);
+
+    std::shared_ptr<PivotedLU> f = std::make_shared<PivotedLU>();
+    f->lu = a;
+
+    return submit_job<PivotedLU>(priority, control, [f](JobControl& c) {
+        fact_job(*f, c, 0, 1);
+        return std::move(*f);
+    });
+}
+
+Job<MathVector> async_lu_solve(const PivotedLU& f, const MathVector& b,
+                               Priority priority,
+                               std::shared_ptr<JobControl> control)
+{
+    check_square(f.lu);
+    if (f.lu.getNrows() != b.size() || f.ipiv.size() != b.size())
+        throw std::invalid_argument("sizes of factorisation and vector differ");
+
+    std::shared_ptr<PivotedLU> pf = std::make_shared<PivotedLU>(f);
+    std::shared_ptr<MathVector> x = std::make_shared<MathVector>(b);
+
+    return submit_job<MathVector>(priority, control, [pf, x](JobControl& c) {
+        solve_job(*pf, MatrixView<double>(x->data(), x->size(), 1, 1), c, 0,
+                  1);
+        return std::move(*x);
+    });
+}
+
+Job<MathVector> async_solve(const MathMatrix& a, const MathVector& b,
+                            Priority priority,
+                            std::shared_ptr<JobControl> control)
+{
+    check_square(a);
+    if (a.getNrows() != b.size())
+        throw std::invalid_argument("sizes of matrix and vector differ");
+
+    std::shared_ptr<PivotedLU> f = std::make_shared<PivotedLU>();
+    f->lu = a;
+    std::shared_ptr<MathVector> x = std::make_shared<MathVector>(b);
+
+    return submit_job<MathVector>(priority, control, [f, x](JobControl& c) {
+        fact_job(*f, c, 0, SOLVE_FACT_SHARE);
+        solve_job(*f, MatrixView<double>(x->data(), x->size(), 1, 1), c,
+                  SOLVE_FACT_SHARE, 1);
+        return std::move(*x);
+    });
+}
+
+Job<MathMatrix> async_inverse(const MathMatrix& a, Priority priority,
+                              std::shared_ptr<JobControl> control)
+{
+    check_square(a);
+
+    std::shared_ptr<PivotedLU> f = std::make_shared<PivotedLU>();
+    f->lu = a;
+
+    return submit_job<MathMatrix>(priority, control, [f](JobControl& c) {
+        Index n = f->lu.getNrows();
+
+        fact_job(*f, c, 0, INVERSE_FACT_SHARE);
+
+        MathMatrix inv(n);
+        for (Index i = 0; i < n; ++i)
+            inv(i, i) = 1;
+        solve_job(*f, view(inv), c, INVERSE_FACT_SHARE, 1);
+        return inv;
+    });
+}
+
+Job<MathMatrix> async_multiply(const MathMatrix& a, const MathMatrix& b,
+                               Priority priority,
+                               std::shared_ptr<JobControl> control)
+{
+    check_square(a);
+    check_square(b);
+    if (a.getNrows() != b.getNrows())
+        throw std::invalid_argument("sizes of matrices differ");
+
+    std::shared_ptr<MathMatrix> pa = std::make_shared<MathMatrix>(a);
+    std::shared_ptr<MathMatrix> pb = std::make_shared<MathMatrix>(b);
+
+    return submit_job<MathMatrix>(priority, control, [pa, pb](JobControl& c) {
+        Index n = pa->getNrows(), step = checkpoint_step(n);
+        MathMatrix res(n);
+        // const views, so the threads do not copy the shared storage
+        MatrixView<const double> av = view((const MathMatrix&)*pa);
+        MatrixView<const double> bv = view((const MathMatrix&)*pb);
+        MatrixView<double> rv = view(res);
+
+        for (Index i = 0; i < n; i += step)
+        {
+            Index h = std::min(step, n - i);
+            parallel_for(h, num_chunks(h, CHECKPOINT_BLOCK),
+                         [&](Index lo, Index hi, int) {
+                gemm(NO_TRANS, NO_TRANS, 1.0, av.block(i + lo, 0, hi - lo, n),
+                     bv, 0.0, rv.block(i + lo, 0, hi - lo, n));
+            });
+            c.checkpoint((double)(i + h) / n);
+        }
+        return res;
+    });
+}
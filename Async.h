@@ -0,0 +1,345 @@
+/**
+ * @file Async.h
+ * @brief Header file containing the asynchronous jobs, which factorise,
+ * solve, invert and multiply matrices on the library thread pool while the
+ * caller goes on.
+ *
+ * Every async_*() function checks its arguments, copies its operands and
+ * submits the job to default_scheduler(), returning at once a Job through
+ * which the result is waited for. A job runs as one task of the pool, in a
+ * TaskScheduler::ForkScope: between two checkpoints its solves and products
+ * are split among the workers (the job's own worker running parts of them
+ * while it waits), as when called synchronously; the factorisation runs on
+ * the job's worker, as lu_fact_pivoted() does. A job stops between its
+ * panels or blocks at checkpoints, where it
+ *
+ * - reports the fraction of the work done (see JobControl::progress());
+ * - runs the urgent tasks queued meanwhile (see TaskScheduler::run_urgent()),
+ *   so a small job submitted with URGENT_PRIORITY does not wait behind a long
+ *   one even when every worker is busy;
+ * - gives up with JobCancelled when it was cancelled, or with
+ *   DeadlineExceeded when its deadline has passed.
+ *
+ * Cancellation is cooperative: a job notices it only at its next checkpoint.
+ * The errors of a job (bad pivots, cancellation...) are thrown by Job::get().
+ * A job must not be waited for from inside a task of the pool, which could
+ * leave no worker to run it.
+ */
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "MathMatrix.h"
+
+/**
+ * @brief Queue a job is submitted to.
+ */
+enum Priority {
+    NORMAL_PRIORITY,  ///< The queues of the workers, in turn with other work.
+    URGENT_PRIORITY   ///< The urgent queue, served first and at checkpoints.
+};
+
+/**
+ * @brief Class meant to represent the error of a cancelled job.
+ */
+class JobCancelled : public std::runtime_error {
+public:
+    /**
+     * @brief A constructor.
+     * @param what Description of the error.
+     */
+    explicit JobCancelled(const std::string& what);
+};
+
+/**
+ * @brief Class meant to represent the error of a job whose deadline has
+ * passed.
+ */
+class DeadlineExceeded : public JobCancelled {
+public:
+    /**
+     * @brief A constructor.
+     * @param what Description of the error.
+     */
+    explicit DeadlineExceeded(const std::string& what);
+};
+
+/**
+ * @brief Class meant to represent the control of a job: its cancellation,
+ * deadline and progress.
+ *
+ * It is shared by the caller and the job, so it may be created before
+ * submitting the job (to set a deadline or a progress callback) and given to
+ * the async_*() function. Its functions may be called from any thread.
+ */
+class JobControl {
+public:
+    /**
+     * @brief Type of the progress callbacks, called with the fraction of the
+     * work done.
+     */
+    typedef std::function<void(double)> ProgressCallback;
+
+    /**
+     * @brief A default constructor, no deadline and no callback.
+     */
+    JobControl();
+
+    /**
+     * @brief Asks the job to stop at its next checkpoint.
+     */
+    void cancel();
+
+    /**
+     * @brief Tells whether the job was asked to stop.
+     * @return True after cancel().
+     */
+    bool cancelled() const;
+
+    /**
+     * @brief Sets the time by which the job must be finished.
+     * @param t Deadline.
+     */
+    void set_deadline(std::chrono::steady_clock::time_point t);
+
+    /**
+     * @brief Sets the deadline of the job relative to now.
+     * @param seconds Time left to the job.
+     */
+    void set_timeout(double seconds);
+
+    /**
+     * @brief Sets the function called at every checkpoint.
+     * @param fn Callback, called on the thread running the job.
+     *
+     * It must be set before the job is submitted.
+     */
+    void set_progress_callback(const ProgressCallback& fn);
+
+    /**
+     * @brief Returns the progress of the job.
+     * @return Fraction of the work done, in [0, 1].
+     */
+    double progress() const;
+
+    /**
+     * @brief Records the progress of the job and calls the callback.
+     * @param done Fraction of the work done.
+     */
+    void report(double done);
+
+    /**
+     * @brief Checkpoint of a job, called by the job between its steps.
+     * @param done Fraction of the work done.
+     *
+     * Reports the progress, runs the urgent tasks of the pool when called
+     * from a worker, then throws JobCancelled or DeadlineExceeded when the job
+     * must stop.
+     */
+    void checkpoint(double done);
+
+private:
+    JobControl(const JobControl&);             // not copyable
+    JobControl& operator=(const JobControl&);  // not copyable
+
+    std::atomic<bool> stop;
+    std::atomic<long long> deadline;  // steady_clock nanoseconds, 0 for none
+    std::atomic<double> fraction;
+    ProgressCallback callback;
+};
+
+/**
+ * @brief Class meant to represent a submitted job and its future result.
+ */
+template <typename T>
+class Job {
+public:
+    /**
+     * @brief A default constructor, no job.
+     */
+    Job();
+
+    /**
+     * @brief An alternate constructor.
+     * @param r Future result of the job.
+     * @param control Control of the job.
+     */
+    Job(std::future<T>&& r, const std::shared_ptr<JobControl>& control);
+
+    /**
+     * @brief Waits for the job and returns its result.
+     * @return Result of the job.
+     *
+     * It throws the error of the job, if any. It may be called only once.
+     */
+    T get();
+
+    /**
+     * @brief Tells whether the job has finished.
+     * @return True when get() would not wait.
+     */
+    bool ready() const;
+
+    /**
+     * @brief Waits for the job at most a given time.
+     * @param seconds Longest wait.
+     * @return True when the job has finished.
+     */
+    bool wait_for(double seconds) const;
+
+    /**
+     * @brief Asks the job to stop at its next checkpoint.
+     */
+    void cancel();
+
+    /**
+     * @brief Returns the progress of the job.
+     * @return Fraction of the work done, in [0, 1].
+     */
+    double progress() const;
+
+    /**
+     * @brief Returns the control of the job.
+     * @return Control shared with the job.
+     */
+    std::shared_ptr<JobControl> control() const;
+
+private:
+    std::future<T> result;
+    std::shared_ptr<JobControl> ctl;
+};
+
+/**
+ * @brief LU factorisation with partial pivoting, as computed by
+ * lu_fact_pivoted().
+ */
+struct PivotedLU {
+    MathMatrix lu;      ///< L and U in one matrix.
+    Vector<int> ipiv;   ///< Pivots.
+};
+
+// ASYNCHRONOUS JOBS
+// Every function below takes, after its operands, the priority of the job
+// and optionally a control created by the caller (a new one otherwise). They
+// throw std::invalid_argument at once when the sizes of the operands do not
+// match.
+
+/**
+ * @brief Factorises a matrix with partial pivoting.
+ * @param a Square matrix.
+ * @param priority Queue of the job.
+ * @param control Control of the job.
+ * @return Job computing the factorisation, checkpointed after every panel.
+ */
+Job<PivotedLU> async_lu_fact(const MathMatrix& a,
+                             Priority priority = NORMAL_PRIORITY,
+                             std::shared_ptr<JobControl> control = {});
+
+/**
+ * @brief Solves the equation Ax = b with a factorisation of A.
+ * @param f Factorisation of A.
+ * @param b Vector b.
+ * @param priority Queue of the job.
+ * @param control Control of the job.
+ * @return Job computing x.
+ */
+Job<MathVector> async_lu_solve(const PivotedLU& f, const MathVector& b,
+                               Priority priority = NORMAL_PRIORITY,
+                               std::shared_ptr<JobControl> control = {});
+
+/**
+ * @brief Solves the equation Ax = b.
+ * @param a Square matrix A.
+ * @param b Vector b.
+ * @param priority Queue of the job.
+ * @param control Control of the job.
+ * @return Job factorising A and computing x.
+ */
+Job<MathVector> async_solve(const MathMatrix& a, const MathVector& b,
+                            Priority priority = NORMAL_PRIORITY,
+                            std::shared_ptr<JobControl> control = {});
+
+/**
+ * @brief Inverts a matrix.
+ * @param a Square matrix.
+ * @param priority Queue of the job.
+ * @param control Control of the job.
+ * @return Job computing the inverse, checkpointed after every panel of the
+ * factorisation and every block of columns of the inverse.
+ */
+Job<MathMatrix> async_inverse(const MathMatrix& a,
+                              Priority priority = NORMAL_PRIORITY,
+                              std::shared_ptr<JobControl> control = {});
+
+/**
+ * @brief Multiplies two matrices.
+ * @param a Left-side square matrix.
+ * @param b Right-side square matrix.
+ * @param priority Queue of the job.
+ * @param control Control of the job.
+ * @return Job computing ab, checkpointed after every block of rows.
+ */
+Job<MathMatrix> async_multiply(const MathMatrix& a, const MathMatrix& b,
+                               Priority priority = NORMAL_PRIORITY,
+                               std::shared_ptr<JobControl> control = {});
+
+// JOB
+template <typename T>
+Job<T>::Job() {}
+
+template <typename T>
+Job<T>::Job(std::future<T>&& r, const std::shared_ptr<JobControl>& control)
+    : result(std::move(r)), ctl(control)
+{}
+
+template <typename T>
+T Job<T>::get()
+{
+    if (!result.valid())
+        throw std::logic_error("no result to get");
+
+    return result.get();
+}
+
+template <typename T>
+bool Job<T>::ready() const
+{
+    return wait_for(0);
+}
+
+template <typename T>
+bool Job<T>::wait_for(double seconds) const
+{
+    if (!result.valid())
+        return false;
+
+    return result.wait_for(std::chrono::duration<double>(seconds))
+           == std::future_status::ready;
+}
+
+template <typename T>
+void Job<T>::cancel()
+{
+    if (ctl)
+        ctl->cancel();
+}
+
+template <typename T>
+double Job<T>::progress() const
+{
+    return ctl ? ctl->progress() : 0;
+}
+
+template <typename T>
+std::shared_ptr<JobControl> Job<T>::control() const
+{
+    return ctl;
+}
+
+#endif /* ASYNC_H */
@@ -0,0 +1,554 @@
+#include "Backend.h"
+#include "MathMatrix.h"
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#ifdef MATH_USE_CBLAS
+#include <cblas.h>
+#endif
+
+// SELECTION
+#ifdef MATH_USE_CBLAS
+static std::atomic<int> selected(CBLAS_BACKEND);
+#else
+static std::atomic<int> selected(REFERENCE_BACKEND);
+#endif
+
+bool backend_available(Backend b)
+{
+    switch (b)
+    {
+    case REFERENCE_BACKEND:
+        return true;
+    case CBLAS_BACKEND:
+#ifdef MATH_USE_CBLAS
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+void set_backend(Backend b)
+{
+    if (!backend_available(b))
+        throw std::invalid_argument("backend not available");
+    selected.store(b, std::memory_order_relaxed);
+}
+
+Backend get_backend()
+{
+    return (Backend)selected.load(std::memory_order_relaxed);
+}
+
+const char* backend_name(Backend b)
+{
+    switch (b)
+    {
+    case REFERENCE_BACKEND:
+        return "reference";
+    case CBLAS_BACKEND:
+        return "cblas";
+    }
+    return "unknown";
+}
+
+// SYSTEM LIBRARY
+#ifdef MATH_USE_CBLAS
+// LAPACK through its Fortran interface (column-major, arguments passed by
+// address, pivots counted from 1), which every LAPACK provides, unlike the
+// LAPACKE C layer
+extern "C" {
+void dgetrf_(const int* m, const int* n, double* a, const int* lda, int* ipiv,
+             int* info);
+void dgetrs_(const char* trans, const int* n, const int* nrhs, const double* a,
+             const int* lda, const int* ipiv, double* b, const int* ldb,
+             int* info);
+double dlange_(const char* norm, const int* m, const int* n, const double* a,
+               const int* lda, double* work);
+}
+
+// Describes an r x c operand to CBLAS, which takes row-major matrices with
+// a leading dimension ld: an operand with contiguous rows is one as it is,
+// one with contiguous columns is the transposition of one. Returns false
+// for any other operand, or one whose sizes do not fit the int of CBLAS.
+static bool blas_operand(MatrixView<const double> x, CBLAS_TRANSPOSE& trans,
+                         int& ld)
+{
+    Index r = x.getNrows(), c = x.getNcols();
+    Index rs = x.getRowStride(), cs = x.getColStride();
+
+    if (!fits_int(r) || !fits_int(c))
+        return false;
+
+    // strides of a single column or row are never used
+    if (c <= 1)
+        cs = 1;
+    if (r <= 1 && cs == 1)
+        rs = c > 1 ? c : 1;
+
+    if (cs == 1 && rs >= (c > 1 ? c : 1) && fits_int(rs))
+    {
+        trans = CblasNoTrans;
+        ld = (int)rs;
+        return true;
+    }
+    if (rs == 1 && cs >= (r > 1 ? r : 1) && fits_int(cs))
+    {
+        trans = CblasTrans;
+        ld = (int)cs;
+        return true;
+    }
+    return false;
+}
+
+// stride of a vector operand for CBLAS, 0 when it does not take it
+static int blas_stride(Index size, Index stride)
+{
+    if (size <= 1)
+        return 1;
+    return stride > 0 && fits_int(stride) ? (int)stride : 0;
+}
+
+// Copies between a view and contiguous column-major storage, for LAPACK.
+static void to_col_major(MatrixView<const double> a, double* p)
+{
+    Index r = a.getNrows(), c = a.getNcols();
+
+    for (Index j = 0; j < c; ++j)
+        for (Index i = 0; i < r; ++i)
+            p[j * r + i] =
+                a.data()[i * a.getRowStride() + j * a.getColStride()];
+}
+
+static void from_col_major(const double* p, MatrixView<double> a)
+{
+    Index r = a.getNrows(), c = a.getNcols();
+
+    for (Index j = 0; j < c; ++j)
+        for (Index i = 0; i < r; ++i)
+            a.data()[i * a.getRowStride() + j * a.getColStride()] =
+                p[j * r + i];
+}
+
+// tells whether a view is column-major as LAPACK takes it
+static bool col_major(MatrixView<const double> a)
+{
+    Index r = a.getNrows();
+
+    return (a.getRowStride() == 1 || r <= 1) &&
+           a.getColStride() >= (r > 1 ? r : 1) && fits_int(a.getColStride());
+}
+#endif
+
+// DISPATCH
+bool backend_gemm(double alpha, MatrixView<const double> a,
+                  MatrixView<const double> b, double beta,
+                  MatrixView<double> c)
+{
+#ifdef MATH_USE_CBLAS
+    CBLAS_TRANSPOSE ta, tb, tc;
+    int lda, ldb, ldc;
+
+    if (get_backend() != CBLAS_BACKEND || !blas_operand(c, tc, ldc))
+        return false;
+    if (tc == CblasTrans)
+    {
+        // C with contiguous columns: C^T = op(B)^T op(A)^T
+        MatrixView<const double> t = a;
+        a = b.transpose();
+        b = t.transpose();
+        c = c.transpose();
+        blas_operand(c, tc, ldc);
+    }
+    if (!blas_operand(a, ta, lda) || !blas_operand(b, tb, ldb))
+        return false;
+
+    cblas_dgemm(CblasRowMajor, ta, tb, (int)c.getNrows(), (int)c.getNcols(),
+                (int)a.getNcols(), alpha, a.data(), lda, b.data(), ldb, beta,
+                c.data(), ldc);
+    return true;
+#else
+    (void)alpha;
+    (void)a;
+    (void)b;
+    (void)beta;
+    (void)c;
+    return false;
+#endif
+}
+
+bool backend_gemv(double alpha, MatrixView<const double> a,
+                  VectorView<const double> x, double beta,
+                  VectorView<double> y)
+{
+#ifdef MATH_USE_CBLAS
+    CBLAS_TRANSPOSE ta;
+    int lda;
+    int xs = blas_stride(x.size(), x.getStride());
+    int ys = blas_stride(y.size(), y.getStride());
+
+    if (get_backend() != CBLAS_BACKEND || !blas_operand(a, ta, lda) ||
+        xs == 0 || ys == 0)
+        return false;
+
+    // CBLAS takes the sizes of the stored matrix, before transposition
+    Index m = ta == CblasNoTrans ? a.getNrows() : a.getNcols();
+    Index n = ta == CblasNoTrans ? a.getNcols() : a.getNrows();
+    cblas_dgemv(CblasRowMajor, ta, (int)m, (int)n, alpha, a.data(), lda,
+                x.data(), xs, beta, y.data(), ys);
+    return true;
+#else
+    (void)alpha;
+    (void)a;
+    (void)x;
+    (void)beta;
+    (void)y;
+    return false;
+#endif
+}
+
+bool backend_trsm(Side side, UpLo uplo, Transpose ta, Diag diag, double alpha,
+                  MatrixView<const double> a, MatrixView<double> b)
+{
+#ifdef MATH_USE_CBLAS
+    CBLAS_TRANSPOSE tb, tas;
+    int lda, ldb;
+
+    if (get_backend() != CBLAS_BACKEND || !blas_operand(b, tb, ldb))
+        return false;
+    if (tb == CblasTrans)
+    {
+        // B with contiguous columns: solve the transposed equation, for B^T
+        side = side == LEFT ? RIGHT : LEFT;
+        ta = ta == TRANS ? NO_TRANS : TRANS;
+        b = b.transpose();
+        blas_operand(b, tb, ldb);
+    }
+    if (!blas_operand(a, tas, lda))
+        return false;
+    if (tas == CblasTrans)
+    {
+        // A is the transposition of the stored matrix S, op(A) = op'(S)
+        // and the lower triangle of A is the upper one of S
+        ta = ta == TRANS ? NO_TRANS : TRANS;
+        uplo = uplo == LOWER ? UPPER : LOWER;
+    }
+
+    cblas_dtrsm(CblasRowMajor, side == LEFT ? CblasLeft : CblasRight,
+                uplo == LOWER ? CblasLower : CblasUpper,
+                ta == TRANS ? CblasTrans : CblasNoTrans,
+                diag == UNIT ? CblasUnit : CblasNonUnit, (int)b.getNrows(),
+                (int)b.getNcols(), alpha, a.data(), lda, b.data(), ldb);
+    return true;
+#else
+    (void)side;
+    (void)uplo;
+    (void)ta;
+    (void)diag;
+    (void)alpha;
+    (void)a;
+    (void)b;
+    return false;
+#endif
+}
+
+bool backend_getrf(MatrixView<double> a, Vector<int>& ipiv)
+{
+#ifdef MATH_USE_CBLAS
+    Index n = a.getNrows();
+    int info, ni = (int)n, lda;
+
+    if (get_backend() != CBLAS_BACKEND || !fits_int(n * n))
+        return false;
+
+    // row-major views are factorised in a column-major copy, O(n^2) next to
+    // the O(n^3) of the factorisation
+    Vector<double> tmp;
+    double* p = a.data();
+    if (col_major(a))
+        lda = (int)a.getColStride();
+    else
+    {
+        tmp = Vector<double>(n * n, UNINITIALIZED);
+        to_col_major(a, tmp.data());
+        p = tmp.data();
+        lda = n > 1 ? ni : 1;
+    }
+
+    dgetrf_(&ni, &ni, p, &lda, ipiv.data(), &info);
+    if (info < 0)
+        throw std::invalid_argument("invalid argument to LAPACK");
+
+    if (p != a.data())
+        from_col_major(p, a);
+    for (Index i = 0; i < n; ++i)
+        ipiv[i] -= 1;  // pivots counted from 0
+
+    if (info > 0)
+        throw std::runtime_error("matrix is singular");
+    return true;
+#else
+    (void)a;
+    (void)ipiv;
+    return false;
+#endif
+}
+
+bool backend_getrs(MatrixView<const double> lu, const Vector<int>& ipiv,
+                   MatrixView<double> b)
+{
+#ifdef MATH_USE_CBLAS
+    Index n = lu.getNrows(), nrhs = b.getNcols();
+    int info, ni = (int)n, nrhsi = (int)nrhs, lda, ldb;
+    const char trans = 'N';
+
+    if (get_backend() != CBLAS_BACKEND || !fits_int(n * n) ||
+        !fits_int(n * nrhs))
+        return false;
+
+    Vector<int> piv(n, UNINITIALIZED);
+    for (Index i = 0; i < n; ++i)
+        piv[i] = ipiv[i] + 1;  // pivots counted from 1
+
+    Vector<double> tlu, tb;
+    const double* plu = lu.data();
+    double* pb = b.data();
+    if (col_major(lu))
+        lda = (int)lu.getColStride();
+    else
+    {
+        tlu = Vector<double>(n * n, UNINITIALIZED);
+        to_col_major(lu, tlu.data());
+        plu = tlu.data();
+        lda = n > 1 ? ni : 1;
+    }
+    if (col_major(b))
+        ldb = (int)b.getColStride();
+    else
+    {
+        tb = Vector<double>(n * nrhs, UNINITIALIZED);
+        to_col_major(b, tb.data());
+        pb = tb.data();
+        ldb = n > 1 ? ni : 1;
+    }
+
+    dgetrs_(&trans, &ni, &nrhsi, plu, &lda, piv.data(), pb, &ldb, &info);
+    if (info < 0)
+        throw std::invalid_argument("invalid argument to LAPACK");
+
+    if (pb != b.data())
+        from_col_major(pb, b);
+    return true;
+#else
+    (void)lu;
+    (void)ipiv;
+    (void)b;
+    return false;
+#endif
+}
+
+bool backend_norm(Norm norm, MatrixView<const double> a, double& res)
+{
+#ifdef MATH_USE_CBLAS
+    if (get_backend() != CBLAS_BACKEND)
+        return false;
+
+    // a row-major matrix is the column-major storage of its transposition,
+    // whose 1-norm is the uniform norm of the matrix and conversely
+    if (!col_major(a))
+    {
+        a = a.transpose();
+        if (!col_major(a))
+            return false;
+        norm = norm == ONE_NORM ? UNIFORM_NORM :
+               norm == UNIFORM_NORM ? ONE_NORM : norm;
+    }
+
+    Index m = a.getNrows(), n = a.getNcols();
+    if (!fits_int(m) || !fits_int(n))
+        return false;
+
+    int mi = (int)m, ni = (int)n, lda = (int)a.getColStride();
+    const char kind = norm == ONE_NORM ? '1' : norm == UNIFORM_NORM ? 'I' : 'F';
+    std::vector<double> work(m > 0 ? m : 1);
+
+    res = m == 0 || n == 0 ? 0.0
+                           : dlange_(&kind, &mi, &ni, a.data(), &lda,
+                                     work.data());
+    return true;
+#else
+    (void)norm;
+    (void)a;
+    (void)res;
+    return false;
+#endif
+}
+
+// CONFORMANCE
+// Every check returns the largest difference between the result of the
+// backend and the one of the reference, relative to the largest element of
+// the reference result.
+
+static void fill_random(Matrix<double>& m, std::mt19937& gen)
+{
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    for (Index i = 0; i < m.getNrows() * m.getNcols(); ++i)
+        m.data()[i] = dist(gen);
+}
+
+static double difference(const Matrix<double>& x, const Matrix<double>& y)
+{
+    double diff = 0, scale = 0;
+
+    for (Index i = 0; i < y.getNrows() * y.getNcols(); ++i)
+    {
+        diff = fmax(diff, fabs(x.data()[i] - y.data()[i]));
+        scale = fmax(scale, fabs(y.data()[i]));
+    }
+    return scale > 0 ? diff / scale : diff;
+}
+
+// runs f (which fills the result it is given) on the reference and on b
+template <typename F>
+static double compare(Backend b, Index m, Index n, F f)
+{
+    Matrix<double> ref(m, n), res(m, n);
+
+    set_backend(REFERENCE_BACKEND);
+    f(ref);
+    set_backend(b);
+    f(res);
+    return difference(res, ref);
+}
+
+double backend_conformance(Backend b, Index n)
+{
+    if (!backend_available(b))
+        throw std::invalid_argument("backend not available");
+    if (n < 2)
+        throw std::invalid_argument("conformance size too small");
+
+    Backend saved = get_backend();
+    std::mt19937 gen(12345);
+    Index k = n + 3, p = n - 1;  // distinct sizes catch swapped dimensions
+    Matrix<double> a(k, k), bm(k, k), c0(k, k), t(k, k), rhs(n, 3);
+    double worst = 0;
+
+    fill_random(a, gen);
+    fill_random(bm, gen);
+    fill_random(c0, gen);
+    fill_random(rhs, gen);
+
+    // well-conditioned triangular (and general) matrix
+    t = a;
+    for (Index i = 0; i < k; ++i)
+        t(i, i) += k;
+
+    try
+    {
+        // products, every transposition, C with contiguous rows or columns
+        for (int ta = 0; ta < 2; ++ta)
+            for (int tb = 0; tb < 2; ++tb)
+                for (int tc = 0; tc < 2; ++tc)
+                {
+                    Transpose opa = ta ? TRANS : NO_TRANS;
+                    Transpose opb = tb ? TRANS : NO_TRANS;
+                    MatrixView<const double> va =
+                        ta ? block(a, 0, 0, k, n) : block(a, 0, 0, n, k);
+                    MatrixView<const double> vb =
+                        tb ? block(bm, 0, 0, p, k) : block(bm, 0, 0, k, p);
+                    worst = fmax(worst, compare(b, tc ? p : n, tc ? n : p,
+                        [&](Matrix<double>& r) {
+                            MatrixView<double> vc =
+                                tc ? transpose(r) : view(r);
+                            for (Index i = 0; i < n; ++i)
+                                for (Index j = 0; j < p; ++j)
+                                    vc(i, j) = c0(i, j);
+                            gemm(opa, opb, 0.5, va, vb, 2.0, vc);
+                        }));
+                }
+
+        // matrix by vector products, strided vectors
+        for (int ta = 0; ta < 2; ++ta)
+            worst = fmax(worst, compare(b, n, 2, [&](Matrix<double>& r) {
+                VectorView<const double> x(bm.data() + 1, n, k);
+                gemv(ta ? TRANS : NO_TRANS, -1.5, block(a, 0, 0, n, n), x,
+                     0.0, column(r, 1));
+            }));
+
+        // triangular solves, every variant, B with contiguous rows or
+        // columns
+        for (int v = 0; v < 32; ++v)
+        {
+            Side side = v & 1 ? RIGHT : LEFT;
+            UpLo uplo = v & 2 ? UPPER : LOWER;
+            Transpose ta = v & 4 ? TRANS : NO_TRANS;
+            Diag diag = v & 8 ? UNIT : NON_UNIT;
+            bool tb = v & 16;
+            Index na = side == LEFT ? n : p;
+            worst = fmax(worst, compare(b, tb ? p : n, tb ? n : p,
+                [&](Matrix<double>& r) {
+                    MatrixView<double> vb = tb ? transpose(r) : view(r);
+                    for (Index i = 0; i < n; ++i)
+                        for (Index j = 0; j < p; ++j)
+                            vb(i, j) = c0(i, j);
+                    trsm(side, uplo, ta, diag, 2.0, block(t, 0, 0, na, na),
+                         vb);
+                }));
+        }
+
+        // LU factorisation of a matrix with contiguous rows or columns
+        for (int tr = 0; tr < 2; ++tr)
+            worst = fmax(worst, compare(b, n, n, [&](Matrix<double>& r) {
+                Vector<int> ipiv(n);
+                MatrixView<double> va = tr ? transpose(r) : view(r);
+                for (Index i = 0; i < n; ++i)
+                    for (Index j = 0; j < n; ++j)
+                        va(i, j) = a(i, j);
+                lu_fact_pivoted(va, ipiv);
+            }));
+
+        // solution with the factors of the reference
+        Matrix<double> lu(n, n);
+        Vector<int> ipiv(n);
+        for (Index i = 0; i < n; ++i)
+            for (Index j = 0; j < n; ++j)
+                lu(i, j) = a(i, j);
+        set_backend(REFERENCE_BACKEND);
+        lu_fact_pivoted(view(lu), ipiv);
+        worst = fmax(worst, compare(b, n, 3, [&](Matrix<double>& r) {
+            r = rhs;
+            lu_solve_pivoted(view(lu), ipiv, view(r));
+        }));
+
+        // norms
+        MathMatrix sq(n);
+        for (Index i = 0; i < n; ++i)
+            for (Index j = 0; j < n; ++j)
+                sq(i, j) = a(i, j);
+        worst = fmax(worst, compare(b, 1, 3, [&](Matrix<double>& r) {
+            r(0, 0) = sq.one_norm();
+            r(0, 1) = sq.two_norm();
+            r(0, 2) = sq.uniform_norm();
+        }));
+    }
+    catch (...)
+    {
+        set_backend(saved);
+        throw;
+    }
+
+    set_backend(saved);
+    return worst;
+}
+
+bool backend_conforms(Backend b, Index n)
+{
+    return backend_conformance(b, n) <= CONFORMANCE_TOLERANCE * n * DBL_EPSILON;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file Backend.h
+ * @brief Header file containing the selection of the library which runs the
+ * dense linear algebra kernels.
+ *
+ * The products (gemm(), gemv()), the triangular solve (trsm()), the LU
+ * factorisation with partial pivoting and its solve (lu_fact_pivoted(),
+ * lu_solve_pivoted()) and the matrix norms of MathMatrix run either on the
+ * kernels of this library, the reference, or on a system CBLAS and LAPACK
+ * (eg. OpenBLAS or MKL). The system library is compiled in when
+ * MATH_USE_CBLAS is defined, for the library and the program alike, and the
+ * program is linked with it (eg. -lopenblas); it is then the default
+ * backend. set_backend() switches between the backends at run time.
+ *
+ * Operands the system library cannot take (neither their rows nor their
+ * columns contiguous, negative strides, or sizes beyond its int indices)
+ * are left to the reference kernels, so every call gives a result whatever
+ * the backend. backend_conformance() checks a backend against the
+ * reference, backend_conforms() against a stated bound (see the conformance
+ * mode of the benchmark program).
+ */
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include "MathBlas.h"
+
+/**
+ * @brief Library running the kernels.
+ */
+enum Backend {
+    REFERENCE_BACKEND,  ///< The kernels of this library.
+    CBLAS_BACKEND       ///< The system CBLAS and LAPACK.
+};
+
+/**
+ * @brief Matrix norms computed by the backends.
+ */
+enum Norm {
+    ONE_NORM,        ///< Maximum absolute column sum.
+    FROBENIUS_NORM,  ///< Square root of the sum of the squares.
+    UNIFORM_NORM     ///< Maximum absolute row sum.
+};
+
+/**
+ * @brief Tells whether a backend is compiled in.
+ * @param b Backend.
+ * @return True for the reference, and for CBLAS_BACKEND when MATH_USE_CBLAS
+ * is defined.
+ */
+bool backend_available(Backend b);
+
+/**
+ * @brief Selects the backend of the whole library.
+ * @param b Backend.
+ *
+ * It throws an exception when the backend is not available. Calls already
+ * running complete on the backend they started on.
+ */
+void set_backend(Backend b);
+
+/**
+ * @brief Returns the selected backend.
+ * @return Backend, CBLAS_BACKEND by default when it is available.
+ */
+Backend get_backend();
+
+/**
+ * @brief Name of a backend, e.g. "cblas".
+ * @param b Backend.
+ * @return Name of the backend.
+ */
+const char* backend_name(Backend b);
+
+/**
+ * @brief Checks a backend against the reference.
+ * @param b Backend.
+ * @param n Size of the test matrices.
+ * @return Largest difference between the results of b and of the reference,
+ * relative to the largest element of the reference result, over all the
+ * routines of the backend and all their variants (transpositions, sides,
+ * triangles, strides).
+ *
+ * Matrices of random elements are given to every routine run once on b and
+ * once on the reference. Results agreeing to a small multiple of the
+ * machine precision (times n) show that b computes the same thing; an
+ * error in b shows as a difference of order 1. The selected backend is
+ * switched while the checks run, so no other thread may use the library
+ * meanwhile. It throws an exception when b is not available.
+ */
+double backend_conformance(Backend b, Index n = 64);
+
+/**
+ * @brief Difference from the reference allowed by backend_conforms(), as a
+ * multiple of n times the machine precision.
+ */
+const double CONFORMANCE_TOLERANCE = 8;
+
+/**
+ * @brief Tells whether a backend conforms to the reference.
+ * @param b Backend.
+ * @param n Size of the test matrices.
+ * @return True when backend_conformance(b, n) is at most
+ * CONFORMANCE_TOLERANCE * n * DBL_EPSILON.
+ *
+ * A correct backend stays well below the bound (a few tenths of n times the
+ * machine precision for OpenBLAS); a wrong binding (swapped dimensions or
+ * transpositions, a wrong triangle) differs by order 1. It throws an
+ * exception when b is not available.
+ */
+bool backend_conforms(Backend b, Index n = 64);
+
+// DISPATCH
+// Called by the routines of the library, after their argument checks, with
+// operands of matching sizes (op(A) and op(B) already applied as views for
+// the products). They run the operation on the selected backend and return
+// true, or return false when it is left to the reference kernels: the
+// reference backend is selected or the operands do not suit the system
+// library.
+
+bool backend_gemm(double alpha, MatrixView<const double> a,
+                  MatrixView<const double> b, double beta,
+                  MatrixView<double> c);
+
+bool backend_gemv(double alpha, MatrixView<const double> a,
+                  VectorView<const double> x, double beta,
+                  VectorView<double> y);
+
+bool backend_trsm(Side side, UpLo uplo, Transpose ta, Diag diag, double alpha,
+                  MatrixView<const double> a, MatrixView<double> b);
+
+// throws std::runtime_error when a is singular, as the reference
+bool backend_getrf(MatrixView<double> a, Vector<int>& ipiv);
+
+bool backend_getrs(MatrixView<const double> lu, const Vector<int>& ipiv,
+                   MatrixView<double> b);
+
+bool backend_norm(Norm norm, MatrixView<const double> a, double& res);
+
+#endif /* BACKEND_H */
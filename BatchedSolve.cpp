@@ -0,0 +1,236 @@
+#include "BatchedSolve.h"
+#include "Parallel.h"
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+// The lanes (matrices) handled by a thread are processed in blocks of LANES,
+// so that the matrices of a block (n * n * LANES doubles, 512 kB for 32 x 32)
+// stay in the cache while all the elimination steps run over them.
+static const int LANES = 64;
+
+// Minimum number of lanes given to a thread, smaller batches are not worth
+// starting threads for.
+static const int MIN_LANES_PER_THREAD = 4 * LANES;
+
+// FACTORISATION OF A BLOCK OF LANES
+// Lanes [l0, l0 + w) of the batch, w <= LANES.
+static void fact_block(int n, std::ptrdiff_t batch, double* a, int* piv,
+                       int* info, int l0, int w)
+{
+    int i, j, k, r, c, l;
+    double best[LANES];
+    int bestrow[LANES];
+    double v, tmp;
+
+    a += l0;
+    piv += l0;
+    info += l0;
+
+    for (l = 0; l < w; ++l)
+        info[l] = 0;
+
+    for (k = 0; k < n; ++k)
+    {
+        double* akk = a + (k * n + k) * batch;
+
+        // find the pivot of each lane in rows k, k+1, ..., n-1 of column k
+        for (l = 0; l < w; ++l)
+        {
+            best[l] = fabs(akk[l]);
+            bestrow[l] = k;
+        }
+        for (r = k + 1; r < n; ++r)
+        {
+            const double* ark = a + (r * n + k) * batch;
+            for (l = 0; l < w; ++l)
+            {
+                v = fabs(ark[l]);
+                bestrow[l] = v > best[l] ? r : bestrow[l];
+                best[l] = v > best[l] ? v : best[l];
+            }
+        }
+        for (l = 0; l < w; ++l)
+        {
+            piv[k * batch + l] = bestrow[l];
+            if (best[l] == 0 && info[l] == 0)
+                info[l] = k + 1;  // singular, other lanes are not affected
+        }
+
+        // swap row k with the pivot row, lane by lane
+        for (l = 0; l < w; ++l)
+        {
+            r = bestrow[l];
+            if (r != k)
+                for (c = 0; c < n; ++c)
+                {
+                    tmp = a[(k * n + c) * batch + l];
+                    a[(k * n + c) * batch + l] = a[(r * n + c) * batch + l];
+                    a[(r * n + c) * batch + l] = tmp;
+                }
+        }
+
+        // eliminate the entries below the pivot in all lanes at once
+        for (i = k + 1; i < n; ++i)
+        {
+            double* aik = a + (i * n + k) * batch;
+            for (l = 0; l < w; ++l)
+                aik[l] /= akk[l];                   // entries of L
+            for (j = k + 1; j < n; ++j)
+            {
+                double* aij = a + (i * n + j) * batch;
+                const double* akj = a + (k * n + j) * batch;
+                for (l = 0; l < w; ++l)
+                    aij[l] -= aik[l] * akj[l];      // entries of U
+            }
+        }
+    }
+}
+
+// SOLUTION OF A BLOCK OF LANES
+// Right-hand side element r of lane l is b[r * bs + l], which allows solving
+// for one column of interleaved matrices (bs = n * batch). Offsets are
+// computed in std::ptrdiff_t since n * n * batch may not fit in an int.
+static void solve_block(int n, std::ptrdiff_t batch, const double* lu,
+                        const int* piv, double* b, std::ptrdiff_t bs, int l0,
+                        int w)
+{
+    int i, j, k, r, l;
+    double tmp;
+
+    lu += l0;
+    piv += l0;
+    b += l0;
+
+    // apply the row interchanges
+    for (k = 0; k < n; ++k)
+        for (l = 0; l < w; ++l)
+        {
+            r = piv[k * batch + l];
+            if (r != k)
+            {
+                tmp = b[k * bs + l];
+                b[k * bs + l] = b[r * bs + l];
+                b[r * bs + l] = tmp;
+            }
+        }
+
+    // forward substitution for L y = Pb
+    for (i = 1; i < n; ++i)
+        for (j = 0; j < i; ++j)
+        {
+            const double* lij = lu + (i * n + j) * batch;
+            const double* bj = b + j * bs;
+            double* bi = b + i * bs;
+            for (l = 0; l < w; ++l)
+                bi[l] -= lij[l] * bj[l];
+        }
+
+    // back substitution for U x = y
+    for (i = n - 1; i >= 0; --i)
+    {
+        double* bi = b + i * bs;
+        for (j = i + 1; j < n; ++j)
+        {
+            const double* uij = lu + (i * n + j) * batch;
+            const double* bj = b + j * bs;
+            for (l = 0; l < w; ++l)
+                bi[l] -= uij[l] * bj[l];
+        }
+        const double* uii = lu + (i * n + i) * batch;
+        for (l = 0; l < w; ++l)
+            bi[l] /= uii[l];
+    }
+}
+
+// Runs fn(lo, hi) over lanes [0, batch) split into chunks, one per thread of
+// the library thread pool. Chunk boundaries are multiples of LANES so that
+// threads do not share cache lines.
+template <typename F>
+static void run_chunks(int batch, int nthreads, F fn)
+{
+    int nblocks = (batch + LANES - 1) / LANES;
+    int nch = num_chunks(batch, MIN_LANES_PER_THREAD);
+
+    if (nthreads > 0 && nch > nthreads)
+        nch = nthreads;
+
+    parallel_for(nblocks, nch, [&](int lo, int hi, int) {
+        fn(lo * LANES, hi * LANES < batch ? hi * LANES : batch);
+    });
+}
+
+static void check_sizes(int n, int batch)
+{
+    if (n < 0 || batch < 0)
+        throw std::invalid_argument("batch size negative");
+}
+
+// LU FACTORISATION OF A BATCH
+void batched_lu_fact(int n, int batch, double* a, int* piv, int* info,
+                     int nthreads)
+{
+    check_sizes(n, batch);
+
+    run_chunks(batch, nthreads, [=](int lo, int hi) {
+        for (int l0 = lo; l0 < hi; l0 += LANES)
+            fact_block(n, batch, a, piv, info, l0,
+                       hi - l0 < LANES ? hi - l0 : LANES);
+    });
+}
+
+// SOLUTION OF A FACTORISED BATCH
+void batched_lu_solve(int n, int batch, const double* lu, const int* piv,
+                      double* b, int nthreads)
+{
+    check_sizes(n, batch);
+
+    run_chunks(batch, nthreads, [=](int lo, int hi) {
+        for (int l0 = lo; l0 < hi; l0 += LANES)
+            solve_block(n, batch, lu, piv, b, batch, l0,
+                        hi - l0 < LANES ? hi - l0 : LANES);
+    });
+}
+
+// SOLUTION OF A BATCH
+// Factorisation and solution of a block of lanes run back to back, while the
+// block is still in the cache.
+void batched_solve(int n, int batch, double* a, int* piv, double* b,
+                   int* info, int nthreads)
+{
+    check_sizes(n, batch);
+
+    run_chunks(batch, nthreads, [=](int lo, int hi) {
+        for (int l0 = lo; l0 < hi; l0 += LANES)
+        {
+            int w = hi - l0 < LANES ? hi - l0 : LANES;
+            fact_block(n, batch, a, piv, info, l0, w);
+            solve_block(n, batch, a, piv, b, batch, l0, w);
+        }
+    });
+}
+
+// INVERSE OF A BATCH
+// Column c of the inverse is the solution for the c-th unit vector.
+void batched_inverse(int n, int batch, double* a, int* piv, double* ainv,
+                     int* info, int nthreads)
+{
+    check_sizes(n, batch);
+
+    run_chunks(batch, nthreads, [=](int lo, int hi) {
+        for (int l0 = lo; l0 < hi; l0 += LANES)
+        {
+            int w = hi - l0 < LANES ? hi - l0 : LANES;
+            fact_block(n, batch, a, piv, info, l0, w);
+            for (int c = 0; c < n; ++c)
+            {
+                for (int r = 0; r < n; ++r)
+                    for (int l = 0; l < w; ++l)
+                        ainv[(r * n + c) * (std::ptrdiff_t)batch + l0 + l] =
+                            r == c ? 1.0 : 0.0;
+                solve_block(n, batch, a, piv, ainv + c * (std::ptrdiff_t)batch,
+                            n * (std::ptrdiff_t)batch, l0, w);
+            }
+        }
+    });
+}
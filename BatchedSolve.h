@@ -0,0 +1,75 @@
+/**
+ * @file BatchedSolve.h
+ * @brief Header file containing routines which factorise, solve and invert
+ * many small matrices at once.
+ *
+ * All routines work on an interleaved layout: for a batch of N matrices of
+ * size n, element (r, c) of matrix i is stored at a[(r * n + c) * N + i] and
+ * element r of right-hand side i at b[r * N + i]. The matrices of the batch
+ * are then processed in lockstep, the innermost loops running over i along
+ * contiguous memory, which lets the compiler vectorise them. The batch is
+ * split into chunks processed by the library thread pool (see Parallel.h).
+ *
+ * The routines do not allocate memory for the data, every array is provided
+ * by the caller.
+ */
+#ifndef BATCHED_SOLVE_H
+#define BATCHED_SOLVE_H
+
+/**
+ * @brief LU factorisation with partial pivoting of a batch of matrices.
+ * @param n Size of the matrices.
+ * @param batch Number of matrices N.
+ * @param a Interleaved matrices, overwritten by their factorisations (L below
+ * the diagonal, without its unit diagonal, and U).
+ * @param piv Interleaved pivots, n * N values: row k of matrix i was swapped
+ * with row piv[k * N + i].
+ * @param info N values: 0 on success, k + 1 when the k-th pivot of the matrix
+ * is zero (the factorisation of that matrix is then unusable, the other
+ * matrices are not affected).
+ * @param nthreads Maximum number of threads, 0 means the whole pool.
+ *
+ * It throws an exception when given negative sizes.
+ */
+void batched_lu_fact(int n, int batch, double* a, int* piv, int* info,
+                     int nthreads = 0);
+
+/**
+ * @brief Solves a batch of systems factorised by batched_lu_fact().
+ * @param n Size of the matrices.
+ * @param batch Number of systems N.
+ * @param lu Interleaved factorisations.
+ * @param piv Interleaved pivots.
+ * @param b Interleaved right-hand sides, overwritten by the solutions.
+ * @param nthreads Maximum number of threads, 0 means the whole pool.
+ */
+void batched_lu_solve(int n, int batch, const double* lu, const int* piv,
+                      double* b, int nthreads = 0);
+
+/**
+ * @brief Solves a batch of systems A x = b.
+ * @param n Size of the matrices.
+ * @param batch Number of systems N.
+ * @param a Interleaved matrices, overwritten by their factorisations.
+ * @param piv Workspace for n * N interleaved pivots.
+ * @param b Interleaved right-hand sides, overwritten by the solutions.
+ * @param info N values, see batched_lu_fact().
+ * @param nthreads Maximum number of threads, 0 means the whole pool.
+ */
+void batched_solve(int n, int batch, double* a, int* piv, double* b,
+                   int* info, int nthreads = 0);
+
+/**
+ * @brief Computes the inverses of a batch of matrices.
+ * @param n Size of the matrices.
+ * @param batch Number of matrices N.
+ * @param a Interleaved matrices, overwritten by their factorisations.
+ * @param piv Workspace for n * N interleaved pivots.
+ * @param ainv Interleaved inverse matrices (output, same layout as a).
+ * @param info N values, see batched_lu_fact().
+ * @param nthreads Maximum number of threads, 0 means the whole pool.
+ */
+void batched_inverse(int n, int batch, double* a, int* piv, double* ainv,
+                     int* info, int nthreads = 0);
+
+#endif /* BATCHED_SOLVE_H */
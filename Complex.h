@@ -3,49 +3,75 @@
 
 #include <iostream> //Generic IO operations
 #include <fstream>  //File IO operations
+#include <iomanip>  //showpos of the screen output
+#include <cmath>
 #include <stdexcept> //provides exceptions
+#include <type_traits>
 
 //needed for ofstream output
 //see inside this file for explanation
 #include "ofstream_add.h"
 
-// The complex number class,
-// with some of the functions written inline
+// The complex number class, header-only: every function is inline (and
+// constexpr but for the absolute value and IO), so loops over Vector<Complex>
+// and Matrix<Complex> are compiled with the arithmetic in place and can be
+// vectorised. It has the compiler-generated copy and assignment, hence it is
+// trivially copyable and copied as its two doubles.
 
 /**
- * A test class. A more elaborate class description.
+ * @brief Class meant to represent a complex number of double precision
+ * real and imaginary parts.
  */
 class Complex {
 private:
     double re, im;
+
+    // absolute value usable in constant expressions
+    static constexpr double abs(double x) { return x < 0 ? -x : x; }
+
 public:
 	// CONSTRUCTORS
-    Complex();                    
-	Complex(double re);          
-    Complex(double re, double im);
-    Complex(const Complex& c);
+    constexpr Complex() : re(0.0), im(0.0) {}
+    constexpr Complex(double re) : re(re), im(0.0) {}
+    constexpr Complex(double re, double im) : re(re), im(im) {}
 
 	// GET ACCESSOR METHODS
-	double getReal() const;
-	double getImag() const;
+    constexpr double getReal() const { return re; }
+    constexpr double getImag() const { return im; }
 
 	// SET MUTATOR METHODS
-	Complex& setReal(double re); 
-    Complex& setImag(double im); 
+    constexpr Complex& setReal(double re);
+    constexpr Complex& setImag(double im);
 
 	// OPERATIONS inverse, cojugate and absolute value
-	Complex cinv() const;
-	Complex ccong() const;
-	double cabs() const;
-
-    // OVERLOADED OPERATORS +, *, \, ==, +=, =
-    Complex operator+(const Complex& c) const;
-    Complex operator*(const Complex& c) const;
-	Complex operator/(const Complex& c) const;
-    bool operator==(const Complex& c) const;
-	bool operator!=(const Complex& c) const;
-    Complex& operator+=(const Complex& c);
-    Complex& operator=(const Complex& c); 
+    constexpr Complex cinv() const;
+    constexpr Complex ccong() const { return Complex(re, -im); }
+    double cabs() const { return std::sqrt(re * re + im * im); }
+
+    // OVERLOADED OPERATORS +, -, *, /, ==, !=, +=, -=, *=, /=
+    constexpr Complex operator-() const { return Complex(-re, -im); }
+    constexpr Complex operator+(const Complex& c) const;
+    constexpr Complex operator-(const Complex& c) const;
+    constexpr Complex operator*(const Complex& c) const;
+
+    /**
+     * @brief Quotient of two complex numbers.
+     * @param c Divisor.
+     * @return *this / c.
+     *
+     * Smith's algorithm: the divisor is scaled by its larger part, so
+     * |c|^2 is never formed and does not overflow or underflow when the
+     * parts of c are large or small; one division and three multiplications
+     * fewer than multiplying by cinv().
+     */
+    constexpr Complex operator/(const Complex& c) const;
+
+    constexpr bool operator==(const Complex& c) const;
+    constexpr bool operator!=(const Complex& c) const;
+    constexpr Complex& operator+=(const Complex& c);
+    constexpr Complex& operator-=(const Complex& c);
+    constexpr Complex& operator*=(const Complex& c);
+    constexpr Complex& operator/=(const Complex& c);
 
 	// INPUT AND OUTPUT
     friend std::ostream& operator<<(std::ostream& os, const Complex& c); //screen output
@@ -57,4 +83,140 @@ public:
 	friend std::ifstream& operator>>(std::ifstream& ifs, Complex& c); //file input
 };
 
-#endif
\ No newline at end of file
+static_assert(std::is_trivially_copyable<Complex>::value,
+              "Complex is copied as its two doubles");
+
+// MUTATOR METHODS
+//Setter for Real part
+constexpr Complex& Complex::setReal(double re)
+{
+    this->re = re;
+    return *this;
+}
+
+//Setter for Imaginary part
+constexpr Complex& Complex::setImag(double im)
+{
+    this->im = im;
+    return *this;
+}
+
+// OPERATIONS
+constexpr Complex Complex::cinv() const
+{
+    return Complex(1.0) / *this;
+}
+
+// OVERLOADED OPERATORS
+constexpr Complex Complex::operator+(const Complex& c) const
+{
+    return Complex(re + c.re, im + c.im);
+}
+
+constexpr Complex Complex::operator-(const Complex& c) const
+{
+    return Complex(re - c.re, im - c.im);
+}
+
+constexpr Complex Complex::operator*(const Complex& c) const
+{
+    return Complex(re * c.re - im * c.im, re * c.im + im * c.re);
+}
+
+constexpr Complex Complex::operator/(const Complex& c) const
+{
+    if (abs(c.re) >= abs(c.im))
+    {
+        double r = c.im / c.re, d = c.re + c.im * r;
+        return Complex((re + im * r) / d, (im - re * r) / d);
+    }
+    double r = c.re / c.im, d = c.re * r + c.im;
+    return Complex((re * r + im) / d, (im * r - re) / d);
+}
+
+//Comparison of two Complex numbers
+constexpr bool Complex::operator==(const Complex& c) const
+{
+    return re == c.re && im == c.im;
+}
+
+constexpr bool Complex::operator!=(const Complex& c) const
+{
+    return re != c.re || im != c.im;
+}
+
+// compound assignments, in place
+constexpr Complex& Complex::operator+=(const Complex& c)
+{
+    re += c.re;
+    im += c.im;
+    return *this;
+}
+
+constexpr Complex& Complex::operator-=(const Complex& c)
+{
+    re -= c.re;
+    im -= c.im;
+    return *this;
+}
+
+constexpr Complex& Complex::operator*=(const Complex& c)
+{
+    return *this = *this * c;
+}
+
+constexpr Complex& Complex::operator/=(const Complex& c)
+{
+    return *this = *this / c;
+}
+
+// INPUT AND OUTPUT
+//screen output
+inline std::ostream& operator<<(std::ostream& os, const Complex& c)
+{
+    os << c.re << std::setiosflags(std::ios::showpos) << c.im << "i"
+       << std::resetiosflags(std::ios::showpos);
+    return os;
+}
+
+//keyboard input
+inline std::istream& operator>>(std::istream& is, Complex& c)
+{
+    double re, im;
+    std::cout << "Input real-part:\t";
+    while (!(is >> re))
+    {
+        std::cout << "Please give me a double!  Try again: ";
+        is.clear();
+        is.ignore(1000, '\n');
+    }
+    std::cout << "Input imaginary-part:\t";
+    while (!(is >> im))
+    {
+        std::cout << "Please give me a double!  Try again: ";
+        is.clear();
+        is.ignore(1000, '\n');
+    }
+    c = Complex(re, im);
+    return is;
+}
+
+//file output
+inline std::ofstream& operator<<(std::ofstream& ofs, const Complex& c)
+{
+    ofs << c.re << " ";
+    ofs << c.im << std::endl;
+    return ofs;
+}
+
+//file input, the parts as written by the file output
+inline std::ifstream& operator>>(std::ifstream& ifs, Complex& c)
+{
+    double re, im;
+    ifs >> re;
+    ifs >> im;
+    c = Complex(re, im);
+    return ifs;
+}
+
+#endif
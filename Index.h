@@ -0,0 +1,37 @@
+/**
+ * @file Index.h
+ * @brief Header file containing the type of the sizes, indices and strides
+ * used throughout the library.
+ */
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <cstddef>
+#include <climits>
+#include <cstdint>
+
+/**
+ * @brief Signed integer type of sizes, indices and strides.
+ *
+ * It is 64 bits wide on 64-bit platforms, so the number of elements of a
+ * matrix (nrows * ncols) and the offsets into its storage do not overflow
+ * beyond 2^31 - 1 elements (a 46341 x 46341 matrix already has more). It is
+ * signed since strides and loop counters running down may be negative.
+ */
+typedef std::ptrdiff_t Index;
+
+/**
+ * @brief Tells whether a value can be held by an int.
+ * @param n Value.
+ * @return True when INT_MIN <= n <= INT_MAX.
+ *
+ * Kernels use it to select a variant with 32-bit index arithmetic, whose
+ * address computations are cheaper and vectorise better, when all the
+ * offsets they compute are small enough.
+ */
+inline bool fits_int(Index n)
+{
+    return n >= INT_MIN && n <= INT_MAX;
+}
+
+#endif /* INDEX_H */
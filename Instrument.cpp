@@ -0,0 +1,123 @@
+#include "Instrument.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+// counters of one thread; only that thread writes them, other threads read
+// them for snapshots, hence atomics with relaxed ordering
+struct ThreadCounters {
+    std::atomic<long long> value[NUM_COUNTERS];
+
+    ThreadCounters();
+    ~ThreadCounters();
+};
+
+// every live block of counters, the counts of the finished threads and the
+// totals at the last reset; allocated once and never freed, so it outlives
+// the blocks of threads finishing during program exit
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    long long finished[NUM_COUNTERS];
+    long long base[NUM_COUNTERS];
+};
+
+static Registry& registry()
+{
+    static Registry* r = new Registry();
+    return *r;
+}
+
+static thread_local ThreadCounters local_counters;
+
+ThreadCounters::ThreadCounters()
+{
+    for (int c = 0; c < NUM_COUNTERS; ++c)
+        value[c].store(0, std::memory_order_relaxed);
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters()
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    for (int c = 0; c < NUM_COUNTERS; ++c)
+        r.finished[c] += value[c].load(std::memory_order_relaxed);
+    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+}
+
+// NAMES
+static const char* const names[NUM_COUNTERS] = {
+    "allocations",
+    "bytes_allocated",
+    "bytes_copied",
+    "flops_gemm",
+    "flops_gemv",
+    "flops_lu_fact",
+    "flops_reorder",
+    "flops_lu_solve",
+    "flops_inverse",
+    "flops_vector",
+    "calls_gemm",
+    "calls_gemv",
+    "calls_lu_fact",
+    "calls_reorder",
+    "calls_lu_solve",
+    "calls_multiply",
+    "calls_multiply_vector",
+    "calls_inverse"
+};
+
+const char* counter_name(Counter c)
+{
+    return c >= 0 && c < NUM_COUNTERS ? names[c] : "unknown";
+}
+
+// COUNTING
+void counter_add(Counter c, long long amount)
+{
+    // a plain load and store: the calling thread is the only writer
+    std::atomic<long long>& v = local_counters.value[c];
+    v.store(v.load(std::memory_order_relaxed) + amount,
+            std::memory_order_relaxed);
+}
+
+// totals since the start of the program, the caller holds the mutex
+static void totals(Registry& r, long long* t)
+{
+    int c;
+
+    for (c = 0; c < NUM_COUNTERS; ++c)
+        t[c] = r.finished[c];
+    for (size_t i = 0; i < r.threads.size(); ++i)
+        for (c = 0; c < NUM_COUNTERS; ++c)
+            t[c] += r.threads[i]->value[c].load(std::memory_order_relaxed);
+}
+
+// SNAPSHOT AND RESET
+// Resetting only records the totals, which later snapshots subtract: the
+// blocks of the threads are never written by another thread.
+CounterSnapshot counter_snapshot()
+{
+    CounterSnapshot s;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    totals(r, s.value);
+    for (int c = 0; c < NUM_COUNTERS; ++c)
+        s.value[c] -= r.base[c];
+    return s;
+}
+
+void counter_reset()
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    totals(r, r.base);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file Instrument.h
+ * @brief Header file containing the instrumentation counters of the library.
+ *
+ * The library counts its allocations, the bytes it allocates and copies, the
+ * flops of its kernels and the calls of its main routines. The counting hooks
+ * (MATH_COUNT()) are compiled in only when MATH_INSTRUMENT is defined, for the
+ * library and the program alike; otherwise they expand to nothing, cost
+ * nothing, and every counter stays zero.
+ *
+ * Every thread counts into its own block of counters, written by that thread
+ * only, so a hook takes no lock and no atomic read-modify-write. The blocks
+ * are summed when a snapshot is taken.
+ */
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+/**
+ * @brief Instrumentation counters.
+ */
+enum Counter {
+    ALLOCATIONS,        ///< Memory allocations of Vector and Matrix.
+    BYTES_ALLOCATED,    ///< Bytes allocated by Vector and Matrix.
+    BYTES_COPIED,       ///< Bytes copied by Vector copies and copy().
+    FLOPS_GEMM,         ///< Flops of gemm().
+    FLOPS_GEMV,         ///< Flops of gemv().
+    FLOPS_LU_FACT,      ///< Flops of lu_fact() and lu_fact_inplace().
+    FLOPS_REORDER,      ///< Flops of reorder().
+    FLOPS_LU_SOLVE,     ///< Flops of lu_solve().
+    FLOPS_INVERSE,      ///< Flops of inverse_inplace(), its LU aside.
+    FLOPS_VECTOR,       ///< Flops of the vector routines (dot(), axpy(), ...).
+    CALLS_GEMM,         ///< Calls of gemm().
+    CALLS_GEMV,         ///< Calls of gemv().
+    CALLS_LU_FACT,      ///< Calls of lu_fact() and lu_fact_inplace().
+    CALLS_REORDER,      ///< Calls of reorder().
+    CALLS_LU_SOLVE,     ///< Calls of lu_solve().
+    CALLS_MULTIPLY,     ///< Matrix by matrix multiplications.
+    CALLS_MULTIPLY_VECTOR,  ///< Matrix by vector multiplications.
+    CALLS_INVERSE,      ///< Calls of inverse_inplace().
+    NUM_COUNTERS        ///< Number of counters.
+};
+
+/**
+ * @brief Values of all counters at some moment.
+ */
+struct CounterSnapshot {
+    long long value[NUM_COUNTERS];  ///< Value of every counter.
+
+    /**
+     * @brief Value of a counter.
+     * @param c Counter.
+     * @return Value of the counter.
+     */
+    long long operator[](Counter c) const { return value[c]; }
+};
+
+/**
+ * @brief Tells whether the counting hooks are compiled in.
+ * @return True when MATH_INSTRUMENT is defined.
+ */
+inline bool instrument_enabled()
+{
+#ifdef MATH_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Name of a counter, e.g. "flops_gemm".
+ * @param c Counter.
+ * @return Name of the counter, usable as a metric name.
+ */
+const char* counter_name(Counter c);
+
+/**
+ * @brief Adds to a counter of the calling thread.
+ * @param c Counter.
+ * @param amount Amount added.
+ *
+ * Meant to be called through MATH_COUNT(), so the call is compiled out when
+ * instrumentation is disabled.
+ */
+void counter_add(Counter c, long long amount);
+
+/**
+ * @brief Takes a snapshot of the counters.
+ * @return Sum of the counters of all threads, including the threads which
+ * have finished, since the last counter_reset().
+ *
+ * It may be called at any moment from any thread; counts made concurrently
+ * by other threads may or may not be included.
+ */
+CounterSnapshot counter_snapshot();
+
+/**
+ * @brief Resets all counters to zero.
+ */
+void counter_reset();
+
+/**
+ * @brief Counting hook, adds amount to counter c of the calling thread.
+ *
+ * Expands to nothing unless MATH_INSTRUMENT is defined, so amount must not
+ * have side effects.
+ */
+#ifdef MATH_INSTRUMENT
+#define MATH_COUNT(c, amount) counter_add(c, (long long)(amount))
+#else
+#define MATH_COUNT(c, amount) ((void)0)
+#endif
+
+#endif /* INSTRUMENT_H */
@@ -0,0 +1,389 @@
+#include "Krylov.h"
+#include "MathBlas.h"
+#include "Trace.h"
+#include <cmath>
+#include <stdexcept>
+
+// OPERATORS
+LinearOperator::~LinearOperator() {}
+
+MatrixOperator::MatrixOperator(const MathMatrix& a) : a(a) {}
+
+Index MatrixOperator::size() const
+{
+    return a.get_size();
+}
+
+void MatrixOperator::apply(const MathVector& x, MathVector& y) const
+{
+    a.multiply(x, y);
+}
+
+CallbackOperator::CallbackOperator(Index n, const Apply& f) : n(n), f(f)
+{
+    if (n < 0)
+        throw std::invalid_argument("operator size negative");
+}
+
+Index CallbackOperator::size() const
+{
+    return n;
+}
+
+void CallbackOperator::apply(const MathVector& x, MathVector& y) const
+{
+    f(x, y);
+}
+
+// PRECONDITIONERS
+Preconditioner::~Preconditioner() {}
+
+JacobiPreconditioner::JacobiPreconditioner(const MathMatrix& a)
+    : inv_diag(a.get_size())
+{
+    for (Index i = 0; i < a.get_size(); ++i)
+    {
+        if (a(i, i) == 0)
+            throw std::invalid_argument("zero on the diagonal");
+        inv_diag[i] = 1 / a(i, i);
+    }
+}
+
+void JacobiPreconditioner::apply(const MathVector& r, MathVector& z) const
+{
+    const double* pr = r.data();
+    const double* pd = inv_diag.data();
+    double* pz = z.data();
+
+    if (r.size() != inv_diag.size() || z.size() != inv_diag.size())
+        throw std::invalid_argument("incompatible vector sizes");
+
+    for (Index i = 0; i < r.size(); ++i)
+        pz[i] = pd[i] * pr[i];
+}
+
+// SETTINGS
+IterativeSolver::IterativeSolver() : tol(1e-10), max_iter(1000) {}
+
+void IterativeSolver::set_tolerance(double t)
+{
+    if (t < 0)
+        throw std::invalid_argument("tolerance negative");
+    tol = t;
+}
+
+void IterativeSolver::set_max_iterations(int n)
+{
+    if (n < 0)
+        throw std::invalid_argument("maximum number of iterations negative");
+    max_iter = n;
+}
+
+double IterativeSolver::get_tolerance() const
+{
+    return tol;
+}
+
+int IterativeSolver::get_max_iterations() const
+{
+    return max_iter;
+}
+
+// HELPERS
+// make v a vector of size n, reallocating only when its size differs
+static void fit(MathVector& v, Index n)
+{
+    if (v.size() != n)
+        v = MathVector(n);
+}
+
+// checks the sizes and prepares x; returns |b|
+static double prepare(const LinearOperator& a, const MathVector& b,
+                      MathVector& x)
+{
+    if (b.size() != a.size())
+        throw std::invalid_argument("incompatible matrix and vector sizes");
+
+    if (x.size() != a.size())
+        x = MathVector(a.size());  // zero initial guess
+
+    return nrm2(b);
+}
+
+// r = b - A x
+static void residual(const LinearOperator& a, const MathVector& b,
+                     const MathVector& x, MathVector& r)
+{
+    a.apply(x, r);
+    axpby(1.0, b, -1.0, r);
+}
+
+// z = M^-1 r, or a copy of r without a preconditioner
+static void precondition(const Preconditioner* m, const MathVector& r,
+                         MathVector& z)
+{
+    if (m)
+        m->apply(r, z);
+    else
+        copy(r, z);
+}
+
+// outcome of a solve
+static SolverResult result(bool converged, int iterations, double rnorm,
+                           double bnorm)
+{
+    SolverResult res;
+
+    res.converged = converged;
+    res.iterations = iterations;
+    res.residual = bnorm > 0 ? rnorm / bnorm : rnorm;
+    return res;
+}
+
+// CONJUGATE GRADIENT
+SolverResult ConjugateGradient::solve(const LinearOperator& a,
+                                      const MathVector& b, MathVector& x,
+                                      const Preconditioner* m)
+{
+    MATH_TRACE_SCOPE("conjugate gradient");
+
+    Index n = a.size();
+    int k;
+    double bnorm = prepare(a, b, x);
+    double rnorm, rz, rz_new, alpha, pq;
+
+    fit(r, n);
+    fit(z, n);
+    fit(p, n);
+    fit(q, n);
+
+    if (bnorm == 0)
+    {
+        // the solution is zero
+        scal(0.0, x);
+        return result(true, 0, 0, 0);
+    }
+
+    residual(a, b, x, r);
+    rnorm = nrm2(r);
+    precondition(m, r, z);
+    copy(z, p);
+    rz = dot(r, z);
+
+    for (k = 0; k < max_iter && rnorm > tol * bnorm; ++k)
+    {
+        a.apply(p, q);
+        pq = dot(p, q);
+        if (pq == 0)
+            break;  // A is not positive definite
+
+        alpha = rz / pq;
+        axpy(alpha, p, x);
+        axpy(-alpha, q, r);
+        rnorm = nrm2(r);
+
+        precondition(m, r, z);
+        rz_new = dot(r, z);
+        axpby(1.0, z, rz_new / rz, p);  // p = z + beta p
+        rz = rz_new;
+    }
+
+    return result(rnorm <= tol * bnorm, k, rnorm, bnorm);
+}
+
+// GMRES
+GMRES::GMRES(int restart)
+    : m(restart), h(), cs(restart), sn(restart), g(restart + 1)
+{
+    if (restart <= 0)
+        throw std::invalid_argument("restart length not positive");
+    h = Matrix<double>(m + 1, m);
+}
+
+int GMRES::restart() const
+{
+    return m;
+}
+
+SolverResult GMRES::solve(const LinearOperator& a, const MathVector& b,
+                          MathVector& x, const Preconditioner* pc)
+{
+    MATH_TRACE_SCOPE("gmres");
+
+    Index n = a.size();
+    int i, j, k = 0;
+    double bnorm = prepare(a, b, x);
+    double rnorm, beta, tmp, rad, wnorm;
+
+    v.resize(m + 1);
+    for (i = 0; i <= m; ++i)
+        fit(v[i], n);
+    fit(r, n);
+    fit(w, n);
+    fit(z, n);
+
+    if (bnorm == 0)
+    {
+        scal(0.0, x);
+        return result(true, 0, 0, 0);
+    }
+
+    residual(a, b, x, r);
+    rnorm = nrm2(r);
+
+    while (k < max_iter && rnorm > tol * bnorm)
+    {
+        // v0 = r / |r|, g = |r| e1
+        beta = rnorm;
+        copy(r, v[0]);
+        scal(1 / beta, v[0]);
+        g[0] = beta;
+
+        for (j = 0; j < m && k < max_iter; )
+        {
+            ++k;
+
+            // w = A M^-1 v_j, orthogonalised against the basis
+            precondition(pc, v[j], z);
+            a.apply(z, w);
+            for (i = 0; i <= j; ++i)
+            {
+                h(i, j) = dot(w, v[i]);
+                axpy(-h(i, j), v[i], w);
+            }
+            wnorm = nrm2(w);
+            h(j + 1, j) = wnorm;
+
+            // apply the previous rotations to the new column of H
+            for (i = 0; i < j; ++i)
+            {
+                tmp = cs[i] * h(i, j) + sn[i] * h(i + 1, j);
+                h(i + 1, j) = -sn[i] * h(i, j) + cs[i] * h(i + 1, j);
+                h(i, j) = tmp;
+            }
+
+            // new rotation zeroing h(j + 1, j)
+            rad = hypot(h(j, j), wnorm);
+            if (rad == 0)
+                break;  // the new column vanishes: A is singular
+            cs[j] = h(j, j) / rad;
+            sn[j] = wnorm / rad;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+            h(j, j) = rad;
+            h(j + 1, j) = 0;
+            ++j;
+
+            // |g_j| is the norm of the residual; when w vanishes the Krylov
+            // space is invariant and the solution exact
+            if (fabs(g[j]) <= tol * bnorm || wnorm == 0)
+                break;
+            copy(w, v[j]);
+            scal(1 / wnorm, v[j]);
+        }
+
+        if (j == 0)
+            break;  // no progress possible
+
+        // y = H^-1 g by back substitution (in g), then x += M^-1 V y
+        for (i = j - 1; i >= 0; --i)
+        {
+            for (int l = i + 1; l < j; ++l)
+                g[i] -= h(i, l) * g[l];
+            g[i] /= h(i, i);
+        }
+        scal(0.0, w);
+        for (i = 0; i < j; ++i)
+            axpy(g[i], v[i], w);
+        precondition(pc, w, z);
+        axpy(1.0, z, x);
+
+        // the true residual, for the restart and the convergence test
+        residual(a, b, x, r);
+        rnorm = nrm2(r);
+    }
+
+    return result(rnorm <= tol * bnorm, k, rnorm, bnorm);
+}
+
+// BICGSTAB
+SolverResult BiCGSTAB::solve(const LinearOperator& a, const MathVector& b,
+                             MathVector& x, const Preconditioner* m)
+{
+    MATH_TRACE_SCOPE("bicgstab");
+
+    Index n = a.size();
+    int k;
+    double bnorm = prepare(a, b, x);
+    double rnorm, rho = 1, rho_new, alpha = 1, omega = 1, r0v, tt;
+
+    fit(r, n);
+    fit(r0, n);
+    fit(p, n);
+    fit(v, n);
+    fit(s, n);
+    fit(t, n);
+    fit(ph, n);
+    fit(sh, n);
+
+    if (bnorm == 0)
+    {
+        scal(0.0, x);
+        return result(true, 0, 0, 0);
+    }
+
+    residual(a, b, x, r);
+    rnorm = nrm2(r);
+    copy(r, r0);  // shadow residual
+    scal(0.0, p);
+    scal(0.0, v);
+
+    for (k = 0; k < max_iter && rnorm > tol * bnorm; )
+    {
+        rho_new = dot(r0, r);
+        if (rho_new == 0)
+            break;  // breakdown
+
+        // p = r + beta (p - omega v)
+        axpy(-omega, v, p);
+        axpby(1.0, r, rho_new / rho * (alpha / omega), p);
+        rho = rho_new;
+
+        precondition(m, p, ph);
+        a.apply(ph, v);
+        ++k;
+        r0v = dot(r0, v);
+        if (r0v == 0)
+            break;  // breakdown
+        alpha = rho / r0v;
+
+        // s = r - alpha v
+        copy(r, s);
+        axpy(-alpha, v, s);
+        if (nrm2(s) <= tol * bnorm || k == max_iter)
+        {
+            axpy(alpha, ph, x);
+            copy(s, r);
+            rnorm = nrm2(r);
+            break;
+        }
+
+        precondition(m, s, sh);
+        a.apply(sh, t);
+        ++k;
+        tt = dot(t, t);
+        omega = tt > 0 ? dot(t, s) / tt : 0;
+
+        // x += alpha M^-1 p + omega M^-1 s, r = s - omega t
+        axpy(alpha, ph, x);
+        axpy(omega, sh, x);
+        copy(s, r);
+        axpy(-omega, t, r);
+        rnorm = nrm2(r);
+
+        if (omega == 0)
+            break;  // breakdown
+    }
+
+    return result(rnorm <= tol * bnorm, k, rnorm, bnorm);
+}
@@ -0,0 +1,286 @@
+/**
+ * @file Krylov.h
+ * @brief Header file containing the Krylov iterative solvers (conjugate
+ * gradient, restarted GMRES and BiCGSTAB) and the linear operator and
+ * preconditioner interfaces they are written against.
+ *
+ * The solvers only need the product of the matrix by a vector, supplied by a
+ * LinearOperator: a dense MathMatrix (MatrixOperator) or any user routine
+ * (CallbackOperator). A solver object keeps its work vectors, so solving
+ * many systems of the same size with one object allocates no memory after
+ * the first solve.
+ */
+#ifndef KRYLOV_H
+#define KRYLOV_H
+
+#include <functional>
+#include <vector>
+#include "MathMatrix.h"
+
+/**
+ * @brief Class meant to represent a square linear operator, x -> A x.
+ */
+class LinearOperator {
+public:
+    /**
+     * @brief Virtual destructor.
+     */
+    virtual ~LinearOperator();
+
+    /**
+     * @brief Size of the operator.
+     * @return Number of rows (and columns) of A.
+     */
+    virtual Index size() const = 0;
+
+    /**
+     * @brief Applies the operator, y = A x.
+     * @param x Vector of size size().
+     * @param y Reference to MathVector for storing the result, of size
+     * size(); x and y are never the same vector.
+     */
+    virtual void apply(const MathVector& x, MathVector& y) const = 0;
+};
+
+/**
+ * @brief Class meant to represent the linear operator of a dense matrix.
+ *
+ * It refers to the matrix, which has to outlive it.
+ */
+class MatrixOperator : public LinearOperator {
+private:
+    const MathMatrix& a;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param a Matrix of the operator.
+     */
+    explicit MatrixOperator(const MathMatrix& a);
+
+    Index size() const;
+    void apply(const MathVector& x, MathVector& y) const;
+};
+
+/**
+ * @brief Class meant to represent a linear operator given by a routine, e.g.
+ * a matrix-free product.
+ */
+class CallbackOperator : public LinearOperator {
+public:
+    /**
+     * @brief Type of the routine computing y = A x.
+     */
+    typedef std::function<void(const MathVector& x, MathVector& y)> Apply;
+
+private:
+    Index n;
+    Apply f;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param n Size of the operator.
+     * @param f Routine computing y = A x, y being of size n already.
+     *
+     * It throws an exception when n is negative.
+     */
+    CallbackOperator(Index n, const Apply& f);
+
+    Index size() const;
+    void apply(const MathVector& x, MathVector& y) const;
+};
+
+/**
+ * @brief Class meant to represent a preconditioner, r -> M^-1 r, M
+ * approximating A.
+ */
+class Preconditioner {
+public:
+    /**
+     * @brief Virtual destructor.
+     */
+    virtual ~Preconditioner();
+
+    /**
+     * @brief Applies the preconditioner, z = M^-1 r.
+     * @param r Vector r.
+     * @param z Reference to MathVector for storing the result, of the size
+     * of r; r and z are never the same vector.
+     */
+    virtual void apply(const MathVector& r, MathVector& z) const = 0;
+};
+
+/**
+ * @brief Class meant to represent the Jacobi (diagonal) preconditioner,
+ * M = diag(A).
+ */
+class JacobiPreconditioner : public Preconditioner {
+private:
+    MathVector inv_diag;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param a Matrix whose diagonal is taken.
+     *
+     * It throws an exception when an element of the diagonal is zero.
+     */
+    explicit JacobiPreconditioner(const MathMatrix& a);
+
+    void apply(const MathVector& r, MathVector& z) const;
+};
+
+/**
+ * @brief Outcome of an iterative solve.
+ */
+struct SolverResult {
+    bool converged;   ///< The tolerance was reached.
+    int iterations;   ///< Number of iterations (products by A) done.
+    double residual;  ///< Relative residual |b - A x| / |b| on return.
+};
+
+/**
+ * @brief Class meant to represent the settings common to the iterative
+ * solvers.
+ *
+ * A solve stops when the relative residual |b - A x| / |b| (Euclidean
+ * norms) is at most the tolerance, or after the maximum number of
+ * iterations.
+ */
+class IterativeSolver {
+protected:
+    double tol;
+    int max_iter;
+
+    IterativeSolver();
+
+public:
+    /**
+     * @brief Sets the tolerance on the relative residual (default 1e-10).
+     * @param t Tolerance.
+     *
+     * It throws an exception when t is negative.
+     */
+    void set_tolerance(double t);
+
+    /**
+     * @brief Sets the maximum number of iterations (default 1000).
+     * @param n Maximum number of iterations.
+     *
+     * It throws an exception when n is negative.
+     */
+    void set_max_iterations(int n);
+
+    /**
+     * @brief Get the tolerance.
+     * @return Tolerance on the relative residual.
+     */
+    double get_tolerance() const;
+
+    /**
+     * @brief Get the maximum number of iterations.
+     * @return Maximum number of iterations.
+     */
+    int get_max_iterations() const;
+};
+
+/**
+ * @brief Class meant to represent the (preconditioned) conjugate gradient
+ * solver, for symmetric positive definite A (and M).
+ */
+class ConjugateGradient : public IterativeSolver {
+private:
+    MathVector r, z, p, q;  // work vectors
+
+public:
+    /**
+     * @brief Solves A x = b.
+     * @param a Operator A.
+     * @param b Right-hand side b.
+     * @param x Initial guess, overwritten by the solution; when its size
+     * differs from that of A the guess is zero.
+     * @param m Preconditioner, or null for none.
+     * @return Outcome of the solve.
+     *
+     * It throws an exception when the size of b differs from that of A.
+     */
+    SolverResult solve(const LinearOperator& a, const MathVector& b,
+                       MathVector& x, const Preconditioner* m = 0);
+};
+
+/**
+ * @brief Class meant to represent the restarted GMRES(m) solver, for any
+ * nonsingular A.
+ *
+ * The Krylov basis is built by modified Gram-Schmidt and the least-squares
+ * problem is solved with Givens rotations; the basis is restarted every
+ * restart() iterations. Preconditioning is from the right, so the
+ * residual monitored is the true one.
+ */
+class GMRES : public IterativeSolver {
+private:
+    int m;
+    std::vector<MathVector> v;      // Krylov basis
+    Matrix<double> h;               // Hessenberg matrix, (m + 1) x m
+    std::vector<double> cs, sn, g;  // rotations and rotated right-hand side
+    MathVector r, w, z;             // work vectors
+
+public:
+    /**
+     * @brief Constructor.
+     * @param restart Number of iterations between restarts (default 30).
+     *
+     * It throws an exception when restart is not positive.
+     */
+    explicit GMRES(int restart = 30);
+
+    /**
+     * @brief Get the number of iterations between restarts.
+     * @return Restart length.
+     */
+    int restart() const;
+
+    /**
+     * @brief Solves A x = b.
+     * @param a Operator A.
+     * @param b Right-hand side b.
+     * @param x Initial guess, overwritten by the solution; when its size
+     * differs from that of A the guess is zero.
+     * @param pc Preconditioner, or null for none.
+     * @return Outcome of the solve.
+     *
+     * It throws an exception when the size of b differs from that of A.
+     */
+    SolverResult solve(const LinearOperator& a, const MathVector& b,
+                       MathVector& x, const Preconditioner* pc = 0);
+};
+
+/**
+ * @brief Class meant to represent the (right preconditioned) BiCGSTAB
+ * solver, for any nonsingular A.
+ *
+ * The solve stops without converging when the method breaks down (a zero
+ * inner product), which is rare but possible.
+ */
+class BiCGSTAB : public IterativeSolver {
+private:
+    MathVector r, r0, p, v, s, t, ph, sh;  // work vectors
+
+public:
+    /**
+     * @brief Solves A x = b.
+     * @param a Operator A.
+     * @param b Right-hand side b.
+     * @param x Initial guess, overwritten by the solution; when its size
+     * differs from that of A the guess is zero.
+     * @param m Preconditioner, or null for none.
+     * @return Outcome of the solve.
+     *
+     * It throws an exception when the size of b differs from that of A.
+     */
+    SolverResult solve(const LinearOperator& a, const MathVector& b,
+                       MathVector& x, const Preconditioner* m = 0);
+};
+
+#endif /* KRYLOV_H */
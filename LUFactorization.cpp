@@ -0,0 +1,443 @@
+#include "LUFactorization.h"
+#include "MathBlas.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#define LU_MAPPED_FILES
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Rows hashed together by matrix_checksum(), fixed so that the checksum does
+// not depend on the number of threads.
+static const Index CHECKSUM_ROWS = 64;
+
+// FILE FORMAT
+// header, scale factors (n doubles), pivots (n 32-bit ints) and factors
+// (n x n doubles, row-major), each section starting at a multiple of
+// SECTION_ALIGN bytes, the factors at a multiple of FACTORS_ALIGN (a page)
+static const char MAGIC[8] = {'M', 'A', 'T', 'H', 'L', 'U', '\r', '\n'};
+static const uint32_t VERSION = 1;
+static const uint32_t ENDIAN_MARK = 0x01020304;
+static const int64_t SECTION_ALIGN = 64;
+static const int64_t FACTORS_ALIGN = 4096;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;    // ENDIAN_MARK as written by the saving machine
+    int64_t n;
+    uint64_t checksum;      // of the factorised matrix
+    int64_t scale_offset;   // offsets of the sections in bytes
+    int64_t pivots_offset;
+    int64_t factors_offset;
+    int64_t file_size;
+};
+
+static int64_t align(int64_t offset, int64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// header of a factorisation of size n
+static FileHeader make_header(Index n, uint64_t checksum)
+{
+    FileHeader h;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.byte_order = ENDIAN_MARK;
+    h.n = n;
+    h.checksum = checksum;
+    h.scale_offset = align(sizeof(FileHeader), SECTION_ALIGN);
+    h.pivots_offset = align(h.scale_offset + n * sizeof(double), SECTION_ALIGN);
+    h.factors_offset = align(h.pivots_offset + n * sizeof(int32_t),
+                             FACTORS_ALIGN);
+    h.file_size = h.factors_offset + n * n * (int64_t)sizeof(double);
+    return h;
+}
+
+// checks a header read from a file of the given size
+static void check_header(const FileHeader& h, int64_t size, uint64_t sum)
+{
+    if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("not an LU factorisation file");
+    if (h.byte_order != ENDIAN_MARK)
+        throw std::runtime_error("LU factorisation file of other byte order");
+    if (h.version != VERSION)
+        throw std::runtime_error("LU factorisation file of other version");
+    // the pivots are int32 and the file size, n^2 doubles past the scale
+    // factors, pivots and padding, must fit int64_t before make_header()
+    if (h.n < 0 || h.n > INT32_MAX ||
+        h.n * h.n > (INT64_MAX - 16 * h.n - 2 * FACTORS_ALIGN) /
+                        (int64_t)sizeof(double))
+        throw std::runtime_error("LU factorisation file corrupt");
+
+    FileHeader expected = make_header(h.n, h.checksum);
+    if (h.scale_offset != expected.scale_offset ||
+        h.pivots_offset != expected.pivots_offset ||
+        h.factors_offset != expected.factors_offset ||
+        h.file_size != expected.file_size)
+        throw std::runtime_error("LU factorisation file corrupt");
+    if (size < h.file_size)
+        throw std::runtime_error("LU factorisation file truncated");
+    if (h.checksum != sum)
+        throw std::runtime_error("LU factorisation of another matrix");
+}
+
+// reads the scale factors and pivots of a checked header; false when the
+// pivots are not valid
+static bool read_sections(const char* base, const FileHeader& h,
+                          MathVector& r, Vector<int>& piv)
+{
+    Index m = h.n;
+    int32_t k;
+    bool valid = true;
+
+    r = MathVector(m);
+    piv = Vector<int>(m);
+    memcpy(r.data(), base + h.scale_offset, m * sizeof(double));
+    for (Index i = 0; i < m; ++i)
+    {
+        memcpy(&k, base + h.pivots_offset + i * sizeof(int32_t), sizeof(k));
+        valid = valid && k >= i && k < m;
+        piv[i] = k;
+    }
+    return valid;
+}
+
+// CHECKSUM
+// FNV-1a over 64-bit words, then a final mix (as splitmix64) so that every
+// bit of the result depends on every bit of the input
+static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+static uint64_t hash_word(uint64_t h, uint64_t w)
+{
+    return (h ^ w) * FNV_PRIME;
+}
+
+static uint64_t finalize(uint64_t h)
+{
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+uint64_t matrix_checksum(const MathMatrix& a)
+{
+    Index n = a.get_size();
+    Index nblocks = (n + CHECKSUM_ROWS - 1) / CHECKSUM_ROWS;
+    std::vector<uint64_t> blocks(nblocks);
+    const double* p = a.data();
+
+    parallel_for(nblocks, num_chunks(nblocks, 1),
+                 [&](Index lo, Index hi, int) {
+        for (Index k = lo; k < hi; ++k)
+        {
+            Index end = std::min((k + 1) * CHECKSUM_ROWS, n) * n;
+            uint64_t h = FNV_OFFSET, w;
+            for (Index i = k * CHECKSUM_ROWS * n; i < end; ++i)
+            {
+                memcpy(&w, p + i, sizeof(w));
+                h = hash_word(h, w);
+            }
+            blocks[k] = h;
+        }
+    });
+
+    uint64_t h = hash_word(FNV_OFFSET, (uint64_t)n);
+    for (Index k = 0; k < nblocks; ++k)
+        h = hash_word(h, blocks[k]);
+    return finalize(h);
+}
+
+// CONSTRUCTORS AND DESTRUCTOR
+LUFactorization::LUFactorization()
+    : n(0), checksum(0), factors(0), map(0), map_size(0)
+{}
+
+LUFactorization::LUFactorization(const MathMatrix& a)
+    : n(0), checksum(0), factors(0), map(0), map_size(0)
+{
+    factor(a);
+}
+
+LUFactorization::~LUFactorization()
+{
+    unmap();
+}
+
+void LUFactorization::unmap()
+{
+#ifdef LU_MAPPED_FILES
+    if (map)
+        munmap(map, map_size);
+#endif
+    map = 0;
+    map_size = 0;
+    shared.release();
+}
+
+// FACTORISATION
+void LUFactorization::factor(const MathMatrix& a)
+{
+    Index m = a.get_size();
+    MathMatrix f(a);
+    MathVector r(m);
+    Vector<int> piv;
+    int e;
+
+    // R_ii = 2^-e for the largest element of row i in [2^(e-1), 2^e)
+    for (Index i = 0; i < m; ++i)
+    {
+        double big = 0;
+        for (Index j = 0; j < m; ++j)
+            big = std::max(big, fabs(f(i, j)));
+        r[i] = 1;
+        if (big > 0 && std::isfinite(big))
+        {
+            frexp(big, &e);
+            r[i] = ldexp(1.0, -e);
+        }
+        scal(r[i], row(f, i));
+    }
+
+    lu_fact_pivoted(view(f), piv);
+
+    unmap();
+    n = m;
+    lu = std::move(f);
+    ipiv.swap(piv);
+    scale.swap(r);
+    checksum = matrix_checksum(a);
+    factors = lu.data();
+}
+
+// ACCESSORS
+Index LUFactorization::get_size() const
+{
+    return n;
+}
+
+uint64_t LUFactorization::get_checksum() const
+{
+    return checksum;
+}
+
+bool LUFactorization::is_mapped() const
+{
+    return map != 0 || shared.data() != 0;
+}
+
+MatrixView<const double> LUFactorization::get_factors() const
+{
+    return MatrixView<const double>(factors, n, n, n);
+}
+
+const Vector<int>& LUFactorization::get_pivots() const
+{
+    return ipiv;
+}
+
+const MathVector& LUFactorization::get_scale() const
+{
+    return scale;
+}
+
+// SOLVE
+void LUFactorization::solve(MatrixView<double> b) const
+{
+    if (b.getNrows() != n)
+        throw std::invalid_argument("sizes of factorisation and right-hand "
+                                    "sides differ");
+
+    for (Index i = 0; i < n; ++i)
+        scal(scale[i], b.row(i));
+    lu_solve_pivoted(get_factors(), ipiv, b);
+}
+
+MathVector LUFactorization::solve(const MathVector& b) const
+{
+    if (b.size() != n)
+        throw std::invalid_argument("sizes of factorisation and vector differ");
+
+    MathVector x(b);
+    solve(MatrixView<double>(x.data(), n, 1, 1));
+    return x;
+}
+
+// FILES
+void LUFactorization::save(const std::string& name) const
+{
+    FileHeader h = make_header(n, checksum);
+    std::vector<int32_t> piv(n);
+    std::vector<char> pad(FACTORS_ALIGN, 0);
+
+    for (Index i = 0; i < n; ++i)
+        piv[i] = ipiv[i];
+
+    std::ofstream ofs(name.c_str(), std::ios::binary | std::ios::trunc);
+    ofs.write((const char*)&h, sizeof(h));
+    ofs.write(&pad[0], h.scale_offset - sizeof(h));
+    ofs.write((const char*)scale.data(), n * sizeof(double));
+    ofs.write(&pad[0], h.pivots_offset - h.scale_offset - n * sizeof(double));
+    ofs.write((const char*)piv.data(), n * sizeof(int32_t));
+    ofs.write(&pad[0],
+              h.factors_offset - h.pivots_offset - n * sizeof(int32_t));
+    ofs.write((const char*)factors, n * n * (std::streamsize)sizeof(double));
+    ofs.close();
+
+    if (!ofs)
+        throw std::runtime_error("cannot write " + name);
+}
+
+void LUFactorization::load(const std::string& name, const MathMatrix& a)
+{
+    load(name, matrix_checksum(a));
+}
+
+void LUFactorization::load(const std::string& name, uint64_t sum)
+{
+    FileHeader h;
+    const char* base;
+#ifdef LU_MAPPED_FILES
+    struct stat st;
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + name);
+    if (fstat(fd, &st) != 0 || pread(fd, &h, sizeof(h), 0) != sizeof(h))
+    {
+        close(fd);
+        throw std::runtime_error("cannot read " + name);
+    }
+    try {
+        check_header(h, st.st_size, sum);
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+
+    // the mapping outlives the descriptor
+    void* p = mmap(0, h.file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::runtime_error("cannot map " + name);
+#ifdef MADV_WILLNEED
+    madvise(p, h.file_size, MADV_WILLNEED);  // start reading ahead
+#endif
+    base = (const char*)p;
+#else
+    std::ifstream ifs(name.c_str(), std::ios::binary | std::ios::ate);
+    if (!ifs)
+        throw std::runtime_error("cannot open " + name);
+    int64_t size = ifs.tellg();
+    ifs.seekg(0);
+    if (!ifs.read((char*)&h, sizeof(h)))
+        throw std::runtime_error("cannot read " + name);
+    check_header(h, size, sum);
+
+    std::vector<char> head(h.factors_offset);
+    MathMatrix f(h.n, UNINITIALIZED);
+    ifs.seekg(0);
+    if (!ifs.read(&head[0], h.factors_offset) ||
+        !ifs.read((char*)f.data(), h.n * h.n * (std::streamsize)sizeof(double)))
+        throw std::runtime_error("cannot read " + name);
+    base = &head[0];
+#endif
+
+    MathVector r;
+    Vector<int> piv;
+    if (!read_sections(base, h, r, piv))
+    {
+#ifdef LU_MAPPED_FILES
+        munmap(p, h.file_size);
+#endif
+        throw std::runtime_error("LU factorisation file corrupt");
+    }
+
+    unmap();
+    n = h.n;
+    ipiv.swap(piv);
+    scale.swap(r);
+    checksum = h.checksum;
+#ifdef LU_MAPPED_FILES
+    lu = MathMatrix();
+    map = p;
+    map_size = h.file_size;
+    factors = (const double*)(base + h.factors_offset);
+#else
+    lu = std::move(f);
+    factors = lu.data();
+#endif
+}
+
+// SHARED MEMORY
+uint64_t LUFactorization::publish(const std::string& name) const
+{
+    FileHeader h = make_header(n, checksum);
+    SharedSegment seg;
+
+    seg.create(name, h.file_size);  // zero-filled, padding included
+    char* base = seg.writable_data();
+    memcpy(base, &h, sizeof(h));
+    memcpy(base + h.scale_offset, scale.data(), n * sizeof(double));
+    for (Index i = 0; i < n; ++i)
+    {
+        int32_t k = ipiv[i];
+        memcpy(base + h.pivots_offset + i * sizeof(int32_t), &k, sizeof(k));
+    }
+    if (n > 0)
+        memcpy(base + h.factors_offset, factors, n * n * sizeof(double));
+
+    if (!seg.publish())
+        throw std::runtime_error("newer LU factorisation published as " +
+                                 name);
+    return seg.get_generation();
+}
+
+void LUFactorization::attach(const std::string& name, const MathMatrix& a)
+{
+    attach(name, matrix_checksum(a));
+}
+
+void LUFactorization::attach(const std::string& name, uint64_t sum)
+{
+    SharedSegment seg;
+    FileHeader h;
+
+    seg.attach(name);
+    if (seg.size() < sizeof(h))
+        throw std::runtime_error("not an LU factorisation file");
+    memcpy(&h, seg.data(), sizeof(h));
+    check_header(h, seg.size(), sum);
+
+    MathVector r;
+    Vector<int> piv;
+    if (!read_sections(seg.data(), h, r, piv))
+        throw std::runtime_error("LU factorisation file corrupt");
+
+    unmap();
+    n = h.n;
+    ipiv.swap(piv);
+    scale.swap(r);
+    checksum = h.checksum;
+    lu = MathMatrix();
+    shared.swap(seg);
+    factors = (const double*)(shared.data() + h.factors_offset);
+}
+
+const SharedSegment& LUFactorization::get_shared() const
+{
+    return shared;
+}
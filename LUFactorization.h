@@ -0,0 +1,224 @@
+/**
+ * @file LUFactorization.h
+ * @brief Header file containing the LU factorisation with partial pivoting of
+ * a row-equilibrated matrix, and its binary files.
+ */
+#ifndef LU_FACTORIZATION_H
+#define LU_FACTORIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MathMatrix.h"
+#include "MathVector.h"
+#include "SharedMatrix.h"
+#include "view.h"
+
+/**
+ * @brief Checksum of a square matrix.
+ * @param a Matrix.
+ * @return 64-bit hash of the size and of the bit patterns of the elements.
+ *
+ * It identifies the matrix a factorisation was computed from (see
+ * LUFactorization::load()). Blocks of rows are hashed by the library thread
+ * pool; the result does not depend on the number of threads.
+ */
+uint64_t matrix_checksum(const MathMatrix& a);
+
+/**
+ * @brief Class meant to represent the LU factorisation P R A = L U of a
+ * row-equilibrated square matrix A.
+ *
+ * R is diagonal, R_ii being the power of 2 nearest below the inverse of the
+ * largest element of row i of A. The rows of RA then have comparable sizes,
+ * so partial pivoting picks meaningful pivots even when A is badly scaled,
+ * and the scale factors, powers of 2, cause no rounding error.
+ *
+ * A factorisation can be saved to a binary file and loaded by another
+ * process. The file holds a header (format version, byte order, size and
+ * checksum of A), the scale factors, the pivots and the factors L and U
+ * packed in one row-major matrix, L without its unit diagonal. The factors
+ * are page aligned and a loaded file is mapped into memory, not read: a
+ * restarted process can solve as soon as the file is opened, the pages of
+ * the factors being read from the file when first used. Loading checks the
+ * file was computed from the given matrix.
+ *
+ * The same contents can be published in named shared memory (see
+ * SharedMatrix.h), so that the worker processes of a host attach to one
+ * factorisation instead of each factorising or loading its own.
+ */
+class LUFactorization {
+private:
+    Index n;               // size of the matrix
+    MathMatrix lu;         // L and U, empty when mapped
+    Vector<int> ipiv;      // pivots, see lu_fact_pivoted()
+    MathVector scale;      // diagonal of R
+    uint64_t checksum;     // checksum of A
+    const double* factors; // L and U, in lu, the mapped file or shared
+    void* map;             // mapped file, 0 if none
+    size_t map_size;       // length of the mapping in bytes
+    SharedSegment shared;  // attached shared memory
+
+    LUFactorization(const LUFactorization&);             // not copyable
+    LUFactorization& operator=(const LUFactorization&);  // not copyable
+
+    void unmap();
+
+public:
+    /**
+     * @brief Default constructor, an empty factorisation.
+     */
+    LUFactorization();
+
+    /**
+     * @brief Alternate constructor, factorises a matrix.
+     * @param a Square matrix to factorise.
+     *
+     * See factor().
+     */
+    explicit LUFactorization(const MathMatrix& a);
+
+    /**
+     * @brief Destructor, unmaps a loaded file or attached shared memory.
+     */
+    ~LUFactorization();
+
+    /**
+     * @brief Factorises a matrix.
+     * @param a Square matrix to factorise.
+     *
+     * The rows of a are scaled, then factorised by lu_fact_pivoted(), so on
+     * the selected backend (see Backend.h). It throws an exception when a is
+     * singular, the factorisation being then left unchanged.
+     */
+    void factor(const MathMatrix& a);
+
+    /**
+     * @brief Returns the size of the factorised matrix.
+     * @return Size n.
+     */
+    Index get_size() const;
+
+    /**
+     * @brief Returns the checksum of the factorised matrix.
+     * @return Checksum, see matrix_checksum().
+     */
+    uint64_t get_checksum() const;
+
+    /**
+     * @brief Tells whether the factors are mapped from a file or shared
+     * memory.
+     * @return True after load(), on systems with memory mapped files, and
+     * after attach().
+     */
+    bool is_mapped() const;
+
+    /**
+     * @brief Returns the factors.
+     * @return View of L (below the diagonal) and U.
+     */
+    MatrixView<const double> get_factors() const;
+
+    /**
+     * @brief Returns the pivots.
+     * @return Pivots, row r of RA was swapped with row ipiv[r].
+     */
+    const Vector<int>& get_pivots() const;
+
+    /**
+     * @brief Returns the scale factors.
+     * @return Diagonal of R.
+     */
+    const MathVector& get_scale() const;
+
+    /**
+     * @brief Solves the equations AX = B.
+     * @param b View of the right-hand sides, overwritten by the solutions.
+     *
+     * Solves (RA) X = RB with lu_solve_pivoted(). It throws an exception when
+     * b does not have n rows.
+     */
+    void solve(MatrixView<double> b) const;
+
+    /**
+     * @brief Solves the equation Ax = b.
+     * @param b Vector b of size n.
+     * @return Solution x.
+     *
+     * It throws an exception when b is not of size n.
+     */
+    MathVector solve(const MathVector& b) const;
+
+    /**
+     * @brief Writes the factorisation to a binary file.
+     * @param name Name of the file.
+     *
+     * The file is read back by load(), on a machine of the same byte order.
+     * It throws an exception when the file cannot be written.
+     */
+    void save(const std::string& name) const;
+
+    /**
+     * @brief Reads a factorisation of a given matrix from a binary file.
+     * @param name Name of the file written by save().
+     * @param a Matrix the factorisation should be of.
+     *
+     * As load(name, matrix_checksum(a)).
+     */
+    void load(const std::string& name, const MathMatrix& a);
+
+    /**
+     * @brief Reads a factorisation from a binary file.
+     * @param name Name of the file written by save().
+     * @param sum Checksum of the matrix the factorisation should be of.
+     *
+     * The factors are mapped from the file, which must then not be modified
+     * while the factorisation is in use; where files cannot be mapped they
+     * are read. It throws an exception when the file cannot be read, is not
+     * a factorisation of this format, version and byte order, is truncated
+     * or was computed from another matrix (its checksum differs from sum),
+     * the factorisation being then left unchanged.
+     */
+    void load(const std::string& name, uint64_t sum);
+
+    /**
+     * @brief Publishes the factorisation in shared memory.
+     * @param name Published name, see SharedMatrix.h.
+     * @return Generation published.
+     *
+     * The segment holds the contents of the file written by save(). It
+     * throws an exception when the segment cannot be created, or when a
+     * newer generation was published meanwhile.
+     */
+    uint64_t publish(const std::string& name) const;
+
+    /**
+     * @brief Attaches to a factorisation of a given matrix published in
+     * shared memory.
+     * @param name Published name.
+     * @param a Matrix the factorisation should be of.
+     *
+     * As attach(name, matrix_checksum(a)).
+     */
+    void attach(const std::string& name, const MathMatrix& a);
+
+    /**
+     * @brief Attaches to a factorisation published in shared memory.
+     * @param name Published name.
+     * @param sum Checksum of the matrix the factorisation should be of.
+     *
+     * The factors are read in place, read-only; a later publication under
+     * the name does not change them (see SharedSegment::is_current()). It
+     * throws an exception as load(), the factorisation being then left
+     * unchanged.
+     */
+    void attach(const std::string& name, uint64_t sum);
+
+    /**
+     * @brief Returns the attached shared memory.
+     * @return Segment, empty unless attach() was called.
+     */
+    const SharedSegment& get_shared() const;
+};
+
+#endif /* LU_FACTORIZATION_H */
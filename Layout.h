@@ -0,0 +1,107 @@
+/**
+ * @file Layout.h
+ * @brief Header file containing the layout policies, which tell where the
+ * elements of a Matrix are stored.
+ *
+ * A layout is a class of static functions given to Matrix as its second
+ * template parameter, so the addressing of the elements is resolved at
+ * compile time and inlined in every kernel which uses it:
+ *
+ * - size(nrows, ncols), the number of elements stored;
+ * - offset(i, j, nrows, ncols), the position of element (i, j);
+ * - position(k, nrows, ncols, i, j), the element (i, j) stored at position
+ *   k, the inverse of offset() (used by the layout conversion);
+ * - for the strided layouts only, row_stride() and col_stride(), the strides
+ *   of a MatrixView of the whole matrix (see view()).
+ *
+ * Row-major, which all the numeric classes of the library use, is the
+ * default. Column-major stores the columns contiguously, as expected by
+ * Fortran, BLAS and LAPACK. Tiled stores square tiles contiguously, so
+ * that a tile fits in the cache and does not straddle rows of the matrix.
+ */
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "Index.h"
+
+/**
+ * @brief Row-major layout, element (i, j) at i * ncols + j.
+ */
+struct RowMajor {
+    static Index size(Index nrows, Index ncols) { return nrows * ncols; }
+
+    static Index offset(Index i, Index j, Index, Index ncols)
+    {
+        return i * ncols + j;
+    }
+
+    static void position(Index k, Index, Index ncols, Index& i, Index& j)
+    {
+        i = k / ncols;
+        j = k % ncols;
+    }
+
+    static Index row_stride(Index, Index ncols) { return ncols; }
+    static Index col_stride(Index, Index) { return 1; }
+};
+
+/**
+ * @brief Column-major layout, element (i, j) at j * nrows + i.
+ */
+struct ColMajor {
+    static Index size(Index nrows, Index ncols) { return nrows * ncols; }
+
+    static Index offset(Index i, Index j, Index nrows, Index)
+    {
+        return j * nrows + i;
+    }
+
+    static void position(Index k, Index nrows, Index, Index& i, Index& j)
+    {
+        i = k % nrows;
+        j = k / nrows;
+    }
+
+    static Index row_stride(Index, Index) { return 1; }
+    static Index col_stride(Index nrows, Index) { return nrows; }
+};
+
+/**
+ * @brief Tiled layout, B x B tiles stored one after another.
+ *
+ * The tiles are ordered row by row and the elements of a tile row by row, so
+ * tile (bi, bj) is a B x B row-major block (see tile()). The number of rows
+ * and of columns are rounded up to multiples of B; the padding is stored but
+ * is not part of the matrix. B should be a power of 2, which turns the
+ * divisions of the addressing into shifts.
+ */
+template <int B>
+struct Tiled {
+    /**
+     * @brief Number of rows or columns rounded up to a multiple of B.
+     */
+    static Index padded(Index n) { return (n + B - 1) / B * B; }
+
+    static Index size(Index nrows, Index ncols)
+    {
+        return padded(nrows) * padded(ncols);
+    }
+
+    static Index offset(Index i, Index j, Index, Index ncols)
+    {
+        Index tiles = padded(ncols) / B;  // tiles per row of tiles
+
+        return ((i / B) * tiles + j / B) * (B * B) + (i % B) * B + j % B;
+    }
+
+    static void position(Index k, Index, Index ncols, Index& i, Index& j)
+    {
+        Index tiles = padded(ncols) / B;
+        Index t = k / (B * B), r = k % (B * B);
+
+        i = t / tiles * B + r / B;
+        j = t % tiles * B + r % B;
+    }
+};
+
+#endif /* LAYOUT_H */
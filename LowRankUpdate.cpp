@@ -0,0 +1,358 @@
+#include "LowRankUpdate.h"
+#include "MathBlas.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Smallest pivot of a factorised capacitance matrix I + V^T Z, relative to
+// the largest of 1 and the elements of V^T Z, below which the updated matrix
+// is taken as singular: the update would lose nearly all the digits.
+static const double CAPACITANCE_TOL = 1e-12;
+
+// checks that U and V are n x k of the same k
+static void check_correction(Index n, MatrixView<const double> u,
+                             MatrixView<const double> v)
+{
+    if (u.getNrows() != n || v.getNrows() != n ||
+        u.getNcols() != v.getNcols())
+        throw std::invalid_argument("incompatible sizes of update");
+}
+
+// view of a vector as a single column
+static MatrixView<const double> column_view(const MathVector& x)
+{
+    return MatrixView<const double>(x.data(), x.size(), 1, 1);
+}
+
+// factorises the capacitance matrix c, throws when it is singular or so
+// ill-conditioned that the update would lose all accuracy
+static void factor_capacitance(MathMatrix& c, Vector<int>& piv)
+{
+    Index k = c.get_size();
+    double big = 1, small;
+
+    for (Index i = 0; i < k; ++i)
+        for (Index j = 0; j < k; ++j)
+            big = std::max(big, fabs(c(i, j) - (i == j)));
+
+    lu_fact_pivoted(view(c), piv);
+
+    small = big;
+    for (Index i = 0; i < k; ++i)
+        small = std::min(small, fabs(c(i, i)));
+    if (!(small > CAPACITANCE_TOL * big))
+        throw std::runtime_error("update makes the matrix singular");
+}
+
+// EXPLICIT INVERSE
+void woodbury_update(MathMatrix& ainv, MatrixView<const double> u,
+                     MatrixView<const double> v)
+{
+    Index n = ainv.get_size(), k = u.getNcols();
+    Vector<int> piv;
+
+    check_correction(n, u, v);
+    if (k == 0)
+        return;
+
+    // Z = A^-1 U, W = V^T A^-1 and C = I + V^T Z
+    Matrix<double> z(n, k, UNINITIALIZED), w(k, n, UNINITIALIZED);
+    MathMatrix c(k);
+    gemm(NO_TRANS, NO_TRANS, 1.0, view(ainv), u, 0.0, view(z));
+    gemm(TRANS, NO_TRANS, 1.0, v, view(ainv), 0.0, view(w));
+    for (Index i = 0; i < k; ++i)
+        c(i, i) = 1;
+    gemm(TRANS, NO_TRANS, 1.0, v, view(z), 1.0, view(c));
+
+    // A^-1 = A^-1 - Z C^-1 W
+    factor_capacitance(c, piv);
+    lu_solve_pivoted(view(c), piv, view(w));
+    gemm(NO_TRANS, NO_TRANS, -1.0, view(z), view(w), 1.0, view(ainv));
+}
+
+// UPDATABLE SOLVER
+LowRankUpdatable::LowRankUpdatable(const MathMatrix& a, double tolerance)
+    : a(a), tolerance(tolerance), nrefactor(0)
+{}
+
+LowRankUpdatable::~LowRankUpdatable() {}
+
+Index LowRankUpdatable::get_size() const
+{
+    return a.get_size();
+}
+
+const MathMatrix& LowRankUpdatable::matrix() const
+{
+    return a;
+}
+
+double LowRankUpdatable::get_tolerance() const
+{
+    return tolerance;
+}
+
+void LowRankUpdatable::set_tolerance(double tol)
+{
+    tolerance = tol;
+}
+
+int LowRankUpdatable::get_refactorizations() const
+{
+    return nrefactor;
+}
+
+void LowRankUpdatable::update(MatrixView<const double> u,
+                              MatrixView<const double> v)
+{
+    check_correction(get_size(), u, v);
+    if (u.getNcols() == 0)
+        return;
+
+    gemm(NO_TRANS, TRANS, 1.0, u, v, 1.0, view(a));
+
+    // a NaN drift fails the test too
+    if (apply_update(u, v) && drift() <= tolerance)
+        return;
+
+    try {
+        factor();
+    }
+    catch (std::runtime_error&) {
+        gemm(NO_TRANS, TRANS, -1.0, u, v, 1.0, view(a));
+        factor();
+        throw;
+    }
+    ++nrefactor;
+}
+
+void LowRankUpdatable::update(const MathVector& u, const MathVector& v)
+{
+    update(column_view(u), column_view(v));
+}
+
+void LowRankUpdatable::downdate(MatrixView<const double> u,
+                                MatrixView<const double> v)
+{
+    Matrix<double> nu(u.getNrows(), u.getNcols(), UNINITIALIZED);
+
+    for (Index i = 0; i < u.getNrows(); ++i)
+        for (Index j = 0; j < u.getNcols(); ++j)
+            nu(i, j) = -u(i, j);
+    update(view(nu), v);
+}
+
+void LowRankUpdatable::downdate(const MathVector& u, const MathVector& v)
+{
+    downdate(column_view(u), column_view(v));
+}
+
+void LowRankUpdatable::replace_row(Index i, const MathVector& r)
+{
+    Index n = get_size();
+    MathVector e(n), d(n);
+
+    if (i < 0 || i >= n)
+        throw std::out_of_range("row out of range");
+    if (r.size() != n)
+        throw std::invalid_argument("incompatible sizes of row");
+
+    // A + e_i (r - A(i, :))^T
+    e[i] = 1;
+    for (Index j = 0; j < n; ++j)
+        d[j] = r[j] - a(i, j);
+    update(e, d);
+}
+
+void LowRankUpdatable::replace_column(Index j, const MathVector& c)
+{
+    Index n = get_size();
+    MathVector e(n), d(n);
+
+    if (j < 0 || j >= n)
+        throw std::out_of_range("column out of range");
+    if (c.size() != n)
+        throw std::invalid_argument("incompatible sizes of column");
+
+    // A + (c - A(:, j)) e_j^T
+    e[j] = 1;
+    for (Index i = 0; i < n; ++i)
+        d[i] = c[i] - a(i, j);
+    update(d, e);
+}
+
+void LowRankUpdatable::refactor()
+{
+    factor();
+}
+
+double LowRankUpdatable::drift() const
+{
+    Index n = get_size();
+    MathVector b(n), r(n);
+    double rnorm = 0, xnorm = 0, bnorm = 0;
+
+    if (n == 0)
+        return 0;
+
+    // fixed right-hand side of varied elements in [1, 2)
+    for (Index i = 0; i < n; ++i)
+        b[i] = 1 + (i * 7919 % 1000) / 1000.0;
+
+    MathVector x = solve(b);
+    r = b;
+    gemv(NO_TRANS, -1.0, a, x, 1.0, r);
+
+    for (Index i = 0; i < n; ++i)
+    {
+        rnorm = std::max(rnorm, fabs(r[i]));
+        xnorm = std::max(xnorm, fabs(x[i]));
+        bnorm = std::max(bnorm, fabs(b[i]));
+    }
+    return rnorm / (a.uniform_norm() * xnorm + bnorm);
+}
+
+void LowRankUpdatable::solve(MatrixView<double> b) const
+{
+    if (b.getNrows() != get_size())
+        throw std::invalid_argument("sizes of matrix and right-hand sides "
+                                    "differ");
+
+    apply_inverse(b);
+}
+
+MathVector LowRankUpdatable::solve(const MathVector& b) const
+{
+    if (b.size() != get_size())
+        throw std::invalid_argument("sizes of matrix and vector differ");
+
+    MathVector x(b);
+    apply_inverse(MatrixView<double>(x.data(), x.size(), 1, 1));
+    return x;
+}
+
+// UPDATABLE LU FACTORISATION
+UpdatableLU::UpdatableLU(const MathMatrix& a, Index max_rank,
+                         double tolerance)
+    : LowRankUpdatable(a, tolerance), u(a.get_size(), max_rank),
+      v(a.get_size(), max_rank), z(a.get_size(), max_rank), k(0)
+{
+    factor();
+}
+
+Index UpdatableLU::get_rank() const
+{
+    return k;
+}
+
+const LUFactorization& UpdatableLU::factorization() const
+{
+    return base;
+}
+
+void UpdatableLU::factor()
+{
+    base.factor(a);
+    k = 0;
+    cap = MathMatrix();
+    cpiv = Vector<int>();
+}
+
+bool UpdatableLU::apply_update(MatrixView<const double> uu,
+                               MatrixView<const double> vv)
+{
+    Index n = get_size(), r = uu.getNcols(), m = k + r;
+    MathMatrix c(m);
+    Vector<int> piv;
+
+    if (m > u.getNcols())
+        return false;
+
+    // columns [k, m) are not used until k is raised
+    for (Index i = 0; i < n; ++i)
+        for (Index j = 0; j < r; ++j)
+        {
+            u(i, k + j) = uu(i, j);
+            v(i, k + j) = vv(i, j);
+            z(i, k + j) = uu(i, j);
+        }
+    base.solve(block(z, 0, k, n, r));
+
+    // C = I + V^T Z
+    for (Index i = 0; i < m; ++i)
+        c(i, i) = 1;
+    gemm(TRANS, NO_TRANS, 1.0, block(v, 0, 0, n, m), block(z, 0, 0, n, m),
+         1.0, view(c));
+    try {
+        factor_capacitance(c, piv);
+    }
+    catch (std::runtime_error&) {
+        return false;
+    }
+
+    k = m;
+    cap = std::move(c);
+    cpiv.swap(piv);
+    return true;
+}
+
+void UpdatableLU::apply_inverse(MatrixView<double> b) const
+{
+    Index n = get_size();
+
+    base.solve(b);
+    if (k == 0)
+        return;
+
+    // X = X0 - Z C^-1 V^T X0, X0 = A0^-1 B
+    Matrix<double> w(k, b.getNcols(), UNINITIALIZED);
+    gemm(TRANS, NO_TRANS, 1.0, block(v, 0, 0, n, k), b, 0.0, view(w));
+    lu_solve_pivoted(view(cap), cpiv, view(w));
+    gemm(NO_TRANS, NO_TRANS, -1.0, block(z, 0, 0, n, k), view(w), 1.0, b);
+}
+
+// UPDATABLE INVERSE
+UpdatableInverse::UpdatableInverse(const MathMatrix& a, double tolerance)
+    : LowRankUpdatable(a, tolerance)
+{
+    factor();
+}
+
+const MathMatrix& UpdatableInverse::inverse() const
+{
+    return ainv;
+}
+
+void UpdatableInverse::factor()
+{
+    Index n = get_size();
+    LUFactorization f(a);
+    MathMatrix inv(n);
+
+    for (Index i = 0; i < n; ++i)
+        inv(i, i) = 1;
+    f.solve(view(inv));
+    ainv = std::move(inv);
+}
+
+bool UpdatableInverse::apply_update(MatrixView<const double> u,
+                                    MatrixView<const double> v)
+{
+    try {
+        woodbury_update(ainv, u, v);
+    }
+    catch (std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
+
+void UpdatableInverse::apply_inverse(MatrixView<double> b) const
+{
+    Matrix<double> x(b.getNrows(), b.getNcols(), UNINITIALIZED);
+
+    for (Index i = 0; i < b.getNrows(); ++i)
+        for (Index j = 0; j < b.getNcols(); ++j)
+            x(i, j) = b(i, j);
+    gemm(NO_TRANS, NO_TRANS, 1.0, view(ainv), view(x), 0.0, b);
+}
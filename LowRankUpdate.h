@@ -0,0 +1,295 @@
+/**
+ * @file LowRankUpdate.h
+ * @brief Header file containing the low-rank updates of a factorised or
+ * inverted matrix (Sherman-Morrison-Woodbury).
+ *
+ * A matrix changed by a rank-k correction, A' = A + U V^T with U and V of
+ * size n x k, need not be factorised or inverted again at O(n^3): by the
+ * Woodbury identity
+ *
+ *     A'^-1 = A^-1 - A^-1 U (I + V^T A^-1 U)^-1 V^T A^-1,
+ *
+ * only the k x k capacitance matrix I + V^T A^-1 U is factorised, at
+ * O(n^2 k) for the products with A^-1. Replacing row i of A by r is the
+ * rank-1 correction u = e_i, v = r - A(i, :), replacing column j by c the
+ * correction u = c - A(:, j), v = e_j (Sherman-Morrison).
+ *
+ * Every update loses some accuracy, so the updated solver checks its
+ * backward error after each update (see LowRankUpdatable::drift()) and
+ * computes the factorisation or the inverse again from the updated matrix
+ * when the error exceeds a tolerance.
+ */
+#ifndef LOW_RANK_UPDATE_H
+#define LOW_RANK_UPDATE_H
+
+#include "LUFactorization.h"
+#include "MathMatrix.h"
+#include "MathVector.h"
+#include "view.h"
+
+/**
+ * @brief Updates an explicit inverse for a rank-k correction of its matrix.
+ * @param ainv Inverse of A, overwritten by the inverse of A + U V^T.
+ * @param u View of U, n x k.
+ * @param v View of V, n x k.
+ *
+ * Applies the Woodbury identity at O(n^2 k). It throws an exception when the
+ * sizes do not match, or when the capacitance matrix is singular or nearly
+ * (A + U V^T is then too, or the update would lose nearly all accuracy),
+ * ainv being then left unchanged.
+ */
+void woodbury_update(MathMatrix& ainv, MatrixView<const double> u,
+                     MatrixView<const double> v);
+
+/**
+ * @brief Class meant to represent a solver of Ax = b for a matrix changing
+ * by low-rank corrections.
+ *
+ * It holds the current matrix A and applies every correction both to it and
+ * to the solver (the derived class: a factorisation or an inverse). After
+ * every update the backward error of a solve is checked and the solver is
+ * computed again from A when the error exceeds the tolerance.
+ */
+class LowRankUpdatable {
+protected:
+    MathMatrix a;      // current matrix
+    double tolerance;  // largest backward error kept
+    int nrefactor;     // number of refactorisations after an update
+
+    /**
+     * @brief Constructor of the derived classes.
+     * @param a Initial matrix.
+     * @param tolerance Largest backward error kept after an update.
+     */
+    LowRankUpdatable(const MathMatrix& a, double tolerance);
+
+    /**
+     * @brief Computes the solver from a, discarding the updates.
+     */
+    virtual void factor() = 0;
+
+    /**
+     * @brief Applies a correction to the solver, a being already updated.
+     * @param u View of U, n x k.
+     * @param v View of V, n x k.
+     * @return False when the correction cannot be applied, the solver is then
+     * computed again from a.
+     */
+    virtual bool apply_update(MatrixView<const double> u,
+                              MatrixView<const double> v) = 0;
+
+    /**
+     * @brief Solves AX = B.
+     * @param b View of B, n rows, overwritten by X.
+     */
+    virtual void apply_inverse(MatrixView<double> b) const = 0;
+
+public:
+    /**
+     * @brief Destructor.
+     */
+    virtual ~LowRankUpdatable();
+
+    /**
+     * @brief Returns the size of the matrix.
+     * @return Size n.
+     */
+    Index get_size() const;
+
+    /**
+     * @brief Returns the current matrix.
+     * @return Matrix A with all the updates.
+     */
+    const MathMatrix& matrix() const;
+
+    /**
+     * @brief Returns the tolerance of the drift check.
+     * @return Largest backward error kept after an update.
+     */
+    double get_tolerance() const;
+
+    /**
+     * @brief Sets the tolerance of the drift check.
+     * @param tol Largest backward error kept after an update.
+     */
+    void set_tolerance(double tol);
+
+    /**
+     * @brief Returns the number of refactorisations caused by updates.
+     * @return Number of times the solver was computed again from A.
+     */
+    int get_refactorizations() const;
+
+    /**
+     * @brief Rank-k update, A = A + U V^T.
+     * @param u View of U, n x k.
+     * @param v View of V, n x k.
+     *
+     * The solver is computed again from A when the update cannot be applied
+     * to it or the drift() exceeds the tolerance. It throws an exception when
+     * the sizes do not match, or when the updated matrix is singular, the
+     * update being then undone.
+     */
+    void update(MatrixView<const double> u, MatrixView<const double> v);
+
+    /**
+     * @brief Rank-1 update, A = A + u v^T.
+     * @param u Vector u of size n.
+     * @param v Vector v of size n.
+     */
+    void update(const MathVector& u, const MathVector& v);
+
+    /**
+     * @brief Rank-k downdate, A = A - U V^T, which undoes update(u, v).
+     * @param u View of U, n x k.
+     * @param v View of V, n x k.
+     */
+    void downdate(MatrixView<const double> u, MatrixView<const double> v);
+
+    /**
+     * @brief Rank-1 downdate, A = A - u v^T.
+     * @param u Vector u of size n.
+     * @param v Vector v of size n.
+     */
+    void downdate(const MathVector& u, const MathVector& v);
+
+    /**
+     * @brief Replaces a row of A.
+     * @param i Row.
+     * @param r New row, of size n.
+     *
+     * It throws an exception when i is out of range.
+     */
+    void replace_row(Index i, const MathVector& r);
+
+    /**
+     * @brief Replaces a column of A.
+     * @param j Column.
+     * @param c New column, of size n.
+     *
+     * It throws an exception when j is out of range.
+     */
+    void replace_column(Index j, const MathVector& c);
+
+    /**
+     * @brief Computes the solver again from the current matrix.
+     */
+    void refactor();
+
+    /**
+     * @brief Estimates the loss of accuracy of the updated solver.
+     * @return Normwise backward error |b - A x| / (|A| |x| + |b|) (uniform
+     * norms) of the solution x of Ax = b for a fixed right-hand side b.
+     *
+     * A stable solver gives a small multiple of the machine precision; the
+     * error grows as updates accumulate. It costs a solve and a product with
+     * A, O(n^2).
+     */
+    double drift() const;
+
+    /**
+     * @brief Solves the equations AX = B.
+     * @param b View of the right-hand sides, n rows, overwritten by the
+     * solutions.
+     *
+     * It throws an exception when b does not have n rows.
+     */
+    void solve(MatrixView<double> b) const;
+
+    /**
+     * @brief Solves the equation Ax = b.
+     * @param b Vector b of size n.
+     * @return Solution x.
+     *
+     * It throws an exception when b is not of size n.
+     */
+    MathVector solve(const MathVector& b) const;
+};
+
+/**
+ * @brief Class meant to represent an LU factorisation updated by low-rank
+ * corrections.
+ *
+ * The factorisation of the matrix A0 of the last refactorisation is kept,
+ * the corrections accumulated, A = A0 + U V^T, and the solves apply the
+ * Woodbury identity with Z = A0^-1 U and the factorised capacitance matrix
+ * I + V^T Z: an update of rank r costs O(n^2 r + n k^2) and a solve
+ * O(n^2 + n k). When k would exceed the maximum rank, A is factorised again.
+ */
+class UpdatableLU : public LowRankUpdatable {
+private:
+    LUFactorization base;  // factorisation of A0
+    Matrix<double> u;      // U, V and Z = A0^-1 U in columns [0, k)
+    Matrix<double> v;
+    Matrix<double> z;
+    Index k;               // rank of the accumulated correction
+    MathMatrix cap;        // factorisation of the capacitance, k x k
+    Vector<int> cpiv;      // its pivots
+
+    UpdatableLU(const UpdatableLU&);             // not copyable
+    UpdatableLU& operator=(const UpdatableLU&);  // not copyable
+
+protected:
+    void factor();
+    bool apply_update(MatrixView<const double> u, MatrixView<const double> v);
+    void apply_inverse(MatrixView<double> b) const;
+
+public:
+    /**
+     * @brief A constructor, factorises a matrix.
+     * @param a Square matrix.
+     * @param max_rank Largest rank of the accumulated corrections.
+     * @param tolerance Largest backward error kept after an update.
+     *
+     * It throws an exception when a is singular or max_rank is negative.
+     */
+    explicit UpdatableLU(const MathMatrix& a, Index max_rank = 32,
+                         double tolerance = 1e-10);
+
+    /**
+     * @brief Returns the rank of the accumulated corrections.
+     * @return Rank k, 0 after a refactorisation.
+     */
+    Index get_rank() const;
+
+    /**
+     * @brief Returns the factorisation of the last refactorisation.
+     * @return Factorisation of A0.
+     */
+    const LUFactorization& factorization() const;
+};
+
+/**
+ * @brief Class meant to represent an explicit inverse updated by low-rank
+ * corrections.
+ *
+ * Every correction is applied to the inverse by woodbury_update(), at
+ * O(n^2 k); a solve is a product with the inverse.
+ */
+class UpdatableInverse : public LowRankUpdatable {
+private:
+    MathMatrix ainv;  // inverse of a
+
+protected:
+    void factor();
+    bool apply_update(MatrixView<const double> u, MatrixView<const double> v);
+    void apply_inverse(MatrixView<double> b) const;
+
+public:
+    /**
+     * @brief A constructor, inverts a matrix.
+     * @param a Square matrix.
+     * @param tolerance Largest backward error kept after an update.
+     *
+     * It throws an exception when a is singular.
+     */
+    explicit UpdatableInverse(const MathMatrix& a, double tolerance = 1e-10);
+
+    /**
+     * @brief Returns the inverse.
+     * @return Inverse of the current matrix.
+     */
+    const MathMatrix& inverse() const;
+};
+
+#endif /* LOW_RANK_UPDATE_H */
@@ -0,0 +1,531 @@
+#include "MathBlas.h"
+#include "Backend.h"
+#include "Instrument.h"
+#include <cmath>
+
+// KERNELS
+// The kernels address the operands through a row stride and a column stride,
+// element (i, j) of an operand x being x[i * rs + j * cs]. A transposed
+// operand is then just the same data with the two strides swapped.
+
+// block sizes of the matrix by matrix kernel, chosen so that a block of B
+// (KC x NC doubles) stays in the cache while it is reused by all rows of A
+static const int KC = 128;
+static const int NC = 512;
+
+// The product kernels are templates on the type I of their index arithmetic:
+// int when every offset into the operands fits in it, which makes the
+// address computations cheaper, else Index.
+
+// C = beta C
+static void scale_kernel(Index m, Index n, double beta, double* c, Index crs,
+                         Index ccs)
+{
+    Index i, j;
+
+    if (beta == 1.0)
+        return;
+
+    if (beta == 0.0) {
+        // C is not read when beta is 0, so NaNs in it do not propagate
+        for (i = 0; i < m; ++i)
+            for (j = 0; j < n; ++j)
+                c[i * crs + j * ccs] = 0.0;
+    }
+    else {
+        for (i = 0; i < m; ++i)
+            for (j = 0; j < n; ++j)
+                c[i * crs + j * ccs] *= beta;
+    }
+}
+
+// C += alpha A B, where A is m x k, B is k x n and C is m x n
+template <typename I>
+static void gemm_kernel(I m, I n, I k, double alpha,
+                        const double* a, I ars, I acs,
+                        const double* b, I brs, I bcs,
+                        double* c, I crs, I ccs)
+{
+    I i, j, p, pp, jj, pend, jend;
+    double aip, sum;
+
+    if (bcs == 1 && ccs == 1) {
+        // rows of B and C are contiguous: C(i, :) += A(i, p) B(p, :)
+        for (pp = 0; pp < k; pp += KC) {
+            pend = pp + KC < k ? pp + KC : k;
+            for (jj = 0; jj < n; jj += NC) {
+                jend = jj + NC < n ? jj + NC : n;
+                for (i = 0; i < m; ++i) {
+                    double* ci = c + i * crs;
+                    for (p = pp; p < pend; ++p) {
+                        aip = alpha * a[i * ars + p * acs];
+                        const double* bp = b + p * brs;
+                        for (j = jj; j < jend; ++j)
+                            ci[j] += aip * bp[j];
+                    }
+                }
+            }
+        }
+    }
+    else if (crs == 1 && ars == 1) {
+        // columns of A and C are contiguous: C(:, j) += A(:, p) B(p, j)
+        for (j = 0; j < n; ++j) {
+            double* cj = c + j * ccs;
+            for (p = 0; p < k; ++p) {
+                aip = alpha * b[p * brs + j * bcs];
+                const double* ap = a + p * acs;
+                for (i = 0; i < m; ++i)
+                    cj[i] += aip * ap[i];
+            }
+        }
+    }
+    else {
+        // C(i, j) += A(i, :) . B(:, j), contiguous when A is row-wise and B
+        // column-wise (eg. the product A B^T)
+        for (i = 0; i < m; ++i)
+            for (j = 0; j < n; ++j) {
+                sum = 0;
+                for (p = 0; p < k; ++p)
+                    sum += a[i * ars + p * acs] * b[p * brs + j * bcs];
+                c[i * crs + j * ccs] += alpha * sum;
+            }
+    }
+}
+
+// y += alpha A x, where A is m x n
+template <typename I>
+static void gemv_kernel(I m, I n, double alpha,
+                        const double* a, I ars, I acs,
+                        const double* x, I xs, double* y, I ys)
+{
+    I i, j;
+    double sum, xj;
+
+    if (acs == 1) {
+        // rows of A are contiguous: y(i) += A(i, :) . x
+        for (i = 0; i < m; ++i) {
+            const double* ai = a + i * ars;
+            sum = 0;
+            for (j = 0; j < n; ++j)
+                sum += ai[j] * x[j * xs];
+            y[i * ys] += alpha * sum;
+        }
+    }
+    else {
+        // columns of A are contiguous (transposed operand): y += A(:, j) x(j)
+        for (j = 0; j < n; ++j) {
+            const double* aj = a + j * acs;
+            xj = alpha * x[j * xs];
+            for (i = 0; i < m; ++i)
+                y[i * ys] += aj[i * ars] * xj;
+        }
+    }
+}
+
+// B = inv(A) B, where A is m x m lower (upper) triangular and B is m x n; the
+// rows of X are found in order, top down (bottom up), each one from the rows
+// found before it
+static void trsm_kernel(bool lower, bool unit, Index m, Index n,
+                        const double* a, Index ars, Index acs,
+                        double* b, Index brs, Index bcs)
+{
+    Index i, j, k, k0, k1, ii;
+    double aik, d, xk, sum;
+
+    if (brs == 1 && bcs != 1) {
+        // columns of B are contiguous (transposed right-hand side): solve
+        // column by column, so the inner loops run along them
+        for (j = 0; j < n; ++j) {
+            double* bj = b + j * bcs;
+            for (ii = 0; ii < m; ++ii) {
+                i = lower ? ii : m - 1 - ii;
+                if (ars == 1) {
+                    // columns of A contiguous too: x(i) is found, then
+                    // taken off the elements still to be found
+                    const double* ai = a + i * acs;
+                    if (!unit)
+                        bj[i] /= ai[i];
+                    xk = bj[i];
+                    if (xk == 0.0)
+                        continue;
+                    k0 = lower ? i + 1 : 0;
+                    k1 = lower ? m : i;
+                    for (k = k0; k < k1; ++k)
+                        bj[k] -= ai[k] * xk;
+                }
+                else {
+                    // x(i) from the elements found before it
+                    const double* ai = a + i * ars;
+                    k0 = lower ? 0 : i + 1;
+                    k1 = lower ? i : m;
+                    sum = bj[i];
+                    for (k = k0; k < k1; ++k)
+                        sum -= ai[k * acs] * bj[k];
+                    bj[i] = unit ? sum : sum / ai[i * acs];
+                }
+            }
+        }
+        return;
+    }
+
+    for (ii = 0; ii < m; ++ii) {
+        i = lower ? ii : m - 1 - ii;
+        k0 = lower ? 0 : i + 1;
+        k1 = lower ? i : m;
+        double* bi = b + i * brs;
+        for (k = k0; k < k1; ++k) {
+            aik = a[i * ars + k * acs];
+            if (aik == 0.0)
+                continue;
+            const double* bk = b + k * brs;
+            for (j = 0; j < n; ++j)
+                bi[j * bcs] -= aik * bk[j * bcs];
+        }
+        if (!unit) {
+            d = a[i * ars + i * acs];
+            for (j = 0; j < n; ++j)
+                bi[j * bcs] /= d;
+        }
+    }
+}
+
+// tells whether the offsets into an m x n operand with strides rs and cs,
+// up to (m - 1) |rs| + (n - 1) |cs|, fit in an int
+static bool int_offsets(Index m, Index n, Index rs, Index cs)
+{
+    return fits_int((m > 0 ? m - 1 : 0) * (rs < 0 ? -rs : rs) +
+                    (n > 0 ? n - 1 : 0) * (cs < 0 ? -cs : cs));
+}
+
+static bool int_offsets(MatrixView<const double> x)
+{
+    return int_offsets(x.getNrows(), x.getNcols(), x.getRowStride(),
+                       x.getColStride());
+}
+
+// MATRIX BY MATRIX MULTIPLICATION
+void gemm(Transpose ta, Transpose tb, double alpha, MatrixView<const double> a,
+          MatrixView<const double> b, double beta, MatrixView<double> c)
+{
+    // op(A) and op(B) are views with swapped strides
+    if (ta == TRANS)
+        a = a.transpose();
+    if (tb == TRANS)
+        b = b.transpose();
+
+    Index m = a.getNrows();
+    Index k = a.getNcols();
+    Index n = b.getNcols();
+
+    if (b.getNrows() != k || c.getNrows() != m || c.getNcols() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MATH_COUNT(CALLS_GEMM, 1);
+    if (m == 0 || n == 0)
+        return;
+
+    if (backend_gemm(alpha, a, b, beta, c))
+    {
+        MATH_COUNT(FLOPS_GEMM, 2.0 * m * n * k);
+        return;
+    }
+
+    scale_kernel(m, n, beta, c.data(), c.getRowStride(), c.getColStride());
+    if (alpha != 0.0 && k > 0)
+    {
+        MATH_COUNT(FLOPS_GEMM, 2.0 * m * n * k);
+        if (int_offsets(a) && int_offsets(b) && int_offsets(c))
+            gemm_kernel<int>(m, n, k, alpha,
+                             a.data(), a.getRowStride(), a.getColStride(),
+                             b.data(), b.getRowStride(), b.getColStride(),
+                             c.data(), c.getRowStride(), c.getColStride());
+        else
+            gemm_kernel<Index>(m, n, k, alpha,
+                               a.data(), a.getRowStride(), a.getColStride(),
+                               b.data(), b.getRowStride(), b.getColStride(),
+                               c.data(), c.getRowStride(), c.getColStride());
+    }
+}
+
+void gemm(Transpose ta, Transpose tb, double alpha, const Matrix<double>& a,
+          const Matrix<double>& b, double beta, Matrix<double>& c)
+{
+    gemm(ta, tb, alpha, view(a), view(b), beta, view(c));
+}
+
+// MATRIX BY VECTOR MULTIPLICATION
+void gemv(Transpose ta, double alpha, MatrixView<const double> a,
+          VectorView<const double> x, double beta, VectorView<double> y)
+{
+    // op(A) is a view with swapped strides
+    if (ta == TRANS)
+        a = a.transpose();
+
+    Index m = a.getNrows();
+    Index n = a.getNcols();
+
+    if (x.size() != n || y.size() != m)
+        throw std::invalid_argument("incompatible matrix and vector sizes");
+
+    MATH_COUNT(CALLS_GEMV, 1);
+    if (m == 0)
+        return;
+
+    if (backend_gemv(alpha, a, x, beta, y))
+    {
+        MATH_COUNT(FLOPS_GEMV, 2.0 * m * n);
+        return;
+    }
+
+    scale_kernel(m, 1, beta, y.data(), y.getStride(), 1);
+    if (alpha != 0.0 && n > 0)
+    {
+        MATH_COUNT(FLOPS_GEMV, 2.0 * m * n);
+        if (int_offsets(a) && int_offsets(n, 1, x.getStride(), 1) &&
+            int_offsets(m, 1, y.getStride(), 1))
+            gemv_kernel<int>(m, n, alpha, a.data(), a.getRowStride(),
+                             a.getColStride(), x.data(), x.getStride(),
+                             y.data(), y.getStride());
+        else
+            gemv_kernel<Index>(m, n, alpha, a.data(), a.getRowStride(),
+                               a.getColStride(), x.data(), x.getStride(),
+                               y.data(), y.getStride());
+    }
+}
+
+void gemv(Transpose ta, double alpha, const Matrix<double>& a,
+          const Vector<double>& x, double beta, Vector<double>& y)
+{
+    gemv(ta, alpha, view(a), view(x), beta, view(y));
+}
+
+// TRIANGULAR SOLVE
+void trsm(Side side, UpLo uplo, Transpose ta, Diag diag, double alpha,
+          MatrixView<const double> a, MatrixView<double> b)
+{
+    Index na = side == LEFT ? b.getNrows() : b.getNcols();
+
+    if (a.getNrows() != na || a.getNcols() != na)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    if (b.getNrows() == 0 || b.getNcols() == 0)
+        return;
+
+    if (backend_trsm(side, uplo, ta, diag, alpha, a, b))
+        return;
+
+    // X op(A) = B is op(A)^T X^T = B^T, and op(A) a view with swapped
+    // strides, so only the left-hand, non-transposed case is left
+    bool lower = uplo == LOWER;
+    if (side == RIGHT)
+    {
+        b = b.transpose();
+        ta = ta == TRANS ? NO_TRANS : TRANS;
+    }
+    if (ta == TRANS)
+    {
+        a = a.transpose();
+        lower = !lower;
+    }
+
+    scale_kernel(b.getNrows(), b.getNcols(), alpha, b.data(),
+                 b.getRowStride(), b.getColStride());
+    trsm_kernel(lower, diag == UNIT, b.getNrows(), b.getNcols(), a.data(),
+                a.getRowStride(), a.getColStride(), b.data(),
+                b.getRowStride(), b.getColStride());
+}
+
+// VECTOR KERNELS
+// x and y have n elements with strides xs and ys
+
+static void check_sizes(Index nx, Index ny)
+{
+    if (nx != ny)
+        throw std::invalid_argument("incompatible vector sizes");
+}
+
+double dot(VectorView<const double> x, VectorView<const double> y)
+{
+    Index i = 0, n = x.size(), xs = x.getStride(), ys = y.getStride();
+    const double* px = x.data();
+    const double* py = y.data();
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    check_sizes(n, y.size());
+    MATH_COUNT(FLOPS_VECTOR, 2.0 * n);
+
+    if (xs == 1 && ys == 1) {
+        // four independent accumulators, kept in vector registers
+        for (; i + 3 < n; i += 4) {
+            s0 += px[i] * py[i];
+            s1 += px[i + 1] * py[i + 1];
+            s2 += px[i + 2] * py[i + 2];
+            s3 += px[i + 3] * py[i + 3];
+        }
+        for (; i < n; ++i)
+            s0 += px[i] * py[i];
+    }
+    else {
+        for (; i < n; ++i)
+            s0 += px[i * xs] * py[i * ys];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+double dot(const Vector<double>& x, const Vector<double>& y)
+{
+    return dot(view(x), view(y));
+}
+
+void axpy(double alpha, VectorView<const double> x, VectorView<double> y)
+{
+    axpby(alpha, x, 1.0, y);
+}
+
+void axpy(double alpha, const Vector<double>& x, Vector<double>& y)
+{
+    axpby(alpha, view(x), 1.0, view(y));
+}
+
+void axpby(double alpha, VectorView<const double> x, double beta,
+           VectorView<double> y)
+{
+    Index i, n = x.size(), xs = x.getStride(), ys = y.getStride();
+    const double* px = x.data();
+    double* py = y.data();
+
+    check_sizes(n, y.size());
+
+    if (beta != 1.0)
+        scale_kernel(n, 1, beta, py, ys, 1);
+    if (alpha == 0.0)
+        return;
+
+    MATH_COUNT(FLOPS_VECTOR, 2.0 * n);
+    if (xs == 1 && ys == 1) {
+        for (i = 0; i < n; ++i)
+            py[i] += alpha * px[i];
+    }
+    else {
+        for (i = 0; i < n; ++i)
+            py[i * ys] += alpha * px[i * xs];
+    }
+}
+
+void axpby(double alpha, const Vector<double>& x, double beta,
+           Vector<double>& y)
+{
+    axpby(alpha, view(x), beta, view(y));
+}
+
+void scal(double alpha, VectorView<double> x)
+{
+    MATH_COUNT(FLOPS_VECTOR, x.size());
+    scale_kernel(x.size(), 1, alpha, x.data(), x.getStride(), 1);
+}
+
+void scal(double alpha, Vector<double>& x)
+{
+    scal(alpha, view(x));
+}
+
+void copy(VectorView<const double> x, VectorView<double> y)
+{
+    Index i, n = x.size(), xs = x.getStride(), ys = y.getStride();
+    const double* px = x.data();
+    double* py = y.data();
+
+    check_sizes(n, y.size());
+    MATH_COUNT(BYTES_COPIED, n * sizeof(double));
+
+    if (xs == 1 && ys == 1) {
+        for (i = 0; i < n; ++i)
+            py[i] = px[i];
+    }
+    else {
+        for (i = 0; i < n; ++i)
+            py[i * ys] = px[i * xs];
+    }
+}
+
+void copy(const Vector<double>& x, Vector<double>& y)
+{
+    copy(view(x), view(y));
+}
+
+void swap_elements(VectorView<double> x, VectorView<double> y)
+{
+    Index i, n = x.size(), xs = x.getStride(), ys = y.getStride();
+    double* px = x.data();
+    double* py = y.data();
+    double tmp;
+
+    check_sizes(n, y.size());
+
+    for (i = 0; i < n; ++i) {
+        tmp = px[i * xs];
+        px[i * xs] = py[i * ys];
+        py[i * ys] = tmp;
+    }
+}
+
+void swap_elements(Vector<double>& x, Vector<double>& y)
+{
+    swap_elements(view(x), view(y));
+}
+
+Index iamax(VectorView<const double> x)
+{
+    Index i, imax = -1, n = x.size(), xs = x.getStride();
+    const double* px = x.data();
+    double amax = -1, v;
+
+    for (i = 0; i < n; ++i) {
+        v = fabs(px[i * xs]);
+        if (v > amax) {
+            amax = v;
+            imax = i;
+        }
+    }
+
+    return imax;
+}
+
+Index iamax(const Vector<double>& x)
+{
+    return iamax(view(x));
+}
+
+double nrm2(VectorView<const double> x)
+{
+    Index i, n = x.size(), xs = x.getStride();
+    const double* px = x.data();
+    double scale = 0, ssq = 1, v, r;
+
+    MATH_COUNT(FLOPS_VECTOR, 2.0 * n);
+
+    // the norm is scale * sqrt(ssq), scale being the largest absolute value
+    // met so far (as in the reference BLAS dnrm2)
+    for (i = 0; i < n; ++i) {
+        v = fabs(px[i * xs]);
+        if (v == 0)
+            continue;
+        if (scale < v) {
+            r = scale / v;
+            ssq = 1 + ssq * r * r;
+            scale = v;
+        }
+        else {
+            r = v / scale;
+            ssq += r * r;
+        }
+    }
+
+    return scale * sqrt(ssq);
+}
+
+double nrm2(const Vector<double>& x)
+{
+    return nrm2(view(x));
+}
@@ -0,0 +1,282 @@
+/**
+ * @file MathBlas.h
+ * @brief Header file containing general matrix-matrix and matrix-vector
+ * product routines, the triangular solve and the vector (level 1) routines.
+ *
+ * gemm(), gemv() and trsm() run on the system BLAS when it is the selected
+ * backend (see Backend.h), and on the kernels of the library otherwise.
+ */
+#ifndef MATH_BLAS_H
+#define MATH_BLAS_H
+
+#include "matrix.h"
+#include "vector.h"
+#include "view.h"
+
+/**
+ * @brief Tells whether an operand of gemm() or gemv() is used as it is or
+ * transposed.
+ *
+ * Transposition is done by the way the elements are addressed, a transposed
+ * copy of the operand is never built.
+ */
+enum Transpose {
+    NO_TRANS,  ///< Use the operand as it is.
+    TRANS      ///< Use the transposed operand.
+};
+
+/**
+ * @brief Tells on which side of the unknown the triangular matrix of trsm()
+ * is.
+ */
+enum Side {
+    LEFT,  ///< Solve op(A) X = alpha B.
+    RIGHT  ///< Solve X op(A) = alpha B.
+};
+
+/**
+ * @brief Tells which triangle of a matrix is used.
+ */
+enum UpLo {
+    LOWER,  ///< The lower triangle, the strictly upper part is not read.
+    UPPER   ///< The upper triangle, the strictly lower part is not read.
+};
+
+/**
+ * @brief Tells whether a triangular matrix has a unit diagonal.
+ */
+enum Diag {
+    NON_UNIT,  ///< The diagonal is read.
+    UNIT       ///< The diagonal is taken as ones and is not read.
+};
+
+/**
+ * @brief General matrix by matrix multiplication, C = alpha op(A) op(B) +
+ * beta C.
+ * @param ta Tells whether A is transposed.
+ * @param tb Tells whether B is transposed.
+ * @param alpha Scaling factor of the product.
+ * @param a Matrix A.
+ * @param b Matrix B.
+ * @param beta Scaling factor of C.
+ * @param c Reference to the matrix C, which accumulates the result.
+ *
+ * op(A) has to be m x k, op(B) k x n and C m x n, otherwise an exception is
+ * thrown. When beta is zero C is not read, so it does not have to be
+ * initialised.
+ */
+void gemm(Transpose ta, Transpose tb, double alpha, const Matrix<double>& a,
+          const Matrix<double>& b, double beta, Matrix<double>& c);
+
+/**
+ * @brief General matrix by vector multiplication, y = alpha op(A) x + beta y.
+ * @param ta Tells whether A is transposed.
+ * @param alpha Scaling factor of the product.
+ * @param a Matrix A.
+ * @param x Vector x.
+ * @param beta Scaling factor of y.
+ * @param y Reference to the vector y, which accumulates the result.
+ *
+ * op(A) has to be m x n, x of size n and y of size m, otherwise an exception
+ * is thrown. When beta is zero y is not read.
+ */
+void gemv(Transpose ta, double alpha, const Matrix<double>& a,
+          const Vector<double>& x, double beta, Vector<double>& y);
+
+/**
+ * @brief General matrix by matrix multiplication on views, C = alpha op(A)
+ * op(B) + beta C.
+ * @param ta Tells whether A is transposed.
+ * @param tb Tells whether B is transposed.
+ * @param alpha Scaling factor of the product.
+ * @param a View of the matrix A.
+ * @param b View of the matrix B.
+ * @param beta Scaling factor of C.
+ * @param c View of the matrix C, which accumulates the result.
+ *
+ * Works on blocks, rows or transpositions of existing matrices without
+ * copying them. C must not overlap A or B.
+ */
+void gemm(Transpose ta, Transpose tb, double alpha, MatrixView<const double> a,
+          MatrixView<const double> b, double beta, MatrixView<double> c);
+
+/**
+ * @brief General matrix by vector multiplication on views, y = alpha op(A) x
+ * + beta y.
+ * @param ta Tells whether A is transposed.
+ * @param alpha Scaling factor of the product.
+ * @param a View of the matrix A.
+ * @param x View of the vector x.
+ * @param beta Scaling factor of y.
+ * @param y View of the vector y, which accumulates the result.
+ *
+ * y must not overlap A or x.
+ */
+void gemv(Transpose ta, double alpha, MatrixView<const double> a,
+          VectorView<const double> x, double beta, VectorView<double> y);
+
+/**
+ * @brief Triangular solve with multiple right-hand sides, op(A) X = alpha B
+ * or X op(A) = alpha B.
+ * @param side Tells on which side of X op(A) is.
+ * @param uplo Tells whether A is lower or upper triangular.
+ * @param ta Tells whether A is transposed.
+ * @param diag Tells whether A has a unit diagonal.
+ * @param alpha Scaling factor of B.
+ * @param a View of the square matrix A, of size m for side LEFT and n for
+ * side RIGHT.
+ * @param b View of the m x n matrix B, overwritten by X.
+ *
+ * Only the triangle uplo of A is read. A is not checked for singularity, a
+ * zero on its diagonal gives infinite or NaN elements. b must not overlap a.
+ */
+void trsm(Side side, UpLo uplo, Transpose ta, Diag diag, double alpha,
+          MatrixView<const double> a, MatrixView<double> b);
+
+// VECTOR ROUTINES
+// Every routine has an overload on views, which works on strided vectors
+// (rows, columns or diagonals of matrices), and one on vectors. The operands
+// have to be of the same size, otherwise an exception is thrown. Contiguous
+// operands take a fast path the compiler can vectorise.
+
+/**
+ * @brief Dot product x . y.
+ * @param x View of the vector x.
+ * @param y View of the vector y.
+ * @return Dot product.
+ *
+ * The sum is split into four independent accumulators, so the result may
+ * differ from a plain loop by rounding errors.
+ */
+double dot(VectorView<const double> x, VectorView<const double> y);
+
+/**
+ * @brief Dot product x . y.
+ * @param x Vector x.
+ * @param y Vector y.
+ * @return Dot product.
+ */
+double dot(const Vector<double>& x, const Vector<double>& y);
+
+/**
+ * @brief y = alpha x + y.
+ * @param alpha Scaling factor of x.
+ * @param x View of the vector x.
+ * @param y View of the vector y, which accumulates the result.
+ */
+void axpy(double alpha, VectorView<const double> x, VectorView<double> y);
+
+/**
+ * @brief y = alpha x + y.
+ * @param alpha Scaling factor of x.
+ * @param x Vector x.
+ * @param y Reference to the vector y, which accumulates the result.
+ */
+void axpy(double alpha, const Vector<double>& x, Vector<double>& y);
+
+/**
+ * @brief y = alpha x + beta y.
+ * @param alpha Scaling factor of x.
+ * @param x View of the vector x.
+ * @param beta Scaling factor of y.
+ * @param y View of the vector y, which accumulates the result.
+ *
+ * When beta is zero y is not read.
+ */
+void axpby(double alpha, VectorView<const double> x, double beta,
+           VectorView<double> y);
+
+/**
+ * @brief y = alpha x + beta y.
+ * @param alpha Scaling factor of x.
+ * @param x Vector x.
+ * @param beta Scaling factor of y.
+ * @param y Reference to the vector y, which accumulates the result.
+ */
+void axpby(double alpha, const Vector<double>& x, double beta,
+           Vector<double>& y);
+
+/**
+ * @brief x = alpha x.
+ * @param alpha Scaling factor.
+ * @param x View of the vector x.
+ *
+ * When alpha is zero x is not read.
+ */
+void scal(double alpha, VectorView<double> x);
+
+/**
+ * @brief x = alpha x.
+ * @param alpha Scaling factor.
+ * @param x Reference to the vector x.
+ */
+void scal(double alpha, Vector<double>& x);
+
+/**
+ * @brief y = x, without allocating memory.
+ * @param x View of the vector x.
+ * @param y View of the vector y.
+ */
+void copy(VectorView<const double> x, VectorView<double> y);
+
+/**
+ * @brief y = x, without allocating memory.
+ * @param x Vector x.
+ * @param y Reference to the vector y.
+ */
+void copy(const Vector<double>& x, Vector<double>& y);
+
+/**
+ * @brief Exchanges the elements of x and y (BLAS swap).
+ * @param x View of the vector x.
+ * @param y View of the vector y.
+ *
+ * Not named swap(), which argument-dependent lookup would pick over
+ * std::swap() for views. It throws an exception when the sizes differ.
+ */
+void swap_elements(VectorView<double> x, VectorView<double> y);
+
+/**
+ * @brief Exchanges the elements of x and y (BLAS swap).
+ * @param x Reference to the vector x.
+ * @param y Reference to the vector y.
+ *
+ * Unlike swap(x, y) (see vector.h) the storage is not exchanged, so views
+ * of x and y see the new elements. It throws an exception when the sizes
+ * differ.
+ */
+void swap_elements(Vector<double>& x, Vector<double>& y);
+
+/**
+ * @brief Index of the element of x of largest absolute value.
+ * @param x View of the vector x.
+ * @return Index of the first such element, -1 when x is empty.
+ */
+Index iamax(VectorView<const double> x);
+
+/**
+ * @brief Index of the element of x of largest absolute value.
+ * @param x Vector x.
+ * @return Index of the first such element, -1 when x is empty.
+ */
+Index iamax(const Vector<double>& x);
+
+/**
+ * @brief Euclidean norm of x, computed with scaling.
+ * @param x View of the vector x.
+ * @return Euclidean norm.
+ *
+ * The squares are summed relative to the largest absolute value met so far,
+ * in one pass, so the result neither overflows nor underflows unless the
+ * norm itself does.
+ */
+double nrm2(VectorView<const double> x);
+
+/**
+ * @brief Euclidean norm of x, computed with scaling.
+ * @param x Vector x.
+ * @return Euclidean norm.
+ */
+double nrm2(const Vector<double>& x);
+
+#endif /* MATH_BLAS_H */
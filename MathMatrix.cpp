@@ -1,89 +1,193 @@
 #include "MathMatrix.h"
+#include "MathBlas.h"
+#include "Backend.h"
+#include "Instrument.h"
+#include "Trace.h"
+#include "SingularValues.h"
 #include <cmath>
+#include <cstdlib>
+#include <vector>
 
 // CONSTRUCTORS
 MathMatrix::MathMatrix() : Matrix<double>(), n(0) {} // default constructor
 
-MathMatrix::MathMatrix(int n) : Matrix<double>(n, n), n(n) {} // alternate constructor
+// alternate constructor
+MathMatrix::MathMatrix(Index n, Initialization init)
+    : Matrix<double>(n, n, init), n(n) {}
 
 // METHODS SPECIFIC FOR SQUARE MATRIX OF DOUBLES
 
-int MathMatrix::get_size() const // return size of matrix
+Index MathMatrix::get_size() const // return size of matrix
 {
     return nrows;   
 }
 
+MathMatrix MathMatrix::clone() const // copy sharing no elements
+{
+    MathMatrix m(*this);
+    m.v = v.clone();
+    return m;
+}
+
 double MathMatrix::one_norm() const // 1-norm of a matrix
 {
-    // the maximum absolute column sum of the matrix
-    int i, j;
+    return one_norm(SEQ);
+}
 
-    double res = 0;
-    double sum = 0;
-    
-    for (j = 0; j < ncols; ++j) // for each columnn
-    {
-        sum = 0;
-        for (i = 0; i < nrows; ++i)
-            sum += fabs((*this)(i, j));
+double MathMatrix::two_norm() const // 2-norm of a matrix
+{
+    return two_norm(SEQ);
+}
 
-        if (sum > res) // store the biggest sum
-            res = sum;
-    }
+double MathMatrix::uniform_norm() const // uniform norm of a matrix 
+{
+    return uniform_norm(SEQ);
+}
+
+// NORMS WITH EXECUTION POLICY
+// Partial results of the chunks are combined in chunk order, so results are
+// the same from run to run for a given number of threads.
+
+// minimum number of rows or columns per chunk
+static const int GRAIN = 64;
+
+// init plus the sum of f(p[j]) for j in [0, n); with simd the sum is split
+// into four independent accumulators, which the compiler can keep in vector
+// registers, otherwise it is accumulated in order
+template <typename F>
+static double row_sum(const double* p, Index n, bool simd, F f, double init)
+{
+    Index j = 0;
+    double s0 = init, s1 = 0, s2 = 0, s3 = 0;
+
+    if (simd)
+        for (; j + 3 < n; j += 4)
+        {
+            s0 += f(p[j]);
+            s1 += f(p[j + 1]);
+            s2 += f(p[j + 2]);
+            s3 += f(p[j + 3]);
+        }
+    for (; j < n; ++j)
+        s0 += f(p[j]);
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double abs_value(double x) { return fabs(x); }
+static double square(double x) { return x * x; }
+
+double MathMatrix::one_norm(ExecutionPolicy policy) const
+{
+    double res;
+    if (backend_norm(ONE_NORM, view(*this), res))
+        return res;
+
+    // the maximum absolute column sum of the matrix
+    // every chunk handles a range of columns, walking the matrix row by row
+    int nch = policy == SEQ ? 1 : num_chunks(ncols, GRAIN);
+    std::vector<double> part(nch);
+    const double* pa = data();
+    Index m = nrows, n = ncols;
+
+    parallel_for(ncols, nch, [&](Index lo, Index hi, int c) {
+        Index i, j;
+        std::vector<double> sum(hi - lo);
+        double res = 0;
+
+        for (i = 0; i < m; ++i)
+            for (j = lo; j < hi; ++j)
+                sum[j - lo] += fabs(pa[i * n + j]);
+
+        for (j = lo; j < hi; ++j)
+            if (sum[j - lo] > res) // store the biggest sum
+                res = sum[j - lo];
+        part[c] = res;
+    });
+
+    res = 0;
+    for (int c = 0; c < nch; ++c)
+        if (part[c] > res)
+            res = part[c];
 
     return res;
 }
 
-double MathMatrix::two_norm() const // 2-norm of a matrix
+double MathMatrix::two_norm(ExecutionPolicy policy) const
 {
+    double res;
+    if (backend_norm(FROBENIUS_NORM, view(*this), res))
+        return res;
+
     // the Frobenius norm
     // the square root of the sum of the absolute squares of all matrix elements
-    int i, j;
+    int nch = policy == SEQ ? 1 : num_chunks(nrows, GRAIN);
+    std::vector<double> part(nch);
+    const double* pa = data();
+    Index n = ncols;
+
+    parallel_for(nrows, nch, [&](Index lo, Index hi, int c) {
+        double res = 0;
+        for (Index i = lo; i < hi; ++i)
+            res = row_sum(pa + i * n, n, policy == PAR_SIMD, square, res);
+        part[c] = res;
+    });
+
+    res = 0;
+    for (int c = 0; c < nch; ++c)
+        res += part[c];
 
-    double res = 0;
-
-    for (i = 0; i < nrows; ++i)
-        for (j = 0; j < ncols; ++j)
-            res += (*this)(i, j) * (*this)(i, j);   // fabs() not necessary since
-                                                    // there are only double values
     return sqrt(res);
 }
 
-double MathMatrix::uniform_norm() const // uniform norm of a matrix 
+double MathMatrix::uniform_norm(ExecutionPolicy policy) const
 {
+    double res;
+    if (backend_norm(UNIFORM_NORM, view(*this), res))
+        return res;
+
     // the maximum absolute row sum of the matrix
-    int i, j;
+    int nch = policy == SEQ ? 1 : num_chunks(nrows, GRAIN);
+    std::vector<double> part(nch);
+    const double* pa = data();
+    Index n = ncols;
+
+    parallel_for(nrows, nch, [&](Index lo, Index hi, int c) {
+        double sum, res = 0;
+        for (Index i = lo; i < hi; ++i)
+        {
+            sum = row_sum(pa + i * n, n, policy == PAR_SIMD, abs_value, 0.0);
+            if (sum > res) // store the biggest sum
+                res = sum;
+        }
+        part[c] = res;
+    });
 
-    double res = 0;
-    double sum = 0;
-    
-    for (i = 0; i < nrows; ++i) // for each row
-    {
-        sum = 0;
-        for (j = 0; j < ncols; ++j)
-            sum += fabs((*this)(i, j));
-
-        if (sum > res) // store the biggest sum
-            res = sum;
-    }
+    res = 0;
+    for (int c = 0; c < nch; ++c)
+        if (part[c] > res)
+            res = part[c];
 
     return res;
 }
 
+double MathMatrix::spectral_norm() const
+{
+    SingularValueEstimator est;
+    return est.spectral_norm(*this);
+}
+
 // overloaded matrix by matrix multiplication
 MathMatrix MathMatrix::operator*(const MathMatrix& a) const
 {
-    if (nrows != a.nrows)
+    if (ncols != a.nrows)
         throw std::invalid_argument("incompatible matrix sizes");
 
-    int i, j, k;
+    MATH_COUNT(CALLS_MULTIPLY, 1);
+    MATH_TRACE_SCOPE("multiply");
+    MathMatrix res(nrows, UNINITIALIZED);  // gemm does not read it
 
-    MathMatrix res(nrows);
-    
-    for (i = 0; i < nrows; ++i)
-        for (j = 0; j < ncols; ++j)
-            for (k = 0; k < ncols; ++k)
-                res(i, j) += (*this)(i, k) * a(k, j);
+    gemm(NO_TRANS, NO_TRANS, 1.0, *this, a, 0.0, res);
 
     return res;
 }
@@ -91,144 +195,520 @@ MathMatrix MathMatrix::operator*(const MathMatrix& a) const
 // overloaded multiplication of matrix by a vector
 MathVector MathMatrix::operator*(const MathVector& v) const
 {
-    if (nrows != v.size())
+    if (ncols != v.size())
         throw std::invalid_argument("incompatible matrix sizes");
 
-    int i, j;
-
-    MathVector res(nrows);
+    MATH_COUNT(CALLS_MULTIPLY_VECTOR, 1);
+    MATH_TRACE_SCOPE("multiply vector");
+    MathVector res(nrows, UNINITIALIZED);  // gemv does not read it
 
-    for (i = 0; i < nrows; ++i)
-        for (j = 0; j < ncols; ++j)
-            res[i] += (*this)(i, j) * v[j];
+    gemv(NO_TRANS, 1.0, *this, v, 0.0, res);
     
     return res;
 }
 
+// matrix by vector multiplication reusing the memory of y
+void MathMatrix::multiply(const MathVector& x, MathVector& y) const
+{
+    if (ncols != x.size())
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    if (&x == &y)
+    {
+        // gemv needs y apart from x
+        y = *this * x;
+        return;
+    }
+
+    MATH_COUNT(CALLS_MULTIPLY_VECTOR, 1);
+    MATH_TRACE_SCOPE("multiply vector");
+    if (y.size() != nrows)
+        y = MathVector(nrows);
+
+    gemv(NO_TRANS, 1.0, *this, x, 0.0, y);
+}
+
 // compute the lower triangular form, L, in the LU 
 // factorisation
-MathMatrix MathMatrix::compute_lower() const
+TriangularMatrix<LOWER, UNIT> MathMatrix::compute_lower() const
 {
-    MathMatrix l, u;
+    MathMatrix temp = *this;
 
-    lu_fact(*this, l, u, nrows);
+    lu_fact_inplace(view(temp)); // only the factorised copy is needed
 
-    return l;
+    return TriangularMatrix<LOWER, UNIT>(view(temp));
 }
 
 // compute the upper triangular form, U, in the LU 
 // factorisation
-MathMatrix MathMatrix::compute_upper() const
+TriangularMatrix<UPPER, NON_UNIT> MathMatrix::compute_upper() const
 {
-    MathMatrix l, u;
+    MathMatrix temp = *this;
 
-    lu_fact(*this, l, u, nrows);
+    lu_fact_inplace(view(temp)); // only the factorised copy is needed
 
-    return u;
+    return TriangularMatrix<UPPER, NON_UNIT>(view(temp));
 }
 
 // compute the inverse matrix
 MathMatrix MathMatrix::inverse() const
 {
-    // Finding the inverse of a matrix using LU factorisation
+    return inverse(SEQ);
+}
 
-    int i, j, k;
+MathMatrix MathMatrix::inverse(ExecutionPolicy policy) const
+{
+    // Finding the inverse in a copy of the matrix, see inverse_inplace()
+    MathMatrix inv = *this;
+    inverse_inplace(policy, view(inv));
+    return inv;
+}
 
-    // call the function reorder to generate a pivoting (permutation) matrix P
-    MathMatrix p;
-    reorder(*this, nrows, p);
+// compute the condition number of the matrix 
+double MathMatrix::condition_num() const
+{
+    return condition_num(SEQ);
+}
 
-    // Find the LU factorisation of PA using the function lu_fact
-    MathMatrix l, u;
-    lu_fact(*this, l, u, nrows);
+double MathMatrix::condition_num(ExecutionPolicy policy) const
+{
+    // using one norm
+    return inverse(policy).one_norm(policy) * one_norm(policy);
+}
 
-    // Finding inverse of L and U
-    MathMatrix l_inv(nrows), u_inv(nrows);
-    MathVector e(nrows), temp(nrows);
-    for (k = 0; k < nrows; ++k)
-    {
-        // ek = (0 ... 0 1 0 ... 0) with 1 in the kth position and zero elsewhere.
-        e[k] = 1;
-        if (k > 0)
-            e[k - 1] = 0;
-
-        // the inverse of L and U are formed from the solution vectors as
-        // successive columns of the inverse matrices
-
-        // forward substitution for L y = e.
-        // temp begins with a copy of e.
-        temp = e;
-        for (i = 1; i < nrows; ++i)
-            for (j = 0; j < i; ++j)
-                temp[i] -= l(i, j) * temp[j];
-
-        for (i = 0; i < nrows; ++i)
-            l_inv(i, k) = temp[i];
-
-        // back substitution for U y = e.
-        // temp begins with a copy of e.
-        temp = e;
-        for (i = nrows - 1; i >= 0; --i)
-        {
-            for (j = i + 1; j < nrows; ++j)
-                temp[i] -= u(i, j) * temp[j];
-            temp[i] /= u(i, i);
-        }
+// MULTIPLICATION WITH EXECUTION POLICY
+// Every chunk computes a range of rows of the result.
+MathMatrix multiply(ExecutionPolicy policy, const MathMatrix& a,
+                    const MathMatrix& b)
+{
+    Index n = a.get_size();
 
-        for (i = 0; i < nrows; ++i)
-            u_inv(i, k) = temp[i];
-    }
+    if (policy == SEQ)
+        return a * b;
 
-    return u_inv * l_inv * p;
+    if (a.getNcols() != b.getNrows())
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MATH_COUNT(CALLS_MULTIPLY, 1);
+    MATH_TRACE_SCOPE("multiply");
+    MathMatrix res(n, UNINITIALIZED);  // first touched by its chunk's thread
+    MatrixView<double> rv = view(res);
+
+    parallel_for(n, num_chunks(n, 16), [&](Index lo, Index hi, int) {
+        gemm(NO_TRANS, NO_TRANS, 1.0, block(a, lo, 0, hi - lo, n), view(b),
+             0.0, rv.block(lo, 0, hi - lo, n));
+    });
+
+    return res;
 }
 
-// compute the condition number of the matrix 
-double MathMatrix::condition_num() const
+MathVector multiply(ExecutionPolicy policy, const MathMatrix& a,
+                    const MathVector& v)
 {
-    // using one norm
-    return (*this).inverse().one_norm() * (*this).one_norm();
+    Index n = a.get_size();
+
+    if (policy == SEQ)
+        return a * v;
+
+    if (a.getNcols() != v.size())
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MATH_COUNT(CALLS_MULTIPLY_VECTOR, 1);
+    MATH_TRACE_SCOPE("multiply vector");
+    MathVector res(n, UNINITIALIZED);  // first touched by its chunk's thread
+    double* pr = res.data();
+
+    parallel_for(n, num_chunks(n, GRAIN), [&](Index lo, Index hi, int) {
+        gemv(NO_TRANS, 1.0, block(a, lo, 0, hi - lo, n), view(v), 0.0,
+             VectorView<double>(pr + lo, hi - lo));
+    });
+
+    return res;
 }
 
 // LU FACTORISATION ROUTINE
 // Takes in a matrix a of size n and produces the lower (l) and
 // upper (u) triangular matrices that factorise a 
 
-void lu_fact(const MathMatrix& a, MathMatrix& l, MathMatrix& u, int n)
+void lu_fact(const MathMatrix& a, MathMatrix& l, MathMatrix& u, Index n)
 {
-    double mult;
     MathMatrix temp = a; //copy a to temp
-    int i, j, k;
+    Index i, j;
+    Index ts = temp.get_size();  // row stride
+
+    // the copies below index the raw storage
+    if (n > ts)
+        throw std::invalid_argument("incompatible matrix sizes");
 
     l = MathMatrix(n);
     u = MathMatrix(n);
-    
+
+    // entries of L and U are saved in temp
+    lu_fact_inplace(view(temp));
+
+	// create l and u from temp, through pointers taken once
+	const double* pt = temp.data();
+	double* pl = l.data();
+	double* pu = u.data();
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < i; j++)
+			pl[i * n + j] = pt[i * ts + j];
+		pl[i * n + i] = 1.0;
+		for (j = i; j < n; j++)
+			pu[i * n + j] = pt[i * ts + j];
+	}
+}
+
+void lu_fact(const MathMatrix& a, TriangularMatrix<LOWER, UNIT>& l,
+             TriangularMatrix<UPPER, NON_UNIT>& u)
+{
+    MathMatrix temp = a; //copy a to temp
+
+    // entries of L and U are saved in temp, then packed
+    lu_fact_inplace(view(temp));
+    l = TriangularMatrix<LOWER, UNIT>(view(temp));
+    u = TriangularMatrix<UPPER, NON_UNIT>(view(temp));
+}
+
+// flops of the elimination of a matrix of size n without pivoting: n - 1 - k
+// divisions and (n - 1 - k)^2 multiply-subtracts at step k
+static inline double elimination_flops(Index n)
+{
+    return n * (n - 1.0) / 2 + (n - 1.0) * n * (2.0 * n - 1) / 3;
+}
+
+// IN-PLACE LU FACTORISATION ROUTINE
+// Overwrites a with L (below the diagonal) and U
+
+// the elimination, with index arithmetic in type I
+template <typename I>
+static void eliminate(double* p, I n, I rs, I cs)
+{
+	double mult;
+	I i, j, k;
+
 	// LU (Doolittle's) decomposition without pivoting
 	for (k = 0; k < n - 1; k++)
-    {
+	{
+		if (p[k * rs + k * cs] == 0)
+		{ 
+			printf("pivot is zero\n"); 
+			exit(1);
+		}
 		for (i = k + 1; i < n; i++)
-        {
-			if (temp(k,k) == 0)
-			{ 
-				printf("pivot is zero\n"); 
-				exit(1);
-			}
-			mult = temp(i, k) / temp(k, k);
-			temp(i, k) = mult;                      // entries of L are saved in temp
+		{
+			mult = p[i * rs + k * cs] / p[k * rs + k * cs];
+			p[i * rs + k * cs] = mult;                  // entries of L
 			for (j = k + 1; j < n; j++)
-				temp(i, j) -= mult*temp(k, j);      // entries of U are saved in temp
+				p[i * rs + j * cs] -= mult * p[k * rs + j * cs];  // entries of U
 		}
 	}
+}
 
-	// create l and u from temp
-	for (i = 0; i < n; i++)
-        l(i, i) = 1.0;
-	for (i = 1; i < n; i++) 
-	  for (j = 0; j < i; j++)
-        l(i, j) = temp(i, j);
+void lu_fact_inplace(MatrixView<double> a)
+{
+	Index n = a.getNrows();
 
-	for (i = 0; i < n; i++)
-		for (j = i; j < n; j++)
-            u(i, j) = temp(i, j);
+	if (a.getNcols() != n)
+		throw std::invalid_argument("matrix is not square");
+
+	MATH_COUNT(CALLS_LU_FACT, 1);
+	MATH_COUNT(FLOPS_LU_FACT, elimination_flops(n));
+	MATH_TRACE_SCOPE("lu_fact");
+
+	double* p = a.data();
+	Index rs = a.getRowStride();
+	Index cs = a.getColStride();
+
+	// 32-bit offsets when the largest one, (n - 1) (|rs| + |cs|), fits
+	if (n == 0 || fits_int((n - 1) * (std::abs(rs) + std::abs(cs))))
+		eliminate<int>(p, n, rs, cs);
+	else
+		eliminate<Index>(p, n, rs, cs);
+}
+
+// LU FACTORISATION WITH PARTIAL PIVOTING
+// Right-looking and blocked: a panel of PIVOT_BLOCK columns is factorised
+// column by column over all the rows below it, its interchanges are applied
+// to the columns left and right of it, then the block row of U right of the
+// panel is found by a triangular solve and the trailing matrix is updated by
+// a matrix product.
+
+static const int PIVOT_BLOCK = 64;
+
+// swap rows r1 and r2 in columns [j0, j1)
+static void swap_rows(double* p, Index rs, Index cs, Index r1, Index r2,
+                      Index j0, Index j1)
+{
+	double tmp;
+
+	for (Index j = j0; j < j1; j++)
+	{
+		tmp = p[r1 * rs + j * cs];
+		p[r1 * rs + j * cs] = p[r2 * rs + j * cs];
+		p[r2 * rs + j * cs] = tmp;
+	}
+}
+
+void lu_fact_pivoted(MatrixView<double> a, Vector<int>& ipiv)
+{
+	lu_fact_pivoted(a, ipiv, std::function<void(double)>());
+}
+
+void lu_fact_pivoted(MatrixView<double> a, Vector<int>& ipiv,
+                     const std::function<void(double)>& checkpoint)
+{
+	Index n = a.getNrows();
+	Index i, j, k, k0, kb, pr;
+	double amax, v, mult;
+
+	if (a.getNcols() != n)
+		throw std::invalid_argument("matrix is not square");
+	if (!fits_int(n))
+		throw std::length_error("matrix size overflow");  // int pivots
+
+	MATH_COUNT(CALLS_LU_FACT, 1);
+	MATH_COUNT(FLOPS_LU_FACT, elimination_flops(n));
+	MATH_TRACE_SCOPE("lu_fact");
+
+	if (ipiv.size() != n)
+		ipiv = Vector<int>(n, UNINITIALIZED);
+	if (backend_getrf(a, ipiv))
+	{
+		if (checkpoint)
+			checkpoint(1.0);
+		return;
+	}
+
+	double* p = a.data();
+	Index rs = a.getRowStride();
+	Index cs = a.getColStride();
+
+	for (k0 = 0; k0 < n; k0 += PIVOT_BLOCK)
+	{
+		kb = n - k0 < PIVOT_BLOCK ? n - k0 : PIVOT_BLOCK;
+
+		// factorise the panel
+		for (k = k0; k < k0 + kb; k++)
+		{
+			pr = k;
+			amax = fabs(p[k * rs + k * cs]);
+			for (i = k + 1; i < n; i++)
+			{
+				v = fabs(p[i * rs + k * cs]);
+				if (v > amax)
+				{
+					amax = v;
+					pr = i;
+				}
+			}
+			if (amax == 0)
+				throw std::runtime_error("matrix is singular");
+
+			ipiv[k] = (int)pr;
+			if (pr != k)
+				swap_rows(p, rs, cs, k, pr, k0, k0 + kb);
+
+			for (i = k + 1; i < n; i++)
+			{
+				mult = p[i * rs + k * cs] / p[k * rs + k * cs];
+				p[i * rs + k * cs] = mult;  // entries of L
+				for (j = k + 1; j < k0 + kb; j++)
+					p[i * rs + j * cs] -= mult * p[k * rs + j * cs];
+			}
+		}
+
+		// interchanges outside the panel
+		for (k = k0; k < k0 + kb; k++)
+			if (ipiv[k] != k)
+			{
+				swap_rows(p, rs, cs, k, ipiv[k], 0, k0);
+				swap_rows(p, rs, cs, k, ipiv[k], k0 + kb, n);
+			}
+
+		if (k0 + kb < n)
+		{
+			Index m = n - k0 - kb;
+
+			// U12 = L11^-1 A12, A22 -= L21 U12
+			trsm(LEFT, LOWER, NO_TRANS, UNIT, 1.0, a.block(k0, k0, kb, kb),
+			     a.block(k0, k0 + kb, kb, m));
+			gemm(NO_TRANS, NO_TRANS, -1.0, a.block(k0 + kb, k0, m, kb),
+			     a.block(k0, k0 + kb, kb, m), 1.0,
+			     a.block(k0 + kb, k0 + kb, m, m));
+		}
+
+		// the work left is that of the trailing matrix, cubic in its size
+		if (checkpoint)
+		{
+			double left = (double)(n - k0 - kb) / n;
+			checkpoint(1.0 - left * left * left);
+		}
+	}
+}
+
+void lu_solve_pivoted(MatrixView<const double> lu, const Vector<int>& ipiv,
+                      MatrixView<double> b)
+{
+	Index n = lu.getNrows();
+
+	if (lu.getNcols() != n || ipiv.size() != n || b.getNrows() != n)
+		throw std::invalid_argument("incompatible matrix sizes");
+
+	MATH_COUNT(CALLS_LU_SOLVE, 1);
+	MATH_COUNT(FLOPS_LU_SOLVE, (2.0 * n * n - n) * b.getNcols());
+	MATH_TRACE_SCOPE("lu_solve");
+
+	if (backend_getrs(lu, ipiv, b))
+		return;
+
+	// B = P B, then L U X = P B by forward and back substitution
+	for (Index k = 0; k < n; k++)
+		if (ipiv[k] != k)
+			swap_rows(b.data(), b.getRowStride(), b.getColStride(), k,
+			          ipiv[k], 0, b.getNcols());
+	trsm(LEFT, LOWER, NO_TRANS, UNIT, 1.0, lu, b);
+	trsm(LEFT, UPPER, NO_TRANS, NON_UNIT, 1.0, lu, b);
+}
+
+// IN-PLACE INVERSION
+// A^-1 = U^-1 L^-1 P from the factorisation PA = LU of lu_fact_pivoted(): U
+// is inverted in place, then X L = U^-1 is solved for X = A^-1 P^T by blocks
+// of columns from the right (as LAPACK's getri), only the columns of L in
+// the current block being copied out, and the columns of X are interchanged
+// last. Besides a, only an n x INVERSE_BLOCK workspace is allocated.
+
+static const int INVERSE_BLOCK = 64;
+
+// B = T B for the upper triangular t, in place: block row I of the result
+// only reads the rows of b from I down, so the blocks are computed from the
+// top
+static void trmm_upper(MatrixView<const double> t, MatrixView<double> b)
+{
+	Index m = t.getNrows(), nc = b.getNcols();
+
+	for (Index i0 = 0; i0 < m; i0 += INVERSE_BLOCK)
+	{
+		Index ib = m - i0 < INVERSE_BLOCK ? m - i0 : INVERSE_BLOCK;
+		Index r = m - i0 - ib;
+
+		// B_I = T_II B_I, then B_I += T_IR B_R for the rows R below
+		for (Index i = i0; i < i0 + ib; i++)
+		{
+			scal(t(i, i), b.row(i));
+			for (Index k = i + 1; k < i0 + ib; k++)
+				axpy(t(i, k), b.row(k), b.row(i));
+		}
+		if (r > 0)
+			gemm(NO_TRANS, NO_TRANS, 1.0, t.block(i0, i0 + ib, ib, r),
+			     b.block(i0 + ib, 0, r, nc), 1.0, b.block(i0, 0, ib, nc));
+	}
+}
+
+// inverts the upper triangular a in place, unblocked (as LAPACK's trti2),
+// row by row bottom up so the inner loops run along the rows
+static void invert_upper_unblocked(MatrixView<double> a)
+{
+	Index n = a.getNrows();
+	Index rs = a.getRowStride();
+	Index cs = a.getColStride();
+	double* p = a.data();
+
+	for (Index i = n - 1; i >= 0; i--)
+	{
+		double* ai = p + i * rs;
+		ai[i * cs] = 1 / ai[i * cs];
+
+		// row i right of the diagonal, -a_ii^-1 u_i U^-1 with the rows of
+		// U^-1 below i already in place; summed from the right, so each
+		// u_ik is read before its place is overwritten
+		for (Index k = n - 1; k > i; k--)
+		{
+			const double* xk = p + k * rs;
+			double s = ai[k * cs];
+			ai[k * cs] = s * xk[k * cs];
+			for (Index j = k + 1; j < n; j++)
+				ai[j * cs] += s * xk[j * cs];
+		}
+		for (Index j = i + 1; j < n; j++)
+			ai[j * cs] *= -ai[i * cs];
+	}
+}
+
+// inverts the upper triangular a in place (as LAPACK's trtri)
+static void invert_upper(MatrixView<double> a)
+{
+	Index n = a.getNrows();
+
+	for (Index j = 0; j < n; j += INVERSE_BLOCK)
+	{
+		Index jb = n - j < INVERSE_BLOCK ? n - j : INVERSE_BLOCK;
+
+		// block column j above the diagonal, -U_00^-1 U_01 U_11^-1
+		trmm_upper(a.block(0, 0, j, j), a.block(0, j, j, jb));
+		trsm(RIGHT, UPPER, NO_TRANS, NON_UNIT, -1.0, a.block(j, j, jb, jb),
+		     a.block(0, j, j, jb));
+		invert_upper_unblocked(a.block(j, j, jb, jb));
+	}
+}
+
+void inverse_inplace(MatrixView<double> a)
+{
+	inverse_inplace(SEQ, a);
+}
+
+void inverse_inplace(ExecutionPolicy policy, MatrixView<double> a)
+{
+	Index n = a.getNrows();
+	Vector<int> ipiv;
+
+	if (a.getNcols() != n)
+		throw std::invalid_argument("matrix is not square");
+
+	MATH_COUNT(CALLS_INVERSE, 1);
+	MATH_COUNT(FLOPS_INVERSE, 4.0 / 3 * n * n * n);
+	MATH_TRACE_SCOPE("inverse");
+
+	lu_fact_pivoted(a, ipiv);  // throws when a is singular
+	invert_upper(a);
+
+	// X L = U^-1, the rows of X being independent
+	Matrix<double> w(n, INVERSE_BLOCK);
+	MatrixView<double> wv = view(w);
+	int nch = policy == SEQ ? 1 : num_chunks(n, 16);
+	for (Index j = (n - 1) / INVERSE_BLOCK * INVERSE_BLOCK; j >= 0;
+	     j -= INVERSE_BLOCK)
+	{
+		Index jb = n - j < INVERSE_BLOCK ? n - j : INVERSE_BLOCK;
+		Index r = n - j - jb;
+
+		// move the columns of L in the block to the workspace; the upper
+		// part of its diagonal block is not read
+		for (Index c = j; c < j + jb; c++)
+			for (Index i = c + 1; i < n; i++)
+			{
+				wv(i, c - j) = a(i, c);
+				a(i, c) = 0;
+			}
+
+		parallel_for(n, nch, [&](Index lo, Index hi, int) {
+			MatrixView<double> x = a.block(lo, j, hi - lo, jb);
+			if (r > 0)
+				gemm(NO_TRANS, NO_TRANS, -1.0,
+				     a.block(lo, j + jb, hi - lo, r),
+				     wv.block(j + jb, 0, r, jb), 1.0, x);
+			trsm(RIGHT, LOWER, NO_TRANS, UNIT, 1.0, wv.block(j, 0, jb, jb),
+			     x);
+		});
+	}
+
+	// A^-1 = X P: column interchanges in the reverse order (the strides
+	// exchanged, swap_rows() swaps columns)
+	for (Index k = n - 1; k >= 0; k--)
+		if (ipiv[k] != k)
+			swap_rows(a.data(), a.getColStride(), a.getRowStride(), k,
+			          ipiv[k], 0, n);
 }
 
 /*
@@ -236,61 +716,169 @@ void lu_fact(const MathMatrix& a, MathMatrix& l, MathMatrix& u, int n)
 * substitution. Output is the solution vector x
 */
 void lu_solve(const MathMatrix& l, const MathMatrix& u, const MathVector& b,
-        int n, MathVector& x)
+        Index n, MathVector& x)
 {
-	int i,j; 
 	MathVector temp = b; // copy b to temp
-    
-	// forward substitution for L y = b.
-	for (i = 1; i < n; i++) 
-		for (j = 0; j < i; j++) 
-			temp[i] -= l(i, j)*temp[j];
-  
-	// back substitution for U x = y.  
-	for (i = n - 1; i >= 0; i--)
-    {
-		for (j = i + 1; j < n; j++)
-            temp[i] -= u(i, j) * temp[j];
-		temp[i] /= u(i, i);
+
+	if (b.size() != n)
+		throw std::invalid_argument("incompatible matrix and vector sizes");
+
+	MATH_COUNT(CALLS_LU_SOLVE, 1);
+	MATH_COUNT(FLOPS_LU_SOLVE, 2.0 * n * n - n);
+	MATH_TRACE_SCOPE("lu_solve");
+
+	// the substitutions run on the selected backend
+	MatrixView<double> t(temp.data(), n, 1, 1);
+
+	// forward substitution for L y = b (the unit diagonal is not read)
+	trsm(LEFT, LOWER, NO_TRANS, UNIT, 1.0, block(l, 0, 0, n, n), t);
+
+	// back substitution for U x = y
+	trsm(LEFT, UPPER, NO_TRANS, NON_UNIT, 1.0, block(u, 0, 0, n, n), t);
+
+	// copy solution into x
+	x = temp;
+}
+
+void lu_solve(const TriangularMatrix<LOWER, UNIT>& l,
+              const TriangularMatrix<UPPER, NON_UNIT>& u, const MathVector& b,
+              MathVector& x)
+{
+	Index n = u.get_size();
+	MathVector temp = b; // copy b to temp
+
+	if (l.get_size() != n || b.size() != n)
+		throw std::invalid_argument("incompatible matrix and vector sizes");
+
+	MATH_COUNT(CALLS_LU_SOLVE, 1);
+	MATH_COUNT(FLOPS_LU_SOLVE, 2.0 * n * n - n);
+	MATH_TRACE_SCOPE("lu_solve");
+
+	// forward substitution for L y = b, back substitution for U x = y
+	MatrixView<double> t(temp.data(), n, 1, 1);
+	trsm(l, t);
+	trsm(u, t);
+
+	// copy solution into x
+	x = temp;
+}
+
+// rows per block of the parallel substitutions
+static const int SOLVE_BLOCK = 256;
+
+void lu_solve(ExecutionPolicy policy, const MathMatrix& l, const MathMatrix& u,
+              const MathVector& b, Index n, MathVector& x)
+{
+	if (policy == SEQ)
+	{
+		lu_solve(l, u, b, n, x);
+		return;
+	}
+
+	Index b0, b1, i, j;
+	Index ls = l.get_size(), us = u.get_size();  // row strides
+	MathVector temp = b; // copy b to temp
+
+	// the substitutions below index the raw storage
+	if (b.size() != n || ls < n || us < n)
+		throw std::invalid_argument("incompatible matrix and vector sizes");
+
+	MATH_COUNT(CALLS_LU_SOLVE, 1);
+	MATH_COUNT(FLOPS_LU_SOLVE, 2.0 * n * n - n);
+	MATH_TRACE_SCOPE("lu_solve");
+	double* t = temp.data();
+	const double* pl = l.data();
+	const double* pu = u.data();
+
+	// forward substitution for L y = b; every row still gets its updates in
+	// the order of the sequential routine, so the result is the same
+	for (b0 = 0; b0 < n; b0 += SOLVE_BLOCK)
+	{
+		b1 = b0 + SOLVE_BLOCK < n ? b0 + SOLVE_BLOCK : n;
+
+		for (i = b0 + 1; i < b1; i++)
+			for (j = b0; j < i; j++)
+				t[i] -= pl[i * ls + j] * t[j];
+
+		parallel_for(n - b1, num_chunks(n - b1, GRAIN),
+		             [&](Index lo, Index hi, int) {
+			for (Index r = b1 + lo; r < b1 + hi; r++)
+				for (Index q = b0; q < b1; q++)
+					t[r] -= pl[r * ls + q] * t[q];
+		});
+	}
+
+	// back substitution for U x = y
+	for (b1 = n; b1 > 0; b1 -= SOLVE_BLOCK)
+	{
+		b0 = b1 - SOLVE_BLOCK > 0 ? b1 - SOLVE_BLOCK : 0;
+
+		for (i = b1 - 1; i >= b0; i--)
+		{
+			for (j = i + 1; j < b1; j++)
+				t[i] -= pu[i * us + j] * t[j];
+			t[i] /= pu[i * us + i];
+		}
+
+		parallel_for(b0, num_chunks(b0, GRAIN), [&](Index lo, Index hi, int) {
+			for (Index r = lo; r < hi; r++)
+				for (Index q = b0; q < b1; q++)
+					t[r] -= pu[r * us + q] * t[q];
+		});
 	}
 
 	// copy solution into x
 	x = temp;
 }
 
-void reorder(const MathMatrix& a, int n, MathMatrix& p)
+void reorder(const MathMatrix& a, Index n, MathMatrix& p)
 {
 // Note: pivoting information is stored in temperary vector pvt
 
-	int i,j,k;
+	Index i,j,k;
 	MathVector pvt(n);
-	int pvtk, pvti;
+	Index pvtk, pvti;
 	MathVector scale(n);
 	double aet, tmp, mult;
 	MathMatrix temp = a; // copy a into temp
+	Index ts = temp.get_size();  // row stride
+
+	// the elimination below indexes the raw storage
+	if (n > ts)
+		throw std::invalid_argument("incompatible matrix sizes");
+
     p = MathMatrix(n);
 
+	MATH_COUNT(CALLS_REORDER, 1);
+	MATH_COUNT(FLOPS_REORDER, elimination_flops(n));
+	MATH_TRACE_SCOPE("reorder");
+
+	// pointers taken once, temp, pvt and scale being written in the loops
+	double* t = temp.data();
+	double* pv = pvt.data();
+	double* sc = scale.data();
+
 	for (k = 0; k < n; k++)
-        pvt[k] = k;
+        pv[k] = k;
 
     // find scale vector
 	for (k = 0; k < n; k++)
     {
-		scale[k] = 0;
+		sc[k] = 0;
 		for (j = 0; j < n; j++) 
-			if (fabs(scale[k]) < fabs(temp(k, j))) 
-                scale[k] = fabs(temp(k, j));
+			if (fabs(sc[k]) < fabs(t[k * ts + j])) 
+                sc[k] = fabs(t[k * ts + j]);
 	} 
 
 	for (k = 0; k < n - 1; k++)
     {            // main elimination loop
 
 	// find the pivot in column k in rows pvt[k], pvt[k+1], ..., pvt[n-1]
-		int pc = k; 
-		aet = fabs(temp(pvt[k], k) / scale[k]);
+		Index pc = k; 
+		aet = fabs(t[(Index)pv[k] * ts + k] / sc[k]);
 		for (i = k + 1; i < n; i++)
         {
-			tmp = fabs(temp(pvt[i], k) / scale[pvt[i]]); 
+			tmp = fabs(t[(Index)pv[i] * ts + k] / sc[(Index)pv[i]]); 
 			if (tmp > aet)
             {
 				aet = tmp; 
@@ -304,27 +892,30 @@ void reorder(const MathMatrix& a, int n, MathMatrix& p)
 		}
 		if (pc != k)
         {                      // swap pvt[k] and pvt[pc]
-			int ii = pvt[k];
-			pvt[k] = pvt[pc];
-			pvt[pc] = ii;
+			Index ii = pv[k];
+			pv[k] = pv[pc];
+			pv[pc] = ii;
 		}
 
 		// now eliminate the column entries logically below mx[pvt[k]][k]
-		pvtk = pvt[k];                           // pivot row
+		pvtk = pv[k];                            // pivot row
+		const double* rk = t + pvtk * ts;
 		for (i = k + 1; i < n; i++)
         {
-			pvti = pvt[i];
-			if (temp(pvti, k) != 0)
+			pvti = pv[i];
+			double* ri = t + pvti * ts;
+			if (ri[k] != 0)
             {
-				mult = temp(pvti, k) / temp(pvtk, k); 
-				temp(pvti, k) = mult;
+				mult = ri[k] / rk[k]; 
+				ri[k] = mult;
 				for (j = k + 1; j < n; j++)
-                    temp(pvti, j) -= mult * temp(pvtk, j);
+                    ri[j] -= mult * rk[j];
 			}
 		}
 	}
+	double* pp = p.data();
 	for (i = 0; i < n; i++)
-        p(i, pvt[i]) = 1.0;
+        pp[i * n + (Index)pv[i]] = 1.0;
 }
 
 // INPUT & OUTPUT 
@@ -333,7 +924,7 @@ std::istream& operator>>(std::istream& is, MathMatrix& m) // keyboard input
 	if (!m.n)
 	{
 		std::cout << "input the size for the square matrix" << std::endl;
-		int n;
+		Index n;
 		is >> n;
 
 		if (n < 0) //check input 
@@ -344,7 +935,7 @@ std::istream& operator>>(std::istream& is, MathMatrix& m) // keyboard input
 
 	// input the elements
 	std::cout << "input " << m.n * m.n << " matrix elements" << std::endl;
-	for (int i = 0; i < m.n*m.n; ++i)
+	for (Index i = 0; i < m.n*m.n; ++i)
 		is >> m.v[i];
 
 	return is; // return the stream object
@@ -354,7 +945,7 @@ std::istream& operator>>(std::istream& is, MathMatrix& m) // keyboard input
 //ie. everything written can be read later.
 std::ifstream& operator>>(std::ifstream& ifs, MathMatrix& m) // file input
 {
-	int n;
+	Index n;
 	ifs >> n; // read size from the file
 
 	if (n < 0) //check input sanity
@@ -362,7 +953,7 @@ std::ifstream& operator>>(std::ifstream& ifs, MathMatrix& m) // file input
 
 	m = MathMatrix(n); // prepare the matrix to hold n elements
 
-	for (int i = 0; i < n * n; ++i) // input the elements
+	for (Index i = 0; i < n * n; ++i) // input the elements
 		ifs >> m.v[i];
 
 	return ifs; // return the stream object
@@ -373,9 +964,9 @@ std::ofstream& operator<<(std::ofstream& ofs, const MathMatrix& m) // file outpu
 	//put square matrix size in first line (even if it is zero)
 	ofs << m.n << std::endl;
 	//put data in second line (if size==zero nothing will be put)
-	for (int i = 0; i < m.n; ++i) 
+	for (Index i = 0; i < m.n; ++i) 
 	{
-		for (int j = 0; j < m.n; ++j) 
+		for (Index j = 0; j < m.n; ++j) 
 			ofs << m(i, j) << " ";
 		ofs << std::endl;
 	}
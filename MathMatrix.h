@@ -5,8 +5,15 @@
 #ifndef MATH_MATRIX_H
 #define MATH_MATRIX_H
 
+#include <functional>
 #include "Matrix.h"
 #include "MathVector.h"
+#include "MathBlas.h"
+#include "view.h"
+#include "Parallel.h"
+
+template <UpLo UPLO, Diag DIAG>
+class TriangularMatrix;  // see Triangular.h
 
 /**
  * @brief Class meant to represent a square matrix of double values.
@@ -15,7 +22,7 @@
  */
 class MathMatrix : public Matrix<double> {
 private:
-    int n;  // Size of the square matrix.
+    Index n;  // Size of the square matrix.
 
 public:
     /**
@@ -26,17 +33,25 @@ public:
     /**
      * @brief An alternate consturctor.
      * @param n Size of the square matrix.
+     * @param init Initialisation of the elements, zero-filled by default.
      *
      * Constructs a square matrix of given size n. It is explicit since implicit
      * type conversion int to MathMatrix doesn't make sense.
      */
-    explicit MathMatrix(int n);
+    explicit MathMatrix(Index n, Initialization init = ZERO_INIT);
 
     /**
      * @brief Returns size of a matrix.
      * @return Size of a matrix.
      */
-    int get_size() const;
+    Index get_size() const;
+
+    /**
+     * @brief Deep copy.
+     * @return Copy of the matrix which shares no elements with it (copies
+     * share them until written, see Vector).
+     */
+    MathMatrix clone() const;
 
     /**
      * @brief Returns 1-norm of a matrix.
@@ -45,8 +60,12 @@ public:
     double one_norm() const;
 
     /**
-     * @brief Returns 2-norm of a matrix.
-     * @return 2-norm of a matrix.
+     * @brief Returns the Frobenius norm of a matrix.
+     * @return Square root of the sum of the squares of the elements.
+     *
+     * Despite its name this is not the matrix 2-norm (the largest singular
+     * value), which spectral_norm() estimates; the Frobenius norm is an upper
+     * bound of it.
      */
     double two_norm() const;
 
@@ -56,6 +75,38 @@ public:
      */
     double uniform_norm() const;
 
+    /**
+     * @brief Returns 1-norm of a matrix.
+     * @param policy Execution policy.
+     * @return 1-norm of a matrix.
+     */
+    double one_norm(ExecutionPolicy policy) const;
+
+    /**
+     * @brief Returns the Frobenius norm of a matrix.
+     * @param policy Execution policy.
+     * @return Square root of the sum of the squares of the elements.
+     */
+    double two_norm(ExecutionPolicy policy) const;
+
+    /**
+     * @brief Returns the spectral norm (matrix 2-norm) of a matrix.
+     * @return Estimate of the largest singular value.
+     *
+     * It runs a SingularValueEstimator (see SingularValues.h) with its
+     * default settings, at a cost of O(k n^2) for k Lanczos steps; use the
+     * estimator directly to set the tolerance or to warm-start repeated
+     * estimates.
+     */
+    double spectral_norm() const;
+
+    /**
+     * @brief Returns uniform norm of a matrix.
+     * @param policy Execution policy.
+     * @return Uniform norm of a matrix.
+     */
+    double uniform_norm(ExecutionPolicy policy) const;
+
     /**
      * @brief Overloaded matrix by matrix multiplication.
      * @param a Matrix to multiply object with.
@@ -74,21 +125,33 @@ public:
      */
     MathVector operator*(const MathVector& v) const;
 
+    /**
+     * @brief Matrix by vector multiplication into a given vector, y = A x.
+     * @param x Vector to multiply object with.
+     * @param y Reference to MathVector for storing the result.
+     *
+     * Unlike operator*, it allocates no memory when y already has the right
+     * size, so it suits loops which multiply repeatedly. x and y may be the
+     * same vector.
+     */
+    void multiply(const MathVector& x, MathVector& y) const;
+
     /**
      * @brief Compute the lower triangular form, L, in the LU factorisation.
-     * @return Lower triangular matrix L.
+     * @return Lower triangular matrix L, of unit diagonal (packed, see
+     * Triangular.h).
      *
      * If both L and U matrices are needed, better use lu_fact() function.
      */
-    MathMatrix compute_lower() const;
+    TriangularMatrix<LOWER, UNIT> compute_lower() const;
 
     /**
      * @brief Compute the upper triangular form, U, in the LU factorisation.
-     * @return Upper triangular matrix U.
+     * @return Upper triangular matrix U (packed, see Triangular.h).
      *
      * If both L and U matrices are needed, better use lu_fact() function.
      */
-    MathMatrix compute_upper() const;
+    TriangularMatrix<UPPER, NON_UNIT> compute_upper() const;
 
     /**
      * @brief Compute the inverse matrix.
@@ -96,6 +159,16 @@ public:
      */
     MathMatrix inverse() const;
 
+    /**
+     * @brief Compute the inverse matrix.
+     * @param policy Execution policy.
+     * @return Inverse matrix.
+     *
+     * The inverse is computed in a copy of the matrix by inverse_inplace().
+     * It throws an exception when the matrix is singular.
+     */
+    MathMatrix inverse(ExecutionPolicy policy) const;
+
     /**
      * @brief Compute the condition number of the matrix.
      * @return Condition number.
@@ -104,6 +177,13 @@ public:
      */
     double condition_num() const;
 
+    /**
+     * @brief Compute the condition number of the matrix.
+     * @param policy Execution policy.
+     * @return Condition number.
+     */
+    double condition_num(ExecutionPolicy policy) const;
+
     // KEYBOARD INPUT
     /**
      * @brief Overloaded stream input operator for keyboard input.
@@ -157,7 +237,97 @@ public:
  * Takes in a matrix of a size n and produces the lower (l) and upper (u)
  * triangular matrices that factorise a.
  */
-void lu_fact(const MathMatrix& a, MathMatrix& l, MathMatrix& u, int n);
+void lu_fact(const MathMatrix& a, MathMatrix& l, MathMatrix& u, Index n);
+
+/**
+ * @brief LU factorisation routine with packed triangular factors.
+ * @param a Input matrix reference.
+ * @param l Reference to the unit lower triangular matrix L.
+ * @param u Reference to the upper triangular matrix U.
+ *
+ * As lu_fact(a, l, u, n) for the full matrices, storing only the triangles
+ * (see Triangular.h).
+ */
+void lu_fact(const MathMatrix& a, TriangularMatrix<LOWER, UNIT>& l,
+             TriangularMatrix<UPPER, NON_UNIT>& u);
+
+/**
+ * @brief In-place LU factorisation routine.
+ * @param a View of the square matrix to factorise.
+ *
+ * Overwrites a with its Doolittle's factorisation: the strictly lower part
+ * holds L (whose unit diagonal is not stored) and the upper part holds U.
+ * As a is a view, a block of a larger matrix can be factorised without
+ * copying it. It throws an exception when a is not square.
+ */
+void lu_fact_inplace(MatrixView<double> a);
+
+/**
+ * @brief In-place LU factorisation with partial pivoting.
+ * @param a View of the square matrix to factorise.
+ * @param ipiv Reference to Vector for storing the pivots: row r was swapped
+ * with row ipiv[r], for r = 0, 1, ..., n-1 in that order. It is resized to
+ * the size of a.
+ *
+ * Overwrites a with the factorisation PA = LU: the strictly lower part holds
+ * L (whose unit diagonal is not stored) and the upper part holds U. Unlike
+ * lu_fact_inplace() it does not fail on a zero pivot, and it runs on the
+ * selected backend (see Backend.h). It throws an exception when a is not
+ * square or is singular, a being then partially factorised.
+ */
+void lu_fact_pivoted(MatrixView<double> a, Vector<int>& ipiv);
+
+/**
+ * @brief In-place LU factorisation with partial pivoting, reporting its
+ * progress.
+ * @param a View of the square matrix to factorise.
+ * @param ipiv Reference to Vector for storing the pivots.
+ * @param checkpoint Function called after every panel with the fraction of
+ * the work done, in [0, 1].
+ *
+ * As lu_fact_pivoted(a, ipiv). checkpoint may throw to abandon the
+ * factorisation, a being then partially factorised. The system library (see
+ * Backend.h) factorises in one step, so checkpoint is then called only once
+ * it has finished.
+ */
+void lu_fact_pivoted(MatrixView<double> a, Vector<int>& ipiv,
+                     const std::function<void(double)>& checkpoint);
+
+/**
+ * @brief Solves the equations AX = B with the factorisation of
+ * lu_fact_pivoted().
+ * @param lu View of the factorisation of A.
+ * @param ipiv Pivots of the factorisation.
+ * @param b View of the right-hand sides, overwritten by the solutions.
+ *
+ * It runs on the selected backend (see Backend.h). It throws an exception
+ * when the sizes of lu, ipiv and b do not match.
+ */
+void lu_solve_pivoted(MatrixView<const double> lu, const Vector<int>& ipiv,
+                      MatrixView<double> b);
+
+/**
+ * @brief In-place inversion.
+ * @param a View of the square matrix to invert, overwritten by its inverse.
+ *
+ * Computes A^-1 = U^-1 L^-1 P from the factorisation of lu_fact_pivoted():
+ * U is inverted in place, then the inverse is found by blocked updates, the
+ * columns of L being moved to a workspace one block at a time, and the
+ * column interchanges of P are applied last. Besides a, it allocates only
+ * the pivots and an n x 64 workspace. It throws an exception when a is not
+ * square or is singular, a being then partially overwritten.
+ */
+void inverse_inplace(MatrixView<double> a);
+
+/**
+ * @brief In-place inversion with execution policy.
+ * @param policy Execution policy.
+ * @param a View of the square matrix to invert, overwritten by its inverse.
+ *
+ * As inverse_inplace(a); with a parallel policy the blocked updates are
+ * split into ranges of rows, which are independent.
+ */
+void inverse_inplace(ExecutionPolicy policy, MatrixView<double> a);
 
 /**
  * @brief Solves the equation LUx = b by performing forward and backward
@@ -171,7 +341,63 @@ void lu_fact(const MathMatrix& a, MathMatrix& l, MathMatrix& u, int n);
  * Output is the solution vector x
  */
 void lu_solve(const MathMatrix& l, const MathMatrix& u, const MathVector& b,
-              int n, MathVector& x);
+              Index n, MathVector& x);
+
+/**
+ * @brief Solves the equation LUx = b with packed triangular factors.
+ * @param l Unit lower triangular matrix.
+ * @param u Upper triangular matrix.
+ * @param b Vector b.
+ * @param x Reference to MathVector for storing resultant vector x.
+ *
+ * It throws an exception when the sizes do not match or u is singular.
+ */
+void lu_solve(const TriangularMatrix<LOWER, UNIT>& l,
+              const TriangularMatrix<UPPER, NON_UNIT>& u, const MathVector& b,
+              MathVector& x);
+
+/**
+ * @brief Solves the equation LUx = b by performing forward and backward
+ * substitution.
+ * @param policy Execution policy.
+ * @param l Lower triangular matrix.
+ * @param u Upper triangular matrix.
+ * @param b Vector b.
+ * @param n Size of a matrix a.
+ * @param x Reference to MathVector for storing resultant vector x.
+ *
+ * With a parallel policy the substitutions run by blocks of rows: the rows
+ * of a block are solved sequentially, then the rows below (or above) it are
+ * updated in parallel. It throws an exception when b is not of size n or l
+ * or u is smaller than n.
+ */
+void lu_solve(ExecutionPolicy policy, const MathMatrix& l, const MathMatrix& u,
+              const MathVector& b, Index n, MathVector& x);
+
+/**
+ * @brief Matrix by matrix multiplication.
+ * @param policy Execution policy.
+ * @param a Left-side matrix.
+ * @param b Right-side matrix.
+ * @return Matrix by matrix multiplication result.
+ *
+ * With a parallel policy the rows of the result are computed in parallel.
+ */
+MathMatrix multiply(ExecutionPolicy policy, const MathMatrix& a,
+                    const MathMatrix& b);
+
+/**
+ * @brief Matrix by vector multiplication.
+ * @param policy Execution policy.
+ * @param a Matrix.
+ * @param v Vector.
+ * @return Matrix by vector multiplication result.
+ *
+ * With a parallel policy the elements of the result are computed in
+ * parallel.
+ */
+MathVector multiply(ExecutionPolicy policy, const MathMatrix& a,
+                    const MathVector& v);
 
 /**
  * @brief Computes the permutation matrix P.
@@ -183,6 +409,8 @@ void lu_solve(const MathMatrix& l, const MathMatrix& u, const MathVector& b,
  * PA = Pb can be solved by forward and backward substitution. Output is the
  * permutation matrix P.
  */
-void reorder(const MathMatrix& a, int n, MathMatrix& p);
+void reorder(const MathMatrix& a, Index n, MathMatrix& p);
+
+#include "Triangular.h"  // needs MathMatrix complete
 
 #endif /* MATH_MATRIX_H */
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "MathRectMatrix.h"
+#include "MathBlas.h"
+
+// CONSTRUCTORS
+MathRectMatrix::MathRectMatrix() : Matrix<double>() {} // default constructor
+
+// alternate constructor
+MathRectMatrix::MathRectMatrix(Index nrows, Index ncols, Initialization init)
+    : Matrix<double>(nrows, ncols, init) {}
+
+// build from any matrix of doubles
+MathRectMatrix::MathRectMatrix(const Matrix<double>& m) : Matrix<double>(m) {}
+
+// overloaded matrix by matrix multiplication
+MathRectMatrix MathRectMatrix::operator*(const MathRectMatrix& a) const
+{
+    if (ncols != a.nrows)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MathRectMatrix res(nrows, a.ncols, UNINITIALIZED);  // gemm does not read it
+
+    gemm(NO_TRANS, NO_TRANS, 1.0, *this, a, 0.0, res);
+
+    return res;
+}
+
+// overloaded multiplication of matrix by a vector
+MathVector MathRectMatrix::operator*(const MathVector& v) const
+{
+    if (ncols != v.size())
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MathVector res(nrows, UNINITIALIZED);  // gemv does not read it
+
+    gemv(NO_TRANS, 1.0, *this, v, 0.0, res);
+
+    return res;
+}
+
+// transposed copy of the matrix
+MathRectMatrix MathRectMatrix::transpose() const
+{
+    Index i, j;
+
+    MathRectMatrix res(ncols, nrows);
+
+    for (i = 0; i < nrows; ++i)
+        for (j = 0; j < ncols; ++j)
+            res(j, i) = (*this)(i, j);
+
+    return res;
+}
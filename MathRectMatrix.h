@@ -0,0 +1,73 @@
+/**
+ * @file MathRectMatrix.h
+ * @brief Header file containing MathRectMatrix class definition.
+ */
+#ifndef MATH_RECT_MATRIX_H
+#define MATH_RECT_MATRIX_H
+
+#include "matrix.h"
+#include "MathVector.h"
+
+/**
+ * @brief Class meant to represent a rectangular matrix of double values.
+ *
+ * This class is derived from Matrix template class. Products are computed by
+ * gemm() and gemv() (see MathBlas.h), which can also be called directly to
+ * multiply by a transposed operand or to accumulate into an existing matrix.
+ */
+class MathRectMatrix : public Matrix<double> {
+public:
+    /**
+     * @brief A default constructor.
+     */
+    MathRectMatrix();
+
+    /**
+     * @brief An alternate constructor.
+     * @param nrows Number of rows.
+     * @param ncols Number of columns.
+     * @param init Initialisation of the elements, zero-filled by default.
+     *
+     * Constructs a zero matrix of given size (unless init is UNINITIALIZED).
+     * It throws an exception when given negative size.
+     */
+    MathRectMatrix(Index nrows, Index ncols,
+                   Initialization init = ZERO_INIT);
+
+    /**
+     * @brief Build a rectangular matrix from any matrix of doubles.
+     * @param m Matrix (eg. a MathMatrix).
+     */
+    MathRectMatrix(const Matrix<double>& m);
+
+    /**
+     * @brief Overloaded matrix by matrix multiplication.
+     * @param a Matrix to multiply object with.
+     * @return Matrix by matrix multiplication result.
+     *
+     * The number of columns of the object has to be equal to the number of
+     * rows of a, otherwise an exception is thrown.
+     */
+    MathRectMatrix operator*(const MathRectMatrix& a) const;
+
+    /**
+     * @brief Overloaded matrix by vector multiplication.
+     * @param v Vector to multiply object with.
+     * @return Matrix by vector multiplication result.
+     *
+     * The number of columns of the object has to be equal to the size of v,
+     * otherwise an exception is thrown.
+     */
+    MathVector operator*(const MathVector& v) const;
+
+    /**
+     * @brief Returns the transposed matrix.
+     * @return Transposed matrix.
+     *
+     * Use gemm() and gemv() with the TRANS flag instead when the transposed
+     * matrix is only needed as an operand of a product.
+     */
+    MathRectMatrix transpose() const;
+};
+
+#endif /* MATH_RECT_MATRIX_H */
@@ -1,12 +1,22 @@
 #include "MathVector.h"
+#include "MathBlas.h"
 #include <cmath>
+#include <vector>
 
 // CONSTRUCTORS
 // default constructor (empty vector)
 MathVector::MathVector() : Vector<double>() {}
 
 // alternate constructor
-MathVector::MathVector(int n) : Vector<double>(n) {}
+MathVector::MathVector(Index n, Initialization init)
+    : Vector<double>(n, init) {}
+
+MathVector MathVector::clone() const
+{
+    MathVector x;
+    x.Vector<double>::operator=(Vector<double>::clone());
+    return x;
+}
 
 double MathVector::one_norm() const
 {
@@ -14,7 +24,7 @@ double MathVector::one_norm() const
 
 	double res = 0;
 
-	for (int i = 0; i < num; ++i)
+	for (Index i = 0; i < num; ++i)
 		res += fabs(pdata[i]);
 
 	return res;
@@ -26,7 +36,7 @@ double MathVector::two_norm() const
 
 	double res = 0;
 
-	for (int i = 0; i < num; ++i)
+	for (Index i = 0; i < num; ++i)
 		res += pdata[i] * pdata[i];
 
 	return sqrt(res);
@@ -38,8 +48,118 @@ double MathVector::uniform_norm() const
 
 	double res = fabs(pdata[0]);
 
-	for (int i = 1; i < num; ++i)
+	for (Index i = 1; i < num; ++i)
 		if (fabs(pdata[i]) > res) res = fabs(pdata[i]);
 
 	return res;
 }
+
+// NORMS WITH EXECUTION POLICY
+// Partial results of the chunks are combined in chunk order, so results are
+// the same from run to run for a given number of threads.
+
+// minimum number of elements per chunk
+static const int GRAIN = 4096;
+
+// sum of f(p[i]) for i in [lo, hi); with simd the sum is split into four
+// independent accumulators, which the compiler can keep in vector registers
+template <typename F>
+static double chunk_sum(const double* p, Index lo, Index hi, bool simd, F f)
+{
+	Index i = lo;
+	double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+	if (simd)
+		for (; i + 3 < hi; i += 4)
+		{
+			s0 += f(p[i]);
+			s1 += f(p[i + 1]);
+			s2 += f(p[i + 2]);
+			s3 += f(p[i + 3]);
+		}
+	for (; i < hi; ++i)
+		s0 += f(p[i]);
+
+	return (s0 + s1) + (s2 + s3);
+}
+
+double MathVector::one_norm(ExecutionPolicy policy) const
+{
+	if (!num) throw std::invalid_argument("incompatible vector size\n"); 
+
+	int nch = policy == SEQ ? 1 : num_chunks(num, GRAIN);
+	std::vector<double> part(nch);
+	const double* p = pdata;
+
+	parallel_for(num, nch, [&](Index lo, Index hi, int c) {
+		part[c] = chunk_sum(p, lo, hi, policy == PAR_SIMD,
+		                    [](double x) { return fabs(x); });
+	});
+
+	double res = 0;
+	for (int c = 0; c < nch; ++c)
+		res += part[c];
+
+	return res;
+}
+
+double MathVector::two_norm(ExecutionPolicy policy) const
+{
+	if (!num) throw std::invalid_argument("incompatible vector size\n"); 
+
+	int nch = policy == SEQ ? 1 : num_chunks(num, GRAIN);
+	std::vector<double> part(nch);
+	const double* p = pdata;
+
+	parallel_for(num, nch, [&](Index lo, Index hi, int c) {
+		part[c] = chunk_sum(p, lo, hi, policy == PAR_SIMD,
+		                    [](double x) { return x * x; });
+	});
+
+	double res = 0;
+	for (int c = 0; c < nch; ++c)
+		res += part[c];
+
+	return sqrt(res);
+}
+
+double MathVector::uniform_norm(ExecutionPolicy policy) const
+{
+	if (!num) throw std::invalid_argument("incompatible vector size\n"); 
+
+	int nch = policy == SEQ ? 1 : num_chunks(num, GRAIN);
+	std::vector<double> part(nch);
+	const double* p = pdata;
+
+	parallel_for(num, nch, [&](Index lo, Index hi, int c) {
+		double res = 0;
+		for (Index i = lo; i < hi; ++i)
+			if (fabs(p[i]) > res) res = fabs(p[i]);
+		part[c] = res;
+	});
+
+	double res = part[0];
+	for (int c = 1; c < nch; ++c)
+		if (part[c] > res) res = part[c];
+
+	return res;
+}
+
+// IN-PLACE OPERATIONS
+MathVector& MathVector::operator+=(const MathVector& v)
+{
+	axpy(1.0, v, *this);
+	return *this;
+}
+
+MathVector& MathVector::operator-=(const MathVector& v)
+{
+	axpy(-1.0, v, *this);
+	return *this;
+}
+
+MathVector& MathVector::operator*=(double alpha)
+{
+	scal(alpha, *this);
+	return *this;
+}
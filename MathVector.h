@@ -6,6 +6,7 @@
 #define MATH_VECTOR_H
 
 #include "vector.h"
+#include "Parallel.h"
 
 /**
  * @brief Class meant to represent a vector of double values.
@@ -22,11 +23,19 @@ public:
     /**
      * @brief An alternate consturctor.
      * @param n Size of the vector.
+     * @param init Initialisation of the elements, zero-filled by default.
      *
      * Constructs a vector of given size n. It is explicit since implicit
      * type conversion int to MathMatrix doesn't make sense.
      */
-    MathVector(int n);
+    MathVector(Index n, Initialization init = ZERO_INIT);
+
+    /**
+     * @brief Deep copy.
+     * @return Copy of the vector which shares no elements with it (copies
+     * share them until written, see Vector).
+     */
+    MathVector clone() const;
 
     /**
      * @brief Returns 1-norm of a vector.
@@ -45,6 +54,53 @@ public:
      * @return Uniform norm of a vector.
      */
     double uniform_norm() const;
+
+    /**
+     * @brief Returns 1-norm of a vector.
+     * @param policy Execution policy.
+     * @return 1-norm of a vector.
+     */
+    double one_norm(ExecutionPolicy policy) const;
+
+    /**
+     * @brief Returns 2-norm of a vector.
+     * @param policy Execution policy.
+     * @return 2-norm of a vector.
+     */
+    double two_norm(ExecutionPolicy policy) const;
+
+    /**
+     * @brief Returns uniform norm of a vector.
+     * @param policy Execution policy.
+     * @return Uniform norm of a vector.
+     */
+    double uniform_norm(ExecutionPolicy policy) const;
+
+    // IN-PLACE OPERATIONS
+    /**
+     * @brief Adds a vector to this one, in place.
+     * @param v Vector of the same size.
+     * @return Reference to this vector.
+     *
+     * It throws an exception when the sizes differ.
+     */
+    MathVector& operator+=(const MathVector& v);
+
+    /**
+     * @brief Subtracts a vector from this one, in place.
+     * @param v Vector of the same size.
+     * @return Reference to this vector.
+     *
+     * It throws an exception when the sizes differ.
+     */
+    MathVector& operator-=(const MathVector& v);
+
+    /**
+     * @brief Multiplies this vector by a scalar, in place.
+     * @param alpha Scalar.
+     * @return Reference to this vector.
+     */
+    MathVector& operator*=(double alpha);
 };
 
 #endif /* MATH_VECTOR_H */
@@ -0,0 +1,121 @@
+#include "Numa.h"
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// largest number of nodes held by a node mask
+static const int MAX_NODES = 1024;
+static const int BITS = 8 * sizeof(unsigned long);
+
+// NODES
+#ifdef __linux__
+// the nodes online are listed as ranges, eg. "0-1" or "0,2-3"; node ids may
+// have holes, so the count is the highest id plus one
+static int count_nodes()
+{
+    std::ifstream ifs("/sys/devices/system/node/online");
+    std::string list;
+    int id = 0, highest = 0;
+    bool digits = false;
+
+    if (!(ifs >> list))
+        return 1;
+
+    for (size_t i = 0; i <= list.size(); ++i)
+    {
+        if (i < list.size() && isdigit((unsigned char)list[i]))
+        {
+            id = 10 * id + (list[i] - '0');
+            digits = true;
+        }
+        else
+        {
+            if (digits && id > highest)
+                highest = id;
+            id = 0;
+            digits = false;
+        }
+    }
+
+    return highest + 1 < MAX_NODES ? highest + 1 : MAX_NODES;
+}
+#endif
+
+int numa_num_nodes()
+{
+#ifdef __linux__
+    static const int nodes = count_nodes();
+    return nodes;
+#else
+    return 1;
+#endif
+}
+
+// PLACEMENT
+#ifdef __linux__
+// policies and flags of mbind (as in numaif.h, which comes with libnuma)
+static const int POLICY_BIND = 2;
+static const int POLICY_INTERLEAVE = 3;
+static const unsigned FLAG_MOVE = 1 << 1;  // migrate the pages touched
+
+// applies a policy to the whole pages of [p, p + bytes)
+static bool set_policy(void* p, size_t bytes, int mode,
+                       const unsigned long* mask)
+{
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t lo = ((uintptr_t)p + page - 1) / page * page;
+    uintptr_t hi = ((uintptr_t)p + bytes) / page * page;
+
+    if (hi <= lo)
+        return false;
+
+    // the kernel reads maxnode - 1 bits of the mask
+    return syscall(SYS_mbind, lo, hi - lo, mode, mask,
+                   (unsigned long)MAX_NODES + 1, FLAG_MOVE) == 0;
+}
+#endif
+
+bool numa_interleave(void* p, size_t bytes)
+{
+    int nodes = numa_num_nodes();
+
+    if (nodes < 2)
+        return false;
+
+#ifdef __linux__
+    unsigned long mask[MAX_NODES / BITS] = {0};
+    for (int i = 0; i < nodes; ++i)
+        mask[i / BITS] |= 1UL << (i % BITS);
+    return set_policy(p, bytes, POLICY_INTERLEAVE, mask);
+#else
+    (void)p;
+    (void)bytes;
+    return false;
+#endif
+}
+
+bool numa_bind(void* p, size_t bytes, int node)
+{
+    int nodes = numa_num_nodes();
+
+    if (node < 0 || node >= nodes)
+        throw std::invalid_argument("NUMA node out of range");
+    if (nodes < 2)
+        return false;
+
+#ifdef __linux__
+    unsigned long mask[MAX_NODES / BITS] = {0};
+    mask[node / BITS] = 1UL << (node % BITS);
+    return set_policy(p, bytes, POLICY_BIND, mask);
+#else
+    (void)p;
+    (void)bytes;
+    return false;
+#endif
+}
@@ -0,0 +1,105 @@
+/**
+ * @file Numa.h
+ * @brief Header file containing the placement of vector and matrix storage
+ * on the NUMA nodes of the machine.
+ *
+ * On a machine with several NUMA nodes (eg. sockets) every node has its own
+ * memory, and a thread reads memory of another node at a fraction of the
+ * local bandwidth. By default a page is placed on the node of the thread
+ * which touches it first (see first_touch()). The routines below override
+ * this for a range of memory: interleaved page by page over all the nodes,
+ * which spreads the traffic when every thread reads all of the data, or
+ * bound to one node.
+ *
+ * The placement applies to the pages not touched yet, and pages already
+ * touched are migrated, so it is cheapest to set it on storage constructed
+ * UNINITIALIZED, before filling it. Only the whole pages of the range are
+ * affected. Placement is supported on Linux only (through the mbind system
+ * call); elsewhere, and on machines with a single node, the routines do
+ * nothing and return false.
+ */
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include "vector.h"
+#include "matrix.h"
+
+/**
+ * @brief Returns the number of NUMA nodes.
+ * @return Number of nodes online, 1 where NUMA is not supported.
+ */
+int numa_num_nodes();
+
+/**
+ * @brief Interleaves memory page by page over all the NUMA nodes.
+ * @param p Start of the memory.
+ * @param bytes Size of the memory in bytes.
+ * @return True when the placement was applied.
+ */
+bool numa_interleave(void* p, size_t bytes);
+
+/**
+ * @brief Binds memory to a NUMA node.
+ * @param p Start of the memory.
+ * @param bytes Size of the memory in bytes.
+ * @param node Node, in [0, numa_num_nodes()).
+ * @return True when the placement was applied.
+ *
+ * It throws an exception when node is out of range.
+ */
+bool numa_bind(void* p, size_t bytes, int node);
+
+/**
+ * @brief Interleaves the elements of a vector over all the NUMA nodes.
+ * @param v Vector.
+ * @return True when the placement was applied.
+ */
+template <typename T>
+bool numa_interleave(Vector<T>& v)
+{
+    return numa_interleave(v.data(), v.size() * sizeof(T));
+}
+
+/**
+ * @brief Interleaves the elements of a matrix over all the NUMA nodes.
+ * @param m Matrix.
+ * @return True when the placement was applied.
+ */
+template <typename T, typename L>
+bool numa_interleave(Matrix<T, L>& m)
+{
+    return numa_interleave(m.data(),
+                           L::size(m.getNrows(), m.getNcols()) * sizeof(T));
+}
+
+/**
+ * @brief Binds the elements of a vector to a NUMA node.
+ * @param v Vector.
+ * @param node Node, in [0, numa_num_nodes()).
+ * @return True when the placement was applied.
+ *
+ * It throws an exception when node is out of range.
+ */
+template <typename T>
+bool numa_bind(Vector<T>& v, int node)
+{
+    return numa_bind(v.data(), v.size() * sizeof(T), node);
+}
+
+/**
+ * @brief Binds the elements of a matrix to a NUMA node.
+ * @param m Matrix.
+ * @param node Node, in [0, numa_num_nodes()).
+ * @return True when the placement was applied.
+ *
+ * It throws an exception when node is out of range.
+ */
+template <typename T, typename L>
+bool numa_bind(Matrix<T, L>& m, int node)
+{
+    return numa_bind(m.data(), L::size(m.getNrows(), m.getNcols()) * sizeof(T),
+                     node);
+}
+
+#endif /* NUMA_H */
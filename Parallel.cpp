@@ -0,0 +1,54 @@
+#include "Parallel.h"
+#include <mutex>
+#include <stdexcept>
+
+// library-wide thread pool and its settings
+static TaskScheduler* pool = 0;
+static int pool_threads = 0;
+static bool pool_pin = false;
+static std::mutex pool_mutex;
+
+TaskScheduler& default_scheduler()
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!pool)
+        pool = new TaskScheduler(pool_threads, pool_pin);
+    return *pool;
+}
+
+void set_num_threads(int n)
+{
+    if (n < 0)
+        throw std::invalid_argument("number of threads negative");
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    pool_threads = n;
+    delete pool;  // recreated with the new size on next use
+    pool = 0;
+}
+
+int get_num_threads()
+{
+    return default_scheduler().num_threads();
+}
+
+void set_thread_pinning(bool pin)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    pool_pin = pin;
+    delete pool;  // recreated with the new setting on next use
+    pool = 0;
+}
+
+int num_chunks(Index n, Index grain)
+{
+    Index nthreads = get_num_threads();
+    Index chunks;
+
+    if (grain < 1)
+        grain = 1;
+    chunks = n / grain;
+    if (chunks > nthreads)
+        chunks = nthreads;
+    return chunks > 1 ? (int)chunks : 1;
+}
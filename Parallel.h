@@ -0,0 +1,130 @@
+/**
+ * @file Parallel.h
+ * @brief Header file containing the library-wide thread pool, the execution
+ * policies and the parallel loop used by the numeric routines.
+ */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "Index.h"
+#include "TaskScheduler.h"
+
+/**
+ * @brief Tells how a numeric routine is executed.
+ *
+ * Routines taking no policy run sequentially, exactly as before policies
+ * were introduced.
+ */
+enum ExecutionPolicy {
+    SEQ,      ///< Sequential execution on the calling thread.
+    PAR,      ///< Parallel execution on the library thread pool.
+    PAR_SIMD  ///< Parallel execution, reductions reassociated for SIMD.
+};
+
+/**
+ * @brief Returns the library-wide thread pool.
+ * @return Thread pool, created on first use.
+ */
+TaskScheduler& default_scheduler();
+
+/**
+ * @brief Sets the number of threads of the library-wide thread pool.
+ * @param n Number of threads, 0 means one per hardware thread.
+ *
+ * The pool is recreated, so this must not be called while any parallel
+ * routine is running.
+ */
+void set_num_threads(int n);
+
+/**
+ * @brief Returns the number of threads of the library-wide thread pool.
+ * @return Number of threads.
+ */
+int get_num_threads();
+
+/**
+ * @brief Sets whether the threads of the library-wide thread pool are pinned
+ * to CPUs.
+ * @param pin True to pin worker i to CPU i.
+ *
+ * The pool is recreated, so this must not be called while any parallel
+ * routine is running.
+ */
+void set_thread_pinning(bool pin);
+
+/**
+ * @brief Number of chunks a parallel loop is split into.
+ * @param n Number of iterations.
+ * @param grain Minimum number of iterations per chunk.
+ * @return Number of chunks, at least 1.
+ *
+ * The result depends only on n, grain and the size of the thread pool, so
+ * the chunks, and the order in which partial results of a reduction are
+ * combined, are the same from run to run.
+ */
+int num_chunks(Index n, Index grain);
+
+/**
+ * @brief Parallel loop over the iterations [0, n) split into chunks.
+ * @param n Number of iterations.
+ * @param nchunks Number of chunks (see num_chunks()).
+ * @param fn Function called as fn(lo, hi, c) for the iterations [lo, hi) of
+ * chunk c, lo and hi being of type Index.
+ *
+ * Chunk c covers the iterations [c * n / nchunks, (c + 1) * n / nchunks)
+ * and is queued on worker c (modulo the size of the pool), so loops over the
+ * same range with the same number of chunks run each chunk on the same
+ * thread (see first_touch()). Inside a task of any scheduler the chunks run
+ * one after another on the calling thread, so nested parallel routines do
+ * not oversubscribe cores, unless the task opened a
+ * TaskScheduler::ForkScope. The first exception thrown by fn is rethrown.
+ */
+template <typename F>
+void parallel_for(Index n, int nchunks, F fn)
+{
+    int c;
+
+    if (nchunks < 1)
+        nchunks = 1;
+
+    if (nchunks == 1 ||
+        (TaskScheduler::in_worker() && !TaskScheduler::in_fork_scope()))
+    {
+        for (c = 0; c < nchunks; ++c)
+            fn(c * n / nchunks, (c + 1) * n / nchunks, c);
+        return;
+    }
+
+    TaskGraph graph;
+    for (c = 0; c < nchunks; ++c)
+    {
+        Index lo = c * n / nchunks;
+        Index hi = (c + 1) * n / nchunks;
+        graph.add([=] { fn(lo, hi, c); }, c);
+    }
+    graph.run(default_scheduler());
+}
+
+/**
+ * @brief Zero-fills an array in parallel, by blocks of rows.
+ * @param p Array of nrows * ncols elements.
+ * @param nrows Number of rows.
+ * @param ncols Number of elements per row.
+ *
+ * Operating systems place a page of memory on the NUMA node of the thread
+ * which writes it first. The rows are split into chunks as by the threaded
+ * routines of the library (parallel_for() with num_chunks() chunks, one per
+ * thread for large sizes), so each block of rows lands on the node of the
+ * thread that later works on it. Zero-filling on one thread would place the
+ * whole array on a single node instead.
+ */
+template <typename T>
+void first_touch(T* p, Index nrows, Index ncols)
+{
+    parallel_for(nrows, num_chunks(nrows, 1), [=](Index lo, Index hi, int) {
+        for (Index i = lo * ncols; i < hi * ncols; ++i)
+            p[i] = 0.0;
+    });
+}
+
+#endif /* PARALLEL_H */
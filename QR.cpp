@@ -0,0 +1,303 @@
+#include "QR.h"
+#include "MathBlas.h"
+#include "Trace.h"
+#include <cmath>
+#include <stdexcept>
+
+// HOUSEHOLDER REFLECTORS
+// Generates H = I - tau v v^T with v = (1, x[1:]) such that H x = (beta, 0,
+// ..., 0); x is overwritten by (beta, v[1:]) (as LAPACK dlarfg).
+static double householder(VectorView<double> x)
+{
+    Index n = x.size();
+    double alpha, beta, xnorm, tau;
+
+    if (n <= 1)
+        return 0;
+
+    VectorView<double> rest(x.data() + x.getStride(), n - 1, x.getStride());
+    xnorm = nrm2(rest);
+    if (xnorm == 0)
+        return 0;  // H = I
+
+    alpha = x[0];
+    beta = -copysign(hypot(alpha, xnorm), alpha);
+    tau = (beta - alpha) / beta;
+    scal(1 / (alpha - beta), rest);
+    x[0] = beta;
+
+    return tau;
+}
+
+// C = H C for H = I - tau v v^T, v of size m with v[0] = 1 implicitly
+// stored as v[0] = 1 by the caller
+static void apply_reflector(VectorView<const double> v, double tau,
+                            MatrixView<double> c)
+{
+    if (tau == 0)
+        return;
+
+    for (Index j = 0; j < c.getNcols(); ++j)
+    {
+        VectorView<double> cj = c.column(j);
+        axpy(-tau * dot(v, cj), v, cj);
+    }
+}
+
+// BLOCK REFLECTORS
+// v is the m x jb unit lower trapezoidal matrix of a block of reflectors
+// (the ones on the diagonal and the upper part are not referenced), t the
+// jb x jb upper triangular factor and w a jb x nc workspace; computes
+// C = (I - V T V^T) C, or with trans C = (I - V T^T V^T) C (as LAPACK
+// dlarfb). V1 denotes the first jb rows of V, V2 the others, likewise C.
+static void apply_block(MatrixView<const double> v, MatrixView<const double> t,
+                        bool trans, MatrixView<double> c, MatrixView<double> w)
+{
+    Index m = v.getNrows(), jb = v.getNcols(), nc = c.getNcols();
+    Index i, p, j;
+
+    if (nc == 0)
+        return;
+
+    // W = V^T C = V1^T C1 + V2^T C2
+    for (i = 0; i < jb; ++i)
+        copy(c.row(i), w.row(i));
+    for (i = 0; i < jb; ++i)
+        for (p = i + 1; p < jb; ++p)
+            axpy(v(p, i), w.row(p), w.row(i));  // V1^T is unit upper
+    if (m > jb)
+        gemm(TRANS, NO_TRANS, 1.0, v.block(jb, 0, m - jb, jb),
+             c.block(jb, 0, m - jb, nc), 1.0, w);
+
+    // W = T W or T^T W
+    if (trans)
+    {
+        for (i = jb - 1; i >= 0; --i)
+        {
+            scal(t(i, i), w.row(i));
+            for (p = 0; p < i; ++p)
+                axpy(t(p, i), w.row(p), w.row(i));
+        }
+    }
+    else
+    {
+        for (i = 0; i < jb; ++i)
+        {
+            scal(t(i, i), w.row(i));
+            for (p = i + 1; p < jb; ++p)
+                axpy(t(i, p), w.row(p), w.row(i));
+        }
+    }
+
+    // C = C - V W: C2 -= V2 W, C1 -= V1 W
+    if (m > jb)
+        gemm(NO_TRANS, NO_TRANS, -1.0, v.block(jb, 0, m - jb, jb), w, 1.0,
+             c.block(jb, 0, m - jb, nc));
+    for (i = jb - 1; i >= 0; --i)
+    {
+        for (p = 0; p < i; ++p)
+            axpy(v(i, p), w.row(p), w.row(i));  // V1 is unit lower
+        for (j = 0; j < nc; ++j)
+            c(i, j) -= w(i, j);
+    }
+}
+
+// FACTORISATION
+QRFactorization::QRFactorization() : qr(), tau(), t(), nb(32) {}
+
+QRFactorization::QRFactorization(const Matrix<double>& a, int nb)
+    : qr(), tau(), t(), nb(nb)
+{
+    factor(a, nb);
+}
+
+void QRFactorization::factor(const Matrix<double>& a, int block)
+{
+    MATH_TRACE_SCOPE("qr");
+
+    if (block <= 0)
+        throw std::invalid_argument("block size not positive");
+
+    Index m = a.getNrows(), n = a.getNcols();
+    Index k = m < n ? m : n;
+    Index j0, jb, j, i;
+
+    nb = block;
+    qr = a;
+    tau = MathVector(k);
+    t = Matrix<double>(nb, k);
+    if (k == 0)
+        return;
+
+    MatrixView<double> av = view(qr);
+    Matrix<double> work(nb, n);
+
+    for (j0 = 0; j0 < k; j0 += nb)
+    {
+        jb = k - j0 < nb ? k - j0 : nb;
+        MatrixView<double> v = av.block(j0, j0, m - j0, jb);
+
+        // factorise the panel one reflector at a time
+        for (j = 0; j < jb; ++j)
+        {
+            VectorView<double> x = v.block(j, j, m - j0 - j, 1).column(0);
+            tau[j0 + j] = householder(x);
+
+            double beta = x[0];
+            x[0] = 1;
+            apply_reflector(x, tau[j0 + j],
+                            v.block(j, j + 1, m - j0 - j, jb - j - 1));
+            x[0] = beta;
+        }
+
+        // T of the block (as LAPACK dlarft): T(0:j, j) = -tau_j T(0:j, 0:j)
+        // V(:, 0:j)^T v_j
+        MatrixView<double> tb = view(t).block(0, j0, jb, jb);
+        for (j = 0; j < jb; ++j)
+        {
+            double tj = tau[j0 + j];
+            for (i = 0; i < j; ++i)
+            {
+                // V(:, i)^T v_j, over the rows where v_j is nonzero
+                double s = v(j, i);
+                for (Index r = j + 1; r < m - j0; ++r)
+                    s += v(r, i) * v(r, j);
+                tb(i, j) = -tj * s;
+            }
+            for (i = 0; i < j; ++i)
+            {
+                // T(0:j, 0:j) is upper triangular, row i uses rows >= i
+                double s = 0;
+                for (Index p = i; p < j; ++p)
+                    s += tb(i, p) * tb(p, j);
+                tb(i, j) = s;
+            }
+            tb(j, j) = tj;
+            for (i = j + 1; i < jb; ++i)
+                tb(i, j) = 0;
+        }
+
+        // update the columns right of the block: C = (I - V T^T V^T) C
+        if (j0 + jb < n)
+            apply_block(v, tb, true,
+                        av.block(j0, j0 + jb, m - j0, n - j0 - jb),
+                        view(work).block(0, 0, jb, n - j0 - jb));
+    }
+}
+
+Index QRFactorization::getNrows() const
+{
+    return qr.getNrows();
+}
+
+Index QRFactorization::getNcols() const
+{
+    return qr.getNcols();
+}
+
+// FACTORS
+MathRectMatrix QRFactorization::r() const
+{
+    Index m = qr.getNrows(), n = qr.getNcols();
+    Index k = m < n ? m : n;
+    MathRectMatrix res(k, n);
+
+    for (Index i = 0; i < k; ++i)
+        for (Index j = i; j < n; ++j)
+            res(i, j) = qr(i, j);
+
+    return res;
+}
+
+MathRectMatrix QRFactorization::economy_q() const
+{
+    Index m = qr.getNrows(), n = qr.getNcols();
+    Index k = m < n ? m : n;
+    MathRectMatrix q(m, k);
+
+    for (Index i = 0; i < k; ++i)
+        q(i, i) = 1.0;
+    apply(view(q), false);
+
+    return q;
+}
+
+// APPLICATION OF Q
+// Q = B_1 B_2 ... for the block reflectors B_j = I - V_j T_j V_j^T, so Q C
+// applies the blocks last to first and Q^T C first to last, with T_j^T.
+void QRFactorization::apply(MatrixView<double> c, bool trans) const
+{
+    Index m = qr.getNrows(), n = qr.getNcols();
+    Index k = m < n ? m : n;
+    Index nblocks = (k + nb - 1) / nb;
+    Index b, j0, jb;
+
+    if (c.getNrows() != m)
+        throw std::invalid_argument("incompatible matrix sizes");
+    if (k == 0 || c.getNcols() == 0)
+        return;
+
+    MatrixView<const double> av = view(qr);
+    MatrixView<const double> tv = view(t);
+    Matrix<double> work(nb, c.getNcols());
+
+    for (b = 0; b < nblocks; ++b)
+    {
+        j0 = (trans ? b : nblocks - 1 - b) * nb;
+        jb = k - j0 < nb ? k - j0 : nb;
+        apply_block(av.block(j0, j0, m - j0, jb), tv.block(0, j0, jb, jb),
+                    trans, c.block(j0, 0, m - j0, c.getNcols()),
+                    view(work).block(0, 0, jb, c.getNcols()));
+    }
+}
+
+void QRFactorization::apply_qt(MathRectMatrix& c) const
+{
+    apply(view(c), true);
+}
+
+void QRFactorization::apply_q(MathRectMatrix& c) const
+{
+    apply(view(c), false);
+}
+
+void QRFactorization::apply_qt(MathVector& b) const
+{
+    if (b.size() != qr.getNrows())
+        throw std::invalid_argument("incompatible matrix and vector sizes");
+    apply(MatrixView<double>(b.data(), b.size(), 1, 1), true);
+}
+
+void QRFactorization::apply_q(MathVector& b) const
+{
+    if (b.size() != qr.getNrows())
+        throw std::invalid_argument("incompatible matrix and vector sizes");
+    apply(MatrixView<double>(b.data(), b.size(), 1, 1), false);
+}
+
+// LEAST SQUARES
+MathVector QRFactorization::solve(const MathVector& b) const
+{
+    Index m = qr.getNrows(), n = qr.getNcols();
+    Index i, j;
+
+    if (m < n)
+        throw std::invalid_argument("more columns than rows");
+
+    MathVector y = b;  // copy b to y
+    apply_qt(y);
+
+    // back substitution for R x = y[0, n)
+    MathVector x(n);
+    for (i = n - 1; i >= 0; --i)
+    {
+        if (qr(i, i) == 0)
+            throw std::runtime_error("matrix is rank deficient");
+        double s = y[i];
+        for (j = i + 1; j < n; ++j)
+            s -= qr(i, j) * x[j];
+        x[i] = s / qr(i, i);
+    }
+
+    return x;
+}
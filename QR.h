@@ -0,0 +1,138 @@
+/**
+ * @file QR.h
+ * @brief Header file containing the blocked Householder QR factorisation and
+ * the least-squares solver.
+ */
+#ifndef QR_H
+#define QR_H
+
+#include "MathRectMatrix.h"
+#include "MathVector.h"
+#include "view.h"
+
+/**
+ * @brief Class meant to represent the QR factorisation A = QR of an m x n
+ * matrix.
+ *
+ * Q is the product H_1 H_2 ... H_k (k = min(m, n)) of Householder reflectors
+ * H_i = I - tau_i v_i v_i^T and R is upper triangular. As in LAPACK the
+ * factorisation is kept in factored form: R on and above the diagonal of an
+ * m x n matrix, the vectors v_i (with an implicit leading 1) below it, and
+ * for every block of nb reflectors the upper triangular nb x nb matrix T of
+ * its compact WY representation, H_j ... H_{j+nb-1} = I - V T V^T. The
+ * trailing updates of the factorisation and the applications of Q then run
+ * as matrix products (gemm()) instead of one reflector at a time.
+ *
+ * Q is never formed unless asked for by economy_q().
+ */
+class QRFactorization {
+private:
+    MathRectMatrix qr;    // R and the Householder vectors
+    MathVector tau;       // scaling factors of the reflectors
+    Matrix<double> t;     // T factors, block j in columns [j nb, j nb + jb)
+    int nb;               // block size
+
+    void apply(MatrixView<double> c, bool trans) const;
+
+public:
+    /**
+     * @brief Default constructor, an empty factorisation.
+     */
+    QRFactorization();
+
+    /**
+     * @brief Alternate constructor, factorises a matrix.
+     * @param a Matrix to factorise.
+     * @param nb Block size (number of reflectors per block).
+     *
+     * See factor().
+     */
+    explicit QRFactorization(const Matrix<double>& a, int nb = 32);
+
+    /**
+     * @brief Factorises a matrix.
+     * @param a Matrix to factorise.
+     * @param nb Block size (number of reflectors per block).
+     *
+     * Every block of columns is factorised one reflector at a time, then the
+     * columns right of it are updated at once by its block reflector.
+     *
+     * It throws an exception when nb is not positive.
+     */
+    void factor(const Matrix<double>& a, int nb = 32);
+
+    /**
+     * @brief Get the number of rows of the factorised matrix.
+     * @return Number of rows m.
+     */
+    Index getNrows() const;
+
+    /**
+     * @brief Get the number of columns of the factorised matrix.
+     * @return Number of columns n.
+     */
+    Index getNcols() const;
+
+    /**
+     * @brief Returns the factor R.
+     * @return min(m, n) x n upper triangular (trapezoidal) matrix R.
+     */
+    MathRectMatrix r() const;
+
+    /**
+     * @brief Returns the economy-size factor Q.
+     * @return m x min(m, n) matrix of orthonormal columns, the first columns
+     * of Q, such that A = Q R.
+     *
+     * The columns are computed by applying the block reflectors to the first
+     * columns of the identity.
+     */
+    MathRectMatrix economy_q() const;
+
+    /**
+     * @brief Computes Q^T C in place.
+     * @param c Matrix with m rows.
+     *
+     * It throws an exception when c does not have m rows.
+     */
+    void apply_qt(MathRectMatrix& c) const;
+
+    /**
+     * @brief Computes Q C in place.
+     * @param c Matrix with m rows.
+     *
+     * It throws an exception when c does not have m rows.
+     */
+    void apply_q(MathRectMatrix& c) const;
+
+    /**
+     * @brief Computes Q^T b in place.
+     * @param b Vector of size m.
+     *
+     * It throws an exception when b is not of size m.
+     */
+    void apply_qt(MathVector& b) const;
+
+    /**
+     * @brief Computes Q b in place.
+     * @param b Vector of size m.
+     *
+     * It throws an exception when b is not of size m.
+     */
+    void apply_q(MathVector& b) const;
+
+    /**
+     * @brief Solves the least-squares problem min |A x - b|.
+     * @param b Vector of size m.
+     * @return Solution x, of size n.
+     *
+     * The solution is x = R^-1 (Q^T b)[0, n). Unlike the normal equations
+     * A^T A x = A^T b, this does not square the condition number of A.
+     *
+     * It throws an exception when m < n, when b is not of size m, or when A
+     * is rank deficient (R has a zero on its diagonal).
+     */
+    MathVector solve(const MathVector& b) const;
+};
+
+#endif /* QR_H */
@@ -0,0 +1,431 @@
+#include "SharedMatrix.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#define SHARED_SEGMENTS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// INDEX SEGMENT
+// Zero-filled when created: nothing published yet. The generations are
+// switched by atomic operations on the shared memory, which work between
+// processes when they are lock-free.
+struct SegmentIndex {
+    std::atomic<uint64_t> last;     // last generation created
+    std::atomic<uint64_t> current;  // generation published, 0 if none
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "generations need lock-free atomics");
+
+// longest name accepted, leaving room for the generation suffix
+static const size_t MAX_NAME = 251;
+
+static void check_name(const std::string& name)
+{
+    if (name.size() < 2 || name.size() > MAX_NAME || name[0] != '/' ||
+        name.find('/', 1) != std::string::npos)
+        throw std::invalid_argument("invalid shared memory name " + name);
+}
+
+static std::string segment_name(const std::string& name, uint64_t generation)
+{
+    return name + "." + std::to_string(generation);
+}
+
+#ifdef SHARED_SEGMENTS
+static const mode_t SEGMENT_MODE = 0600;
+
+// maps the index of a name, created when create is set, writable when
+// writable is set; returns 0 when it does not exist or is not yet sized by
+// its creator
+static SegmentIndex* map_index(const std::string& name, bool create,
+                               bool writable)
+{
+    struct stat st;
+    int flags = create ? O_RDWR | O_CREAT : writable ? O_RDWR : O_RDONLY;
+    int fd = shm_open(name.c_str(), flags, SEGMENT_MODE);
+    if (fd < 0)
+    {
+        if (!create && errno == ENOENT)
+            return 0;
+        throw std::runtime_error("cannot open shared memory " + name);
+    }
+
+    // concurrent creators size it alike, zero-filled
+    if (fstat(fd, &st) == 0 && st.st_size == 0 && create &&
+        ftruncate(fd, sizeof(SegmentIndex)) == 0)
+        st.st_size = sizeof(SegmentIndex);
+    if (st.st_size != (off_t)sizeof(SegmentIndex))
+    {
+        close(fd);
+        if (!create && st.st_size == 0)
+            return 0;
+        throw std::runtime_error(name + " is not a shared matrix");
+    }
+
+    void* p = mmap(0, sizeof(SegmentIndex),
+                   create || writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::runtime_error("cannot map shared memory " + name);
+    return (SegmentIndex*)p;
+}
+
+static void unmap_index(void* index)
+{
+    if (index)
+        munmap(index, sizeof(SegmentIndex));
+}
+#else
+static void unmap_index(void*) {}
+#endif
+
+// SHARED SEGMENT
+SharedSegment::SharedSegment()
+    : generation(0), index(0), map(0), map_size(0), writable(false)
+{}
+
+SharedSegment::~SharedSegment()
+{
+    release();
+}
+
+void SharedSegment::release()
+{
+#ifdef SHARED_SEGMENTS
+    if (map)
+        munmap(map, map_size);
+    if (writable)
+        shm_unlink(segment_name(name, generation).c_str());
+#endif
+    unmap_index(index);
+    name.clear();
+    generation = 0;
+    index = 0;
+    map = 0;
+    map_size = 0;
+    writable = false;
+}
+
+void SharedSegment::create(const std::string& nm, size_t size)
+{
+    check_name(nm);
+#ifdef SHARED_SEGMENTS
+    SegmentIndex* idx = map_index(nm, true, true);
+    uint64_t gen = idx->last.fetch_add(1) + 1;
+    std::string seg = segment_name(nm, gen);
+
+    int fd = shm_open(seg.c_str(), O_RDWR | O_CREAT | O_EXCL, SEGMENT_MODE);
+    if (fd < 0)
+    {
+        unmap_index(idx);
+        throw std::runtime_error("cannot create shared memory " + seg);
+    }
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        p = mmap(0, size ? size : 1, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(seg.c_str());
+        unmap_index(idx);
+        throw std::runtime_error("cannot map shared memory " + seg);
+    }
+
+    release();
+    name = nm;
+    generation = gen;
+    index = idx;
+    map = p;
+    map_size = size ? size : 1;
+    writable = true;
+#else
+    (void)size;
+    throw std::runtime_error("shared memory not supported");
+#endif
+}
+
+bool SharedSegment::publish()
+{
+    if (!writable)
+        throw std::logic_error("no shared memory segment created");
+
+#ifdef SHARED_SEGMENTS
+    SegmentIndex* idx = (SegmentIndex*)index;
+    uint64_t old = idx->current.load(std::memory_order_acquire);
+
+    // the contents written are visible to the processes which read the new
+    // generation; an older one is never published over a newer one
+    while (old < generation &&
+           !idx->current.compare_exchange_weak(old, generation,
+                                               std::memory_order_acq_rel))
+        ;
+    if (old > generation)
+    {
+        release();
+        return false;
+    }
+
+    if (old != 0)
+        shm_unlink(segment_name(name, old).c_str());
+    mprotect(map, map_size, PROT_READ);
+    writable = false;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SharedSegment::attach(const std::string& nm)
+{
+    check_name(nm);
+#ifdef SHARED_SEGMENTS
+    SegmentIndex* idx = map_index(nm, false, false);
+    if (!idx)
+        throw std::runtime_error("nothing published as " + nm);
+
+    // a generation replaced between reading the index and opening it is
+    // unlinked already: read the index again
+    uint64_t gen = idx->current.load(std::memory_order_acquire);
+    int fd = -1;
+    while (gen != 0)
+    {
+        fd = shm_open(segment_name(nm, gen).c_str(), O_RDONLY, 0);
+        if (fd >= 0)
+            break;
+        uint64_t now = idx->current.load(std::memory_order_acquire);
+        if (errno != ENOENT || now == gen)
+            gen = 0;
+        else
+            gen = now;
+    }
+    if (gen == 0)
+    {
+        unmap_index(idx);
+        throw std::runtime_error("nothing published as " + nm);
+    }
+
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        unmap_index(idx);
+        throw std::runtime_error("cannot map shared memory " + nm);
+    }
+
+    release();
+    name = nm;
+    generation = gen;
+    index = idx;
+    map = p;
+    map_size = st.st_size;
+#else
+    throw std::runtime_error("shared memory not supported");
+#endif
+}
+
+bool SharedSegment::is_current() const
+{
+    return index && !writable &&
+           ((const SegmentIndex*)index)->current.load(
+               std::memory_order_acquire) == generation;
+}
+
+uint64_t SharedSegment::get_generation() const
+{
+    return generation;
+}
+
+const std::string& SharedSegment::get_name() const
+{
+    return name;
+}
+
+size_t SharedSegment::size() const
+{
+    return map_size;
+}
+
+char* SharedSegment::writable_data()
+{
+    if (!writable)
+        throw std::logic_error("shared memory segment is read-only");
+    return (char*)map;
+}
+
+const char* SharedSegment::data() const
+{
+    return (const char*)map;
+}
+
+void SharedSegment::swap(SharedSegment& s)
+{
+    std::swap(name, s.name);
+    std::swap(generation, s.generation);
+    std::swap(index, s.index);
+    std::swap(map, s.map);
+    std::swap(map_size, s.map_size);
+    std::swap(writable, s.writable);
+}
+
+void SharedSegment::remove(const std::string& nm)
+{
+    check_name(nm);
+#ifdef SHARED_SEGMENTS
+    SegmentIndex* idx = map_index(nm, false, true);
+    if (!idx)
+        return;
+
+    // attached processes see that their generation is no longer current
+    uint64_t gen = idx->current.exchange(0, std::memory_order_acq_rel);
+    if (gen != 0)
+        shm_unlink(segment_name(nm, gen).c_str());
+    shm_unlink(nm.c_str());
+    unmap_index(idx);
+#endif
+}
+
+// MATRIX FORMAT
+// header, then the elements row-major from ELEMENTS_OFFSET
+static const char MAGIC[8] = {'M', 'A', 'T', 'H', 'S', 'H', 'M', '\n'};
+static const uint32_t VERSION = 1;
+static const uint32_t ENDIAN_MARK = 0x01020304;
+static const int64_t ELEMENTS_OFFSET = 64;
+
+struct MatrixHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;  // ENDIAN_MARK as written by the publisher
+    int64_t nrows;
+    int64_t ncols;
+};
+
+uint64_t publish_matrix(const std::string& name, MatrixView<const double> a)
+{
+    Index r = a.getNrows(), c = a.getNcols();
+    SharedSegment seg;
+    MatrixHeader h;
+
+    seg.create(name, ELEMENTS_OFFSET + r * c * sizeof(double));
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.byte_order = ENDIAN_MARK;
+    h.nrows = r;
+    h.ncols = c;
+    memcpy(seg.writable_data(), &h, sizeof(h));
+
+    double* p = (double*)(seg.writable_data() + ELEMENTS_OFFSET);
+    for (Index i = 0; i < r; ++i)
+        for (Index j = 0; j < c; ++j)
+            p[i * c + j] = a(i, j);
+
+    if (!seg.publish())
+        throw std::runtime_error("newer matrix published as " + name);
+    return seg.get_generation();
+}
+
+uint64_t publish_matrix(const std::string& name, const Matrix<double>& a)
+{
+    return publish_matrix(name, view(a));
+}
+
+// SHARED MATRIX
+SharedMatrix::SharedMatrix() : nrows(0), ncols(0), elements(0) {}
+
+SharedMatrix::SharedMatrix(const std::string& name)
+    : nrows(0), ncols(0), elements(0)
+{
+    attach(name);
+}
+
+void SharedMatrix::attach(const std::string& name)
+{
+    SharedSegment seg;
+    MatrixHeader h;
+
+    seg.attach(name);
+    if (seg.size() < (size_t)ELEMENTS_OFFSET)
+        throw std::runtime_error(name + " is not a shared matrix");
+    memcpy(&h, seg.data(), sizeof(h));
+
+    if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error(name + " is not a shared matrix");
+    if (h.byte_order != ENDIAN_MARK)
+        throw std::runtime_error("shared matrix of other byte order");
+    if (h.version != VERSION)
+        throw std::runtime_error("shared matrix of other version");
+    if (h.nrows < 0 || h.ncols < 0 ||
+        (h.nrows > 0 && h.ncols > (int64_t)(seg.size() / sizeof(double)) /
+                                      h.nrows) ||
+        ELEMENTS_OFFSET + h.nrows * h.ncols * (int64_t)sizeof(double) >
+            (int64_t)seg.size())
+        throw std::runtime_error("shared matrix corrupt");
+
+    segment.swap(seg);  // the previous one is released with seg
+    nrows = h.nrows;
+    ncols = h.ncols;
+    elements = (const double*)(segment.data() + ELEMENTS_OFFSET);
+}
+
+bool SharedMatrix::refresh()
+{
+    if (segment.is_current())
+        return false;
+    attach(segment.get_name());
+    return true;
+}
+
+bool SharedMatrix::is_current() const
+{
+    return segment.is_current();
+}
+
+uint64_t SharedMatrix::get_generation() const
+{
+    return segment.get_generation();
+}
+
+Index SharedMatrix::getNrows() const
+{
+    return nrows;
+}
+
+Index SharedMatrix::getNcols() const
+{
+    return ncols;
+}
+
+MatrixView<const double> SharedMatrix::view() const
+{
+    return MatrixView<const double>(elements, nrows, ncols, ncols);
+}
+
+MathMatrix SharedMatrix::copy() const
+{
+    if (nrows != ncols)
+        throw std::invalid_argument("shared matrix is not square");
+
+    MathMatrix m(nrows, UNINITIALIZED);
+    if (nrows > 0)
+        memcpy(m.data(), elements, nrows * ncols * sizeof(double));
+    return m;
+}
+
+MatrixView<const double> view(const SharedMatrix& m)
+{
+    return m.view();
+}
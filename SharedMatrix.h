@@ -0,0 +1,276 @@
+/**
+ * @file SharedMatrix.h
+ * @brief Header file containing the matrices published in named POSIX
+ * shared memory, for processes which read the same matrix.
+ *
+ * A process publishes a matrix (or an LU factorisation, see
+ * LUFactorization::publish()) under a name; every other process of the host
+ * attaches to it read-only and works on the one copy in memory, through
+ * views, instead of loading its own.
+ *
+ * Publishing under a name which is already published makes a new
+ * generation: the matrix is written in a new segment, then the name is
+ * switched to it in one atomic step. Processes attached to the previous
+ * generation keep reading it unchanged (its memory is freed once the last
+ * of them releases it) and see that it is no longer current (see
+ * SharedMatrix::refresh()); processes attaching from then on get the new
+ * one. A reader never sees a partly written matrix.
+ *
+ * Names follow shm_open(): a slash followed by at most 250 characters, none
+ * of them a slash. A name uses a small index segment of that name and one
+ * segment per generation, of the name followed by a dot and the generation
+ * number. Segments are created readable and writable by their owner only.
+ */
+#ifndef SHARED_MATRIX_H
+#define SHARED_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Index.h"
+#include "MathMatrix.h"
+#include "view.h"
+
+/**
+ * @brief Class meant to represent the mapping of one generation of a named
+ * shared memory segment.
+ *
+ * A publisher create()s a segment, writes it, then publish()es it; a reader
+ * attach()es to the current generation. It throws std::runtime_error where
+ * POSIX shared memory is not available.
+ */
+class SharedSegment {
+private:
+    std::string name;     // published name, empty when released
+    uint64_t generation;  // of the mapped segment
+    void* index;          // mapping of the index segment
+    void* map;            // mapping of the segment
+    size_t map_size;      // length of the mapping in bytes
+    bool writable;        // created and not yet published
+
+    SharedSegment(const SharedSegment&);             // not copyable
+    SharedSegment& operator=(const SharedSegment&);  // not copyable
+
+public:
+    /**
+     * @brief Default constructor, nothing mapped.
+     */
+    SharedSegment();
+
+    /**
+     * @brief Destructor, releases the mapping.
+     */
+    ~SharedSegment();
+
+    /**
+     * @brief Creates a segment of a new generation, not yet published.
+     * @param name Published name.
+     * @param size Size of the segment in bytes.
+     *
+     * The segment is zero-filled and mapped for writing until publish(). It
+     * throws an exception when the name is not valid or the segment cannot
+     * be created.
+     */
+    void create(const std::string& name, size_t size);
+
+    /**
+     * @brief Publishes the created segment as the current generation.
+     * @return False when a newer generation was published meanwhile, the
+     * segment being then discarded.
+     *
+     * The previous generation is unlinked, its readers keep their mappings.
+     * The segment is mapped read-only from then on. It throws an exception
+     * when no segment was created.
+     */
+    bool publish();
+
+    /**
+     * @brief Maps the current generation of a name, read-only.
+     * @param name Published name.
+     *
+     * It throws an exception when the name is not valid or nothing is
+     * published under it, the previous mapping being then kept.
+     */
+    void attach(const std::string& name);
+
+    /**
+     * @brief Unmaps the segment, an unpublished one being discarded.
+     */
+    void release();
+
+    /**
+     * @brief Tells whether the mapped generation is still the published one.
+     * @return False when a newer generation has been published or the name
+     * has been removed, or nothing is mapped.
+     */
+    bool is_current() const;
+
+    /**
+     * @brief Returns the generation of the mapped segment.
+     * @return Generation, 1 for the first segment published under the name,
+     * 0 when nothing is mapped.
+     */
+    uint64_t get_generation() const;
+
+    /**
+     * @brief Returns the published name.
+     * @return Name, empty when nothing is mapped.
+     */
+    const std::string& get_name() const;
+
+    /**
+     * @brief Returns the size of the segment.
+     * @return Size in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the start of the segment for writing.
+     * @return Pointer to the first byte.
+     *
+     * It throws an exception when the segment is not writable (attached or
+     * already published).
+     */
+    char* writable_data();
+
+    /**
+     * @brief Returns the start of the segment for reading.
+     * @return Pointer to the first byte, 0 when nothing is mapped.
+     */
+    const char* data() const;
+
+    /**
+     * @brief Exchanges the mappings of two segments.
+     * @param s Segment.
+     */
+    void swap(SharedSegment& s);
+
+    /**
+     * @brief Removes a published name.
+     * @param name Published name.
+     *
+     * The current generation and the index are unlinked; attached processes
+     * keep their mappings.
+     */
+    static void remove(const std::string& name);
+};
+
+/**
+ * @brief Publishes a matrix in shared memory.
+ * @param name Published name, see SharedMatrix.h.
+ * @param a View of the matrix.
+ * @return Generation published.
+ *
+ * The elements are stored row-major after a header (format version, byte
+ * order and size). It throws an exception when the segment cannot be
+ * created, or when a newer generation was published meanwhile.
+ */
+uint64_t publish_matrix(const std::string& name, MatrixView<const double> a);
+
+/**
+ * @brief Publishes a matrix in shared memory.
+ * @param name Published name, see SharedMatrix.h.
+ * @param a Matrix.
+ * @return Generation published.
+ */
+uint64_t publish_matrix(const std::string& name, const Matrix<double>& a);
+
+/**
+ * @brief Class meant to represent a matrix published in shared memory by
+ * another process, attached read-only.
+ *
+ * The elements are read in place through view(); a copy of them is needed
+ * only for a MathMatrix which can be written.
+ */
+class SharedMatrix {
+private:
+    SharedSegment segment;
+    Index nrows;
+    Index ncols;
+    const double* elements;  // in the segment
+
+    SharedMatrix(const SharedMatrix&);             // not copyable
+    SharedMatrix& operator=(const SharedMatrix&);  // not copyable
+
+public:
+    /**
+     * @brief Default constructor, an empty matrix.
+     */
+    SharedMatrix();
+
+    /**
+     * @brief Alternate constructor, attaches to a published matrix.
+     * @param name Published name.
+     *
+     * See attach().
+     */
+    explicit SharedMatrix(const std::string& name);
+
+    /**
+     * @brief Attaches to the current generation of a published matrix.
+     * @param name Published name.
+     *
+     * It throws an exception when nothing is published under the name, or
+     * what is published is not a matrix of this format, version and byte
+     * order, the matrix being then left unchanged.
+     */
+    void attach(const std::string& name);
+
+    /**
+     * @brief Attaches to the current generation when it is newer.
+     * @return True when the matrix changed.
+     *
+     * It throws an exception as attach(), the matrix being then left
+     * unchanged.
+     */
+    bool refresh();
+
+    /**
+     * @brief Tells whether the attached generation is still the published
+     * one.
+     * @return False when a newer one has been published or the name removed.
+     */
+    bool is_current() const;
+
+    /**
+     * @brief Returns the attached generation.
+     * @return Generation, 0 when not attached.
+     */
+    uint64_t get_generation() const;
+
+    /**
+     * @brief Get the number of rows.
+     * @return Number of rows.
+     */
+    Index getNrows() const;
+
+    /**
+     * @brief Get the number of columns.
+     * @return Number of columns.
+     */
+    Index getNcols() const;
+
+    /**
+     * @brief View of the elements.
+     * @return View of the matrix, valid until the matrix is attached again,
+     * refreshed or destroyed.
+     */
+    MatrixView<const double> view() const;
+
+    /**
+     * @brief Copy of a square matrix.
+     * @return MathMatrix of the elements.
+     *
+     * It throws an exception when the matrix is not square.
+     */
+    MathMatrix copy() const;
+};
+
+/**
+ * @brief View of a shared matrix.
+ * @param m Shared matrix.
+ * @return m.view().
+ */
+MatrixView<const double> view(const SharedMatrix& m);
+
+#endif /* SHARED_MATRIX_H */
@@ -0,0 +1,286 @@
+#include "SingularValues.h"
+#include "MathBlas.h"
+#include "Trace.h"
+#include <cmath>
+#include <cfloat>
+#include <stdexcept>
+
+// TRIDIAGONAL EIGENPROBLEM
+// T is the k x k symmetric tridiagonal matrix with diagonal a and
+// off-diagonal b.
+
+// number of eigenvalues of T smaller than x (Sturm sequence count)
+static int sturm_count(const std::vector<double>& a,
+                       const std::vector<double>& b, int k, double x)
+{
+    int i, count = 0;
+    double d = 1;
+
+    for (i = 0; i < k; ++i)
+    {
+        d = a[i] - x - (i > 0 ? b[i - 1] * b[i - 1] / d : 0);
+        if (d == 0)
+            d = -DBL_MIN;  // x is an eigenvalue of the leading block
+        if (d < 0)
+            ++count;
+    }
+    return count;
+}
+
+// the idx-th smallest eigenvalue of T, by bisection
+static double tridiagonal_eigenvalue(const std::vector<double>& a,
+                                     const std::vector<double>& b, int k,
+                                     int idx)
+{
+    int i;
+    double lo = a[0], hi = a[0], r, mid;
+
+    // Gershgorin bounds
+    for (i = 0; i < k; ++i)
+    {
+        r = (i > 0 ? fabs(b[i - 1]) : 0) + (i < k - 1 ? fabs(b[i]) : 0);
+        if (a[i] - r < lo)
+            lo = a[i] - r;
+        if (a[i] + r > hi)
+            hi = a[i] + r;
+    }
+
+    for (i = 0; i < 200; ++i)
+    {
+        mid = (lo + hi) / 2;
+        if (mid <= lo || mid >= hi ||
+            hi - lo <= 2 * DBL_EPSILON * fmax(fabs(lo), fabs(hi)))
+            break;
+        if (sturm_count(a, b, k, mid) > idx)
+            hi = mid;
+        else
+            lo = mid;
+    }
+    return (lo + hi) / 2;
+}
+
+// solves (T - shift I) x = x in place by Gaussian elimination with partial
+// pivoting (as LAPACK dgtsv); zero pivots are replaced by a tiny number, as
+// inverse iteration wants
+static void tridiagonal_solve(const std::vector<double>& a,
+                              const std::vector<double>& b, int k,
+                              double shift, std::vector<double>& x)
+{
+    std::vector<double> d(k), dl(k), du(k), du2(k);
+    double fact, temp, tiny;
+    int i;
+
+    tiny = DBL_EPSILON * (fabs(shift) > DBL_MIN ? fabs(shift) : 1.0);
+    for (i = 0; i < k; ++i)
+    {
+        d[i] = a[i] - shift;
+        dl[i] = du[i] = i < k - 1 ? b[i] : 0;
+        du2[i] = 0;
+    }
+
+    for (i = 0; i < k - 1; ++i)
+    {
+        if (fabs(d[i]) >= fabs(dl[i]))
+        {
+            // no interchange
+            if (d[i] == 0)
+                d[i] = tiny;
+            fact = dl[i] / d[i];
+            d[i + 1] -= fact * du[i];
+            x[i + 1] -= fact * x[i];
+        }
+        else
+        {
+            // interchange rows i and i + 1
+            fact = d[i] / dl[i];
+            d[i] = dl[i];
+            temp = d[i + 1];
+            d[i + 1] = du[i] - fact * temp;
+            if (i < k - 2)
+            {
+                du2[i] = du[i + 1];
+                du[i + 1] = -fact * du2[i];
+            }
+            du[i] = temp;
+            temp = x[i];
+            x[i] = x[i + 1];
+            x[i + 1] = temp - fact * x[i + 1];
+        }
+    }
+    if (d[k - 1] == 0)
+        d[k - 1] = tiny;
+
+    // back substitution
+    for (i = k - 1; i >= 0; --i)
+    {
+        temp = x[i];
+        if (i < k - 1)
+            temp -= du[i] * x[i + 1];
+        if (i < k - 2)
+            temp -= du2[i] * x[i + 2];
+        x[i] = temp / d[i];
+    }
+}
+
+// eigenvector of T for its eigenvalue theta, by two steps of inverse
+// iteration
+static void tridiagonal_eigenvector(const std::vector<double>& a,
+                                    const std::vector<double>& b, int k,
+                                    double theta, std::vector<double>& s)
+{
+    int i, it;
+    double norm;
+
+    s.assign(k, 1.0);
+    for (it = 0; it < 2; ++it)
+    {
+        tridiagonal_solve(a, b, k, theta, s);
+        norm = 0;
+        for (i = 0; i < k; ++i)
+            norm += s[i] * s[i];
+        norm = sqrt(norm);
+        for (i = 0; i < k; ++i)
+            s[i] /= norm;
+    }
+}
+
+// ESTIMATOR
+SingularValueEstimator::SingularValueEstimator() : tol(1e-8), max_iter(100)
+{
+}
+
+void SingularValueEstimator::set_tolerance(double t)
+{
+    if (t < 0)
+        throw std::invalid_argument("tolerance negative");
+    tol = t;
+}
+
+void SingularValueEstimator::set_max_iterations(int n)
+{
+    if (n <= 0)
+        throw std::invalid_argument("maximum number of steps not positive");
+    max_iter = n;
+}
+
+void SingularValueEstimator::reset()
+{
+    v_max = MathVector();
+    v_min = MathVector();
+}
+
+// make v a vector of size n, reallocating only when its size differs
+static void fit(MathVector& v, Index n)
+{
+    if (v.size() != n)
+        v = MathVector(n);
+}
+
+SingularValueEstimate SingularValueEstimator::estimate(const MathMatrix& a)
+{
+    MATH_TRACE_SCOPE("singular values");
+
+    SingularValueEstimate res;
+    Index n = a.get_size();
+    int kmax = max_iter < n ? max_iter : (int)n;  // steps, at most n
+    Index i;
+    int j, k = 0;
+    double norm, tmax = 0, tmin = 0, rmax, rmin;
+    std::vector<double> s;
+    unsigned seed = 12345;
+
+    res.sigma_max = res.sigma_min = 0;
+    res.iterations = 0;
+    res.converged = true;
+    if (n == 0)
+        return res;
+
+    if ((int)basis.size() < kmax + 1)
+        basis.resize(kmax + 1);
+    for (j = 0; j <= kmax; ++j)
+        fit(basis[j], n);
+    alpha.assign(kmax, 0);
+    beta.assign(kmax, 0);
+    fit(w, n);
+    fit(z, n);
+
+    // starting vector: the previous Ritz vectors, which hold the directions
+    // of both extremes, else a fixed pseudo-random vector
+    MathVector& q0 = basis[0];
+    if (v_max.size() == n && v_min.size() == n)
+    {
+        copy(v_max, q0);
+        axpy(1.0, v_min, q0);
+    }
+    norm = nrm2(q0);
+    if (v_max.size() != n || norm < 0.5)
+    {
+        for (i = 0; i < n; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            q0[i] = (seed >> 16 & 0x7fff) / 32768.0 - 0.5;
+        }
+        norm = nrm2(q0);
+    }
+    scal(1 / norm, q0);
+
+    res.converged = false;
+    for (j = 0; j < kmax; ++j)
+    {
+        // z = A^T A q_j
+        gemv(NO_TRANS, 1.0, a, basis[j], 0.0, w);
+        gemv(TRANS, 1.0, a, w, 0.0, z);
+
+        alpha[j] = dot(basis[j], z);
+
+        // orthogonalise against the whole basis (the three-term recurrence
+        // alone loses orthogonality in floating point)
+        for (i = 0; i <= j; ++i)
+            axpy(-dot(basis[i], z), basis[i], z);
+        beta[j] = nrm2(z);
+        k = j + 1;
+
+        tmax = tridiagonal_eigenvalue(alpha, beta, k, k - 1);
+        tmin = tridiagonal_eigenvalue(alpha, beta, k, 0);
+
+        // the residual of a Ritz pair (theta, V s) is |beta_j s_j|, and
+        // theta is at most that far from an eigenvalue of A^T A
+        tridiagonal_eigenvector(alpha, beta, k, tmax, s);
+        rmax = fabs(beta[j] * s[k - 1]);
+        tridiagonal_eigenvector(alpha, beta, k, tmin, s);
+        rmin = fabs(beta[j] * s[k - 1]);
+        if (rmax <= tol * tmax && rmin <= tol * tmax)
+        {
+            res.converged = true;
+            break;
+        }
+
+        copy(z, basis[j + 1]);
+        scal(1 / beta[j], basis[j + 1]);
+    }
+    if (k == n)
+        res.converged = true;  // the whole space was spanned
+
+    // Ritz vectors, the warm start of the next estimate
+    fit(v_max, n);
+    fit(v_min, n);
+    tridiagonal_eigenvector(alpha, beta, k, tmax, s);
+    scal(0.0, v_max);
+    for (i = 0; i < k; ++i)
+        axpy(s[i], basis[i], v_max);
+    tridiagonal_eigenvector(alpha, beta, k, tmin, s);
+    scal(0.0, v_min);
+    for (i = 0; i < k; ++i)
+        axpy(s[i], basis[i], v_min);
+
+    // the eigenvalues of A^T A are the squares of the singular values
+    res.sigma_max = sqrt(fmax(tmax, 0.0));
+    res.sigma_min = sqrt(fmax(tmin, 0.0));
+    res.iterations = k;
+    return res;
+}
+
+double SingularValueEstimator::spectral_norm(const MathMatrix& a)
+{
+    return estimate(a).sigma_max;
+}
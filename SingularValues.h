@@ -0,0 +1,96 @@
+/**
+ * @file SingularValues.h
+ * @brief Header file containing the estimator of the extreme singular values
+ * of a matrix.
+ */
+#ifndef SINGULAR_VALUES_H
+#define SINGULAR_VALUES_H
+
+#include <vector>
+#include "MathMatrix.h"
+
+/**
+ * @brief Estimates of the extreme singular values of a matrix.
+ */
+struct SingularValueEstimate {
+    double sigma_max;  ///< Largest singular value, the spectral norm.
+    double sigma_min;  ///< Smallest singular value.
+    int iterations;    ///< Number of Lanczos steps done.
+    bool converged;    ///< The tolerance was reached.
+};
+
+/**
+ * @brief Class meant to represent an estimator of the largest and smallest
+ * singular values of square matrices.
+ *
+ * The squares of the singular values of A are the eigenvalues of A^T A. The
+ * estimator runs the Lanczos iteration on A^T A, every step taking the two
+ * products w = A v and A^T w (gemv(), without forming A^T A), so k steps
+ * cost O(k n^2) instead of the O(n^3) of a decomposition. The basis is fully
+ * reorthogonalised, and the extreme eigenvalues of the Lanczos tridiagonal
+ * matrix are found by Sturm sequence bisection.
+ *
+ * The iteration stops when the residuals of both extreme Ritz pairs of A^T A
+ * are at most tolerance times the largest eigenvalue; each estimated
+ * eigenvalue is then at most that far from a true one. The largest singular
+ * value converges quickly; the smallest one needs more steps when it is
+ * close to the others, and its relative accuracy drops when it is tiny
+ * compared with the largest.
+ *
+ * The estimator is warm-started: it keeps the Ritz vectors of the previous
+ * matrix of the same size and starts the next iteration from them, so for a
+ * slowly changing matrix only a few steps are needed.
+ */
+class SingularValueEstimator {
+private:
+    double tol;
+    int max_iter;
+    MathVector v_max, v_min;  // Ritz vectors of the previous matrix
+    std::vector<MathVector> basis;
+    std::vector<double> alpha, beta;
+    MathVector w, z;
+
+public:
+    /**
+     * @brief Default constructor, tolerance 1e-8, at most 100 steps.
+     */
+    SingularValueEstimator();
+
+    /**
+     * @brief Sets the tolerance.
+     * @param t Tolerance, relative to the square of the largest singular
+     * value.
+     *
+     * It throws an exception when t is negative.
+     */
+    void set_tolerance(double t);
+
+    /**
+     * @brief Sets the maximum number of Lanczos steps.
+     * @param n Maximum number of steps, at least 1.
+     *
+     * It throws an exception when n is not positive.
+     */
+    void set_max_iterations(int n);
+
+    /**
+     * @brief Forgets the warm start, the next estimate starts from scratch.
+     */
+    void reset();
+
+    /**
+     * @brief Estimates the extreme singular values of a matrix.
+     * @param a Square matrix.
+     * @return Estimates.
+     */
+    SingularValueEstimate estimate(const MathMatrix& a);
+
+    /**
+     * @brief Estimates the spectral norm of a matrix.
+     * @param a Square matrix.
+     * @return Largest singular value.
+     */
+    double spectral_norm(const MathMatrix& a);
+};
+
+#endif /* SINGULAR_VALUES_H */
@@ -0,0 +1,161 @@
+#include "Strassen.h"
+#include "MathBlas.h"
+
+// WORKSPACE
+StrassenWorkspace::StrassenWorkspace() : buf() {}
+
+StrassenWorkspace::StrassenWorkspace(Index n, int crossover) : buf()
+{
+    reserve(n, crossover);
+}
+
+void StrassenWorkspace::reserve(Index n, int crossover)
+{
+    Index size = required(n, crossover);
+
+    if (buf.size() < size)
+        buf = Vector<double>(size);
+}
+
+Index StrassenWorkspace::required(Index n, int crossover)
+{
+    if (n <= crossover)
+        return 0;
+    if (n % 2)
+        return required(n - 1, crossover);  // last row and column peeled
+    // X and Y of size n/2 for this level, then the deeper levels
+    return 2 * (n / 2) * (n / 2) + required(n / 2, crossover);
+}
+
+double* StrassenWorkspace::data()
+{
+    return buf.data();
+}
+
+Index StrassenWorkspace::size() const
+{
+    return buf.size();
+}
+
+// ADDITION OF VIEWS
+// z = x + sign y; z may be the same view as x or y
+static void add(MatrixView<double> z, MatrixView<const double> x,
+                MatrixView<const double> y, double sign)
+{
+    Index i, j;
+    Index m = z.getNrows(), n = z.getNcols();
+
+    for (i = 0; i < m; ++i)
+    {
+        double* zi = z.data() + i * z.getRowStride();
+        const double* xi = x.data() + i * x.getRowStride();
+        const double* yi = y.data() + i * y.getRowStride();
+        for (j = 0; j < n; ++j)
+            zi[j] = xi[j] + sign * yi[j];
+    }
+}
+
+// RECURSION
+// C = A B for square views with unit column stride, ws holding at least
+// StrassenWorkspace::required(n, crossover) doubles
+static void sw_multiply(MatrixView<const double> a, MatrixView<const double> b,
+                        MatrixView<double> c, double* ws, int crossover)
+{
+    Index m = a.getNrows();
+
+    if (m <= crossover)
+    {
+        gemm(NO_TRANS, NO_TRANS, 1.0, a, b, 0.0, c);
+        return;
+    }
+
+    if (m % 2)
+    {
+        // odd size: peel the last row and column,
+        // C11 = A11 B11 + a12 b21, c12 = A b2, c21 = a2 B1
+        Index m1 = m - 1;
+        sw_multiply(a.block(0, 0, m1, m1), b.block(0, 0, m1, m1),
+                    c.block(0, 0, m1, m1), ws, crossover);
+        gemm(NO_TRANS, NO_TRANS, 1.0, a.block(0, m1, m1, 1),
+             b.block(m1, 0, 1, m1), 1.0, c.block(0, 0, m1, m1));
+        gemm(NO_TRANS, NO_TRANS, 1.0, a, b.block(0, m1, m, 1), 0.0,
+             c.block(0, m1, m, 1));
+        gemm(NO_TRANS, NO_TRANS, 1.0, a.block(m1, 0, 1, m),
+             b.block(0, 0, m, m1), 0.0, c.block(m1, 0, 1, m1));
+        return;
+    }
+
+    Index h = m / 2;
+
+    // quadrants
+    MatrixView<const double> a11 = a.block(0, 0, h, h);
+    MatrixView<const double> a12 = a.block(0, h, h, h);
+    MatrixView<const double> a21 = a.block(h, 0, h, h);
+    MatrixView<const double> a22 = a.block(h, h, h, h);
+    MatrixView<const double> b11 = b.block(0, 0, h, h);
+    MatrixView<const double> b12 = b.block(0, h, h, h);
+    MatrixView<const double> b21 = b.block(h, 0, h, h);
+    MatrixView<const double> b22 = b.block(h, h, h, h);
+    MatrixView<double> c11 = c.block(0, 0, h, h);
+    MatrixView<double> c12 = c.block(0, h, h, h);
+    MatrixView<double> c21 = c.block(h, 0, h, h);
+    MatrixView<double> c22 = c.block(h, h, h, h);
+
+    // two temporaries of this level, the rest of ws is for deeper levels
+    MatrixView<double> x(ws, h, h, h), y(ws + h * h, h, h, h);
+    double* rest = ws + 2 * h * h;
+
+    // Winograd's variant: 7 products and 15 additions, scheduled so that
+    // only x and y are needed besides the quadrants of C
+    add(x, a11, a21, -1.0);                        // S3 = A11 - A21
+    add(y, b22, b12, -1.0);                        // T3 = B22 - B12
+    sw_multiply(x, y, c21, rest, crossover);       // P7 = S3 T3
+    add(x, a21, a22, 1.0);                         // S1 = A21 + A22
+    add(y, b12, b11, -1.0);                        // T1 = B12 - B11
+    sw_multiply(x, y, c22, rest, crossover);       // P5 = S1 T1
+    add(x, x, a11, -1.0);                          // S2 = S1 - A11
+    add(y, b22, y, -1.0);                          // T2 = B22 - T1
+    sw_multiply(x, y, c12, rest, crossover);       // P6 = S2 T2
+    add(x, a12, x, -1.0);                          // S4 = A12 - S2
+    sw_multiply(x, b22, c11, rest, crossover);     // P3 = S4 B22
+    sw_multiply(a11, b11, x, rest, crossover);     // P1 = A11 B11
+    add(c12, x, c12, 1.0);                         // U2 = P1 + P6
+    add(c21, c12, c21, 1.0);                       // U3 = U2 + P7
+    add(c12, c12, c22, 1.0);                       // U4 = U2 + P5
+    add(c22, c21, c22, 1.0);                       // C22 = U3 + P5
+    add(c12, c12, c11, 1.0);                       // C12 = U4 + P3
+    add(y, y, b21, -1.0);                          // T4 = T2 - B21
+    sw_multiply(a22, y, c11, rest, crossover);     // P4 = A22 T4
+    add(c21, c21, c11, -1.0);                      // C21 = U3 - P4
+    sw_multiply(a12, b21, c11, rest, crossover);   // P2 = A12 B21
+    add(c11, x, c11, 1.0);                         // C11 = P1 + P2
+}
+
+// STRASSEN-WINOGRAD MULTIPLICATION
+void strassen_multiply(const MathMatrix& a, const MathMatrix& b,
+                       MathMatrix& c, StrassenWorkspace& ws, int crossover)
+{
+    Index n = a.get_size();
+
+    if (b.get_size() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+    if (crossover < 1)
+        throw std::invalid_argument("crossover size not positive");
+
+    if (c.get_size() != n)
+        c = MathMatrix(n);
+    ws.reserve(n, crossover);
+
+    sw_multiply(view(a), view(b), view(c), ws.data(), crossover);
+}
+
+MathMatrix strassen_multiply(const MathMatrix& a, const MathMatrix& b,
+                             int crossover)
+{
+    MathMatrix c;
+    StrassenWorkspace ws;
+
+    strassen_multiply(a, b, c, ws, crossover);
+
+    return c;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file Strassen.h
+ * @brief Header file containing the Strassen-Winograd matrix multiplication
+ * routines.
+ */
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include "MathMatrix.h"
+
+/**
+ * @brief Class meant to represent the workspace of strassen_multiply().
+ *
+ * The recursion needs two temporary matrices of half the size on every
+ * level, about 2/3 n^2 doubles in total. A workspace reserved once can be
+ * reused by many products, so they do not allocate any memory.
+ */
+class StrassenWorkspace {
+private:
+    Vector<double> buf;
+
+public:
+    /**
+     * @brief Default constructor, creates an empty workspace.
+     */
+    StrassenWorkspace();
+
+    /**
+     * @brief Alternate constructor, reserves the workspace.
+     * @param n Size of the matrices to multiply.
+     * @param crossover Crossover size (see strassen_multiply()).
+     */
+    StrassenWorkspace(Index n, int crossover);
+
+    /**
+     * @brief Makes the workspace large enough for given sizes.
+     * @param n Size of the matrices to multiply.
+     * @param crossover Crossover size (see strassen_multiply()).
+     *
+     * Memory is reallocated only when the workspace is too small.
+     */
+    void reserve(Index n, int crossover);
+
+    /**
+     * @brief Number of doubles needed for given sizes.
+     * @param n Size of the matrices to multiply.
+     * @param crossover Crossover size (see strassen_multiply()).
+     * @return Number of doubles.
+     */
+    static Index required(Index n, int crossover);
+
+    /**
+     * @brief Get the workspace memory.
+     * @return Pointer to the workspace.
+     */
+    double* data();
+
+    /**
+     * @brief Get the workspace size.
+     * @return Number of doubles in the workspace.
+     */
+    Index size() const;
+};
+
+/**
+ * @brief Matrix by matrix multiplication by the Strassen-Winograd
+ * algorithm, C = A B.
+ * @param a Matrix A.
+ * @param b Matrix B.
+ * @param c Reference to MathMatrix for storing the result.
+ * @param ws Workspace, enlarged when needed.
+ * @param crossover Size at which the recursion hands off to the classical
+ * gemm() kernel.
+ *
+ * Every recursion level replaces 8 products of half-size matrices by 7,
+ * with 15 additions, so for large n the product takes O(n^2.81) instead of
+ * O(n^3) operations. Odd sizes are handled by peeling the last row and
+ * column, which are computed by the classical kernel. The result differs
+ * from the classical product by rounding errors somewhat larger than
+ * those of the classical algorithm, growing with the number of levels.
+ *
+ * c must be a different object than a and b. It throws an exception when the
+ * sizes of a and b differ.
+ */
+void strassen_multiply(const MathMatrix& a, const MathMatrix& b,
+                       MathMatrix& c, StrassenWorkspace& ws,
+                       int crossover = 256);
+
+/**
+ * @brief Matrix by matrix multiplication by the Strassen-Winograd
+ * algorithm.
+ * @param a Matrix A.
+ * @param b Matrix B.
+ * @param crossover Size at which the recursion hands off to the classical
+ * kernel.
+ * @return Matrix by matrix multiplication result.
+ *
+ * Allocates its own workspace, see the routine above.
+ */
+MathMatrix strassen_multiply(const MathMatrix& a, const MathMatrix& b,
+                             int crossover = 256);
+
+#endif /* STRASSEN_H */
@@ -0,0 +1,375 @@
+#include "TaskScheduler.h"
+#include "Trace.h"
+#include <stdexcept>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// scheduler and worker index of the calling thread (0 and -1 outside the
+// workers), and whether the running task opened a ForkScope
+static thread_local const TaskScheduler* current_scheduler = 0;
+static thread_local int current_index = -1;
+static thread_local bool fork_scope = false;
+
+// runs a task outside the fork scope of the task which executes it
+static void run_task(const TaskScheduler::Task& task)
+{
+    bool saved = fork_scope;
+
+    fork_scope = false;
+    try {
+        task();
+    }
+    catch (...) {
+        fork_scope = saved;
+        throw;
+    }
+    fork_scope = saved;
+}
+
+// CONSTRUCTOR AND DESTRUCTOR
+TaskScheduler::TaskScheduler(int nthreads, bool pin)
+    : queued(0), next(0), stop(false)
+{
+    int i;
+
+    if (nthreads <= 0)
+        nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0)
+        nthreads = 1;
+
+    for (i = 0; i < nthreads; ++i)
+        queues.push_back(new Queue);
+    for (i = 0; i < nthreads; ++i)
+        threads.push_back(std::thread(&TaskScheduler::worker_loop, this, i));
+
+#ifdef __linux__
+    if (pin)
+    {
+        int ncpus = std::thread::hardware_concurrency();
+        for (i = 0; ncpus > 0 && i < nthreads; ++i)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % ncpus, &set);
+            pthread_setaffinity_np(threads[i].native_handle(), sizeof(set),
+                                   &set);
+        }
+    }
+#else
+    (void)pin;
+#endif
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop = true;
+    }
+    sleep_cv.notify_all();
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    for (size_t i = 0; i < queues.size(); ++i)
+        delete queues[i];
+}
+
+int TaskScheduler::num_threads() const
+{
+    return (int)threads.size();
+}
+
+int TaskScheduler::worker_index() const
+{
+    return current_scheduler == this ? current_index : -1;
+}
+
+bool TaskScheduler::in_worker()
+{
+    return current_scheduler != 0;
+}
+
+bool TaskScheduler::in_fork_scope()
+{
+    return fork_scope;
+}
+
+TaskScheduler::ForkScope::ForkScope() : saved(fork_scope)
+{
+    fork_scope = true;
+}
+
+TaskScheduler::ForkScope::~ForkScope()
+{
+    fork_scope = saved;
+}
+
+// SUBMITTING AND WAITING
+void TaskScheduler::submit(const Task& task)
+{
+    int index = worker_index();
+    if (index < 0)
+        index = next++ % queues.size();  // round-robin from outside
+
+    submit(task, index);
+}
+
+void TaskScheduler::submit(const Task& task, int worker)
+{
+    if (worker < 0)
+        throw std::invalid_argument("worker index negative");
+
+    int index = worker % (int)queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(task);
+    }
+    queued++;
+
+    // taking the lock makes sure a worker about to sleep sees the new task
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_cv.notify_one();
+}
+
+void TaskScheduler::submit_urgent(const Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(urgent.mutex);
+        urgent.tasks.push_back(task);
+    }
+    queued++;
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_cv.notify_one();
+}
+
+bool TaskScheduler::run_urgent()
+{
+    Task task;
+    bool ran = false;
+
+    if (worker_index() < 0)
+        return false;
+
+    while (pop_urgent(task))
+    {
+        queued--;
+        {
+            MATH_TRACE_SCOPE("urgent task");
+            run_task(task);
+        }
+        ran = true;
+    }
+    return ran;
+}
+
+void TaskScheduler::wait(const std::atomic<int>& pending)
+{
+    int index = worker_index();
+
+    while (pending.load(std::memory_order_acquire) > 0)
+    {
+        if (index >= 0)
+        {
+            // a worker keeps executing tasks, otherwise waiting from inside a
+            // task could leave no thread to run the tasks waited for
+            if (!run_one(index))
+                std::this_thread::yield();
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done_cv.wait(lock, [&pending] {
+                return pending.load(std::memory_order_acquire) <= 0;
+            });
+        }
+    }
+}
+
+void TaskScheduler::release(std::atomic<int>& pending)
+{
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    // taking the lock makes sure a thread about to sleep sees the zero
+    {
+        std::lock_guard<std::mutex> lock(done_mutex);
+    }
+    done_cv.notify_all();
+}
+
+// WORKERS
+void TaskScheduler::worker_loop(int index)
+{
+    current_scheduler = this;
+    current_index = index;
+    MATH_TRACE_THREAD("worker", index);
+
+    for (;;)
+    {
+        if (run_one(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [this] { return stop || queued > 0; });
+        if (stop && queued == 0)
+            return;
+    }
+}
+
+// execute an urgent task, one of the worker's own queue or a stolen one
+bool TaskScheduler::run_one(int index)
+{
+    Task task;
+
+    if (!pop_urgent(task) && !pop(index, task) && !steal(index, task))
+        return false;
+
+    queued--;
+    {
+        MATH_TRACE_SCOPE("task");
+        run_task(task);
+    }
+    return true;
+}
+
+// take the newest task of the worker's own queue
+bool TaskScheduler::pop(int index, Task& task)
+{
+    if (index < 0)
+        return false;
+
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+        return false;
+    task = q.tasks.back();
+    q.tasks.pop_back();
+    return true;
+}
+
+// take the oldest urgent task
+bool TaskScheduler::pop_urgent(Task& task)
+{
+    std::lock_guard<std::mutex> lock(urgent.mutex);
+    if (urgent.tasks.empty())
+        return false;
+    task = urgent.tasks.front();
+    urgent.tasks.pop_front();
+    return true;
+}
+
+// take the oldest task of another worker's queue
+bool TaskScheduler::steal(int index, Task& task)
+{
+    int n = (int)queues.size();
+
+    for (int i = 1; i <= n; ++i)
+    {
+        Queue& q = *queues[(index + i + n) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty())
+        {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// TASK GRAPH
+TaskGraph::TaskGraph() : pending(0) {}
+
+TaskGraph::~TaskGraph()
+{
+    for (size_t i = 0; i < nodes.size(); ++i)
+        delete nodes[i];
+}
+
+int TaskGraph::add(const TaskScheduler::Task& task)
+{
+    return add(task, -1);
+}
+
+int TaskGraph::add(const TaskScheduler::Task& task, int worker)
+{
+    if (worker < -1)
+        throw std::invalid_argument("worker index negative");
+
+    Node* node = new Node;
+    node->task = task;
+    node->ndeps = 0;
+    node->worker = worker;
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+}
+
+void TaskGraph::precede(int before, int after)
+{
+    nodes[before]->successors.push_back(after);
+    nodes[after]->ndeps++;
+}
+
+void TaskGraph::run(TaskScheduler& sched)
+{
+    size_t i;
+
+    if (nodes.empty())
+        return;
+
+    error = std::exception_ptr();
+    for (i = 0; i < nodes.size(); ++i)
+        nodes[i]->deps = nodes[i]->ndeps;
+    pending = (int)nodes.size();
+
+    for (i = 0; i < nodes.size(); ++i)
+        if (nodes[i]->ndeps == 0)
+            submit(sched, (int)i);
+
+    sched.wait(pending);
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// queue a task whose dependencies have finished
+void TaskGraph::submit(TaskScheduler& sched, int id)
+{
+    TaskScheduler::Task task = [this, &sched, id] { execute(sched, id); };
+
+    if (nodes[id]->worker >= 0)
+        sched.submit(task, nodes[id]->worker);
+    else
+        sched.submit(task);
+}
+
+// run a task and release the tasks depending on it
+void TaskGraph::execute(TaskScheduler& sched, int id)
+{
+    Node& node = *nodes[id];
+
+    try {
+        node.task();
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+            error = std::current_exception();
+    }
+
+    for (size_t i = 0; i < node.successors.size(); ++i)
+    {
+        int s = node.successors[i];
+        if (--nodes[s]->deps == 0)
+            submit(sched, s);
+    }
+
+    sched.release(pending);
+}
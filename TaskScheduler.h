@@ -0,0 +1,279 @@
+/**
+ * @file TaskScheduler.h
+ * @brief Header file containing TaskScheduler and TaskGraph class
+ * definitions.
+ */
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Class meant to represent a pool of worker threads which execute
+ * tasks, balancing the load by work stealing.
+ *
+ * Every worker owns a double-ended queue of tasks. A task submitted by a
+ * worker goes to the back of its own queue and the worker takes its next task
+ * from the back too, so that freshly unlocked work (eg. the next panel of a
+ * factorisation) runs first, while the data it needs is still in the cache.
+ * An idle worker steals from the front of the other queues, where the oldest
+ * and usually the biggest pieces of work are.
+ *
+ * Urgent tasks (see submit_urgent()) go to a separate queue, which every
+ * worker serves before its own. A long task can also run them on its own
+ * thread at points of its choosing (see run_urgent()), so latency-sensitive
+ * work does not wait for it to finish even when all workers are busy.
+ */
+class TaskScheduler {
+public:
+    /**
+     * @brief Type of the tasks.
+     */
+    typedef std::function<void()> Task;
+
+    /**
+     * @brief Constructor, starts the worker threads.
+     * @param nthreads Number of worker threads, 0 means one per hardware
+     * thread.
+     * @param pin Tells whether worker i is pinned to CPU i (modulo the number
+     * of CPUs); ignored where thread affinity is not supported.
+     */
+    explicit TaskScheduler(int nthreads = 0, bool pin = false);
+
+    /**
+     * @brief Destructor, waits for the queued tasks and stops the workers.
+     */
+    ~TaskScheduler();
+
+    /**
+     * @brief Returns the number of worker threads.
+     * @return Number of worker threads.
+     */
+    int num_threads() const;
+
+    /**
+     * @brief Queues a task for execution.
+     * @param task Task.
+     *
+     * A task submitted from a worker thread of this scheduler is queued on
+     * that worker, any other is distributed among the workers round-robin.
+     */
+    void submit(const Task& task);
+
+    /**
+     * @brief Queues a task on a given worker.
+     * @param task Task.
+     * @param worker Index of the worker, taken modulo num_threads().
+     *
+     * The task is run by that worker unless an idle worker steals it first.
+     * Loops which split the same range in the same way on every call (see
+     * parallel_for()) thus run each part on the same thread every time, and
+     * so next to the memory that thread touched first.
+     *
+     * It throws an exception when worker is negative.
+     */
+    void submit(const Task& task, int worker);
+
+    /**
+     * @brief Queues a latency-sensitive task for execution.
+     * @param task Task.
+     *
+     * The task is run before any task of the ordinary queues, by the first
+     * worker to become idle or by a running task calling run_urgent().
+     */
+    void submit_urgent(const Task& task);
+
+    /**
+     * @brief Runs the queued urgent tasks on the calling worker thread.
+     * @return True when at least one task was run.
+     *
+     * Meant to be called by long tasks between two steps of their work. It
+     * does nothing when the calling thread is not a worker of this
+     * scheduler.
+     */
+    bool run_urgent();
+
+    /**
+     * @brief Waits until a counter of unfinished tasks drops to zero.
+     * @param pending Counter decremented by the tasks being waited for.
+     *
+     * A worker thread executes queued tasks while waiting, so waiting from
+     * inside a task does not block a worker. Any other thread sleeps until
+     * release() wakes it, so the counter has to be decremented by release().
+     */
+    void wait(const std::atomic<int>& pending);
+
+    /**
+     * @brief Decrements a counter of unfinished tasks waited for by wait().
+     * @param pending Counter.
+     *
+     * The threads sleeping in wait() are woken when it drops to zero. The
+     * counter is not accessed afterwards, so its owner may destroy it as
+     * soon as wait() returns.
+     */
+    void release(std::atomic<int>& pending);
+
+    /**
+     * @brief Returns the index of the calling worker thread.
+     * @return Index in [0, num_threads()), or -1 when the calling thread is not
+     * a worker of this scheduler.
+     */
+    int worker_index() const;
+
+    /**
+     * @brief Tells whether the calling thread is a worker of any scheduler.
+     * @return True inside a task.
+     *
+     * Parallel routines called from inside a task run sequentially, so nested
+     * parallelism does not start more threads than there are cores, unless
+     * the task opened a ForkScope.
+     */
+    static bool in_worker();
+
+    /**
+     * @brief Tells whether the calling task is inside a ForkScope.
+     * @return True when parallel routines called by the task split their
+     * work into tasks.
+     */
+    static bool in_fork_scope();
+
+    /**
+     * @brief Class meant to represent the scope in which a task lets the
+     * parallel routines it calls split their work into tasks of the pool.
+     *
+     * Meant for a long task whose kernels would otherwise run on its thread
+     * alone (eg. an asynchronous job, see Async.h). The task waits for the
+     * parts like any caller of TaskGraph::run(), executing queued tasks
+     * meanwhile; the tasks it executes, those parts included, run their own
+     * parallel routines sequentially again.
+     */
+    class ForkScope {
+    public:
+        /**
+         * @brief Constructor, opens the scope on the calling thread.
+         */
+        ForkScope();
+
+        /**
+         * @brief Destructor, restores the previous state of the thread.
+         */
+        ~ForkScope();
+
+    private:
+        bool saved;  // state when the scope was opened
+
+        // no copying
+        ForkScope(const ForkScope&);
+        ForkScope& operator=(const ForkScope&);
+    };
+
+private:
+    // queue of one worker
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<Queue*> queues;
+    Queue urgent;                  // urgent tasks, served first
+    std::atomic<int> queued;       // tasks in all queues
+    std::atomic<unsigned> next;    // round-robin counter for outside tasks
+    std::atomic<bool> stop;
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::mutex done_mutex;         // threads outside the pool in wait()
+    std::condition_variable done_cv;
+
+    // no copying
+    TaskScheduler(const TaskScheduler&);
+    TaskScheduler& operator=(const TaskScheduler&);
+
+    void worker_loop(int index);
+    bool run_one(int index);
+    bool pop(int index, Task& task);
+    bool pop_urgent(Task& task);
+    bool steal(int index, Task& task);
+};
+
+/**
+ * @brief Class meant to represent a graph of tasks and their dependencies,
+ * executed by a TaskScheduler.
+ *
+ * A task is started as soon as all the tasks it depends on have finished, so
+ * independent parts of an algorithm (eg. the next panel of a factorisation
+ * and the rest of the current trailing update) overlap.
+ */
+class TaskGraph {
+public:
+    /**
+     * @brief Default constructor, creates an empty graph.
+     */
+    TaskGraph();
+
+    /**
+     * @brief Destructor.
+     */
+    ~TaskGraph();
+
+    /**
+     * @brief Adds a task to the graph.
+     * @param task Task.
+     * @return Identifier of the task.
+     */
+    int add(const TaskScheduler::Task& task);
+
+    /**
+     * @brief Adds a task to the graph, to be run by a given worker.
+     * @param task Task.
+     * @param worker Index of the worker (see TaskScheduler::submit()).
+     * @return Identifier of the task.
+     */
+    int add(const TaskScheduler::Task& task, int worker);
+
+    /**
+     * @brief Adds a dependency between two tasks.
+     * @param before Identifier of the task which has to finish first.
+     * @param after Identifier of the task which depends on it.
+     */
+    void precede(int before, int after);
+
+    /**
+     * @brief Executes all tasks of the graph and waits for them.
+     * @param sched Scheduler which executes the tasks.
+     *
+     * When a task throws, the tasks depending on it are still run and the
+     * first exception is rethrown once the whole graph has finished.
+     */
+    void run(TaskScheduler& sched);
+
+private:
+    struct Node {
+        TaskScheduler::Task task;
+        std::vector<int> successors;
+        int ndeps;
+        int worker;             // worker to run the task, -1 for any
+        std::atomic<int> deps;  // unfinished dependencies
+    };
+
+    std::vector<Node*> nodes;
+    std::atomic<int> pending;   // unfinished tasks
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    // no copying
+    TaskGraph(const TaskGraph&);
+    TaskGraph& operator=(const TaskGraph&);
+
+    void submit(TaskScheduler& sched, int id);
+    void execute(TaskScheduler& sched, int id);
+};
+
+#endif /* TASK_SCHEDULER_H */
@@ -0,0 +1,238 @@
+#include "TiledLU.h"
+#include "MathBlas.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include <cmath>
+#include <stdexcept>
+
+// TASKS
+// All tasks work on views of the whole matrix a; c0, r0 and j0 are the first
+// column, row and column of the tiles they work on.
+
+// swap rows r1 and r2 in columns [j0, j0 + jb)
+static void swap_rows(MatrixView<double> a, Index r1, Index r2, Index j0,
+                      Index jb)
+{
+    double* p1 = a.data() + r1 * a.getRowStride() + j0;
+    double* p2 = a.data() + r2 * a.getRowStride() + j0;
+    double tmp;
+
+    for (Index j = 0; j < jb; ++j)
+    {
+        tmp = p1[j];
+        p1[j] = p2[j];
+        p2[j] = tmp;
+    }
+}
+
+// factorise the panel of columns [c0, c0 + kb), rows c0 to n-1, with partial
+// pivoting; row interchanges are applied within the panel only
+static void panel_task(MatrixView<double> a, int* ipiv, Index c0, Index kb)
+{
+    Index n = a.getNrows();
+    Index r, c, jj, col, pr;
+    double amax, v, mult;
+
+    MATH_TRACE_SCOPE("panel");
+
+    for (jj = 0; jj < kb; ++jj)
+    {
+        col = c0 + jj;
+
+        // find the pivot in column col
+        pr = col;
+        amax = fabs(a(col, col));
+        for (r = col + 1; r < n; ++r)
+        {
+            v = fabs(a.data()[r * a.getRowStride() + col]);
+            if (v > amax)
+            {
+                amax = v;
+                pr = r;
+            }
+        }
+        if (amax == 0)
+            throw std::runtime_error("matrix is singular");
+
+        ipiv[col] = (int)pr;
+        if (pr != col)
+            swap_rows(a, col, pr, c0, kb);
+
+        // eliminate below the pivot, within the panel
+        const double* pivrow = a.data() + col * a.getRowStride();
+        for (r = col + 1; r < n; ++r)
+        {
+            double* row = a.data() + r * a.getRowStride();
+            mult = row[col] / pivrow[col];
+            row[col] = mult;                        // entries of L
+            for (c = col + 1; c < c0 + kb; ++c)
+                row[c] -= mult * pivrow[c];         // entries of U
+        }
+    }
+}
+
+// apply the interchanges of panel [c0, c0 + kb) to columns [j0, j0 + jb)
+// and solve L_kk X = A_kj, leaving the tile of U in A_kj
+static void update_task(MatrixView<double> a, const int* ipiv, Index c0,
+                        Index kb, Index j0, Index jb)
+{
+    Index r, q, j, col;
+    Index rs = a.getRowStride();
+
+    MATH_TRACE_SCOPE("update");
+
+    for (col = c0; col < c0 + kb; ++col)
+        if (ipiv[col] != col)
+            swap_rows(a, col, ipiv[col], j0, jb);
+
+    // forward substitution with the unit lower triangular tile L_kk
+    for (r = 1; r < kb; ++r)
+    {
+        double* xr = a.data() + (c0 + r) * rs + j0;
+        for (q = 0; q < r; ++q)
+        {
+            double lrq = a.data()[(c0 + r) * rs + c0 + q];
+            const double* xq = a.data() + (c0 + q) * rs + j0;
+            for (j = 0; j < jb; ++j)
+                xr[j] -= lrq * xq[j];
+        }
+    }
+}
+
+// A_ij -= A_ik A_kj for all tiles i below panel [c0, c0 + kb) in the tile
+// column [j0, j0 + jb), as one product
+static void gemm_task(MatrixView<double> a, Index c0, Index kb, Index j0,
+                      Index jb)
+{
+    Index r0 = c0 + kb;
+
+    MATH_TRACE_SCOPE("tile gemm");
+    if (r0 < a.getNrows())
+        gemm(NO_TRANS, NO_TRANS, -1.0, a.block(r0, c0, a.getNrows() - r0, kb),
+             a.block(c0, j0, kb, jb), 1.0,
+             a.block(r0, j0, a.getNrows() - r0, jb));
+}
+
+// TILED LU FACTORISATION
+void lu_fact_tiled(MathMatrix& a, Vector<int>& ipiv, TaskScheduler& sched,
+                   int nb)
+{
+    Index n = a.get_size();
+    Index nt, j, k;
+
+    if (nb <= 0)
+        throw std::invalid_argument("tile size not positive");
+    if (!fits_int(n))
+        throw std::length_error("matrix size overflow");  // int pivots
+
+    ipiv = Vector<int>(n);
+    if (n == 0)
+        return;
+
+    MATH_TRACE_SCOPE("lu_fact_tiled");
+
+    nt = (n + nb - 1) / nb;  // number of tile rows and columns
+    if (!fits_int(nt + nt * (nt - 1) / 2))
+        throw std::length_error("too many tiles");  // int task identifiers
+
+    MatrixView<double> av = view(a);
+    int* piv = ipiv.data();
+
+    // task identifiers: panel[k], and column[k * nt + j] for the update of
+    // tile column j by panel k (interchanges, triangular solve and products)
+    std::vector<int> panel(nt), column(nt * nt, -1);
+    TaskGraph graph;
+
+    for (k = 0; k < nt; ++k)
+    {
+        Index c0 = k * nb;
+        Index kb = n - c0 < nb ? n - c0 : nb;
+
+        panel[k] = graph.add([=] { panel_task(av, piv, c0, kb); });
+
+        // the panel needs its tile column updated by the previous step
+        if (k > 0)
+            graph.precede(column[(k - 1) * nt + k], panel[k]);
+
+        for (j = k + 1; j < nt; ++j)
+        {
+            Index j0 = j * nb;
+            Index jb = n - j0 < nb ? n - j0 : nb;
+
+            column[k * nt + j] = graph.add([=] {
+                update_task(av, piv, c0, kb, j0, jb);
+                gemm_task(av, c0, kb, j0, jb);
+            });
+
+            // the update needs the panel and the tile column updated by the
+            // previous step
+            graph.precede(panel[k], column[k * nt + j]);
+            if (k > 0)
+                graph.precede(column[(k - 1) * nt + j], column[k * nt + j]);
+        }
+    }
+
+    graph.run(sched);
+
+    // apply the interchanges of the later panels to the columns of L, one
+    // independent task per tile column
+    TaskGraph swaps;
+    for (j = 0; j < nt - 1; ++j)
+    {
+        Index j0 = j * nb;
+        swaps.add([=] {
+            for (Index col = j0 + nb; col < n; ++col)
+                if (piv[col] != col)
+                    swap_rows(av, col, piv[col], j0, nb);
+        });
+    }
+    swaps.run(sched);
+}
+
+void lu_fact_tiled(const MathMatrix& a, MathMatrix& l, MathMatrix& u,
+                   MathMatrix& p, TaskScheduler& sched, int nb)
+{
+    Index n = a.get_size();
+    Index i, j;
+    int tmp;
+
+    MathMatrix temp = a;  // copy a to temp
+    Vector<int> ipiv, perm(n);
+
+    lu_fact_tiled(temp, ipiv, sched, nb);
+
+    l = MathMatrix(n);
+    u = MathMatrix(n);
+    p = MathMatrix(n);
+
+    // create l and u from temp, through pointers taken once
+    const double* pt = temp.data();
+    double* pl = l.data();
+    double* pu = u.data();
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < i; ++j)
+            pl[i * n + j] = pt[i * n + j];
+        pl[i * n + i] = 1.0;
+        for (j = i; j < n; ++j)
+            pu[i * n + j] = pt[i * n + j];
+    }
+
+    // row i of PA is row perm[i] of A
+    for (i = 0; i < n; ++i)
+        perm[i] = i;
+    for (i = 0; i < n; ++i)
+    {
+        tmp = perm[i];
+        perm[i] = perm[ipiv[i]];
+        perm[ipiv[i]] = tmp;
+    }
+    for (i = 0; i < n; ++i)
+        p(i, perm[i]) = 1.0;
+}
+
+void lu_fact_tiled(const MathMatrix& a, MathMatrix& l, MathMatrix& u,
+                   MathMatrix& p, int nb)
+{
+    lu_fact_tiled(a, l, u, p, default_scheduler(), nb);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file TiledLU.h
+ * @brief Header file containing the multithreaded, tile-based LU
+ * factorisation routines.
+ */
+#ifndef TILED_LU_H
+#define TILED_LU_H
+
+#include "MathMatrix.h"
+#include "TaskScheduler.h"
+
+/**
+ * @brief Multithreaded LU factorisation with partial pivoting, in place.
+ * @param a Square matrix, overwritten by L (below the diagonal, without its
+ * unit diagonal) and U.
+ * @param ipiv Reference to Vector for storing the pivots: row r was swapped
+ * with row ipiv[r], for r = 0, 1, ..., n-1 in that order.
+ * @param sched Scheduler which executes the tasks.
+ * @param nb Size of the tiles.
+ *
+ * The matrix is split into nb x nb tiles and the factorisation into tasks:
+ * panel factorisations, and for each tile column right of a panel one task
+ * applying its row interchanges and triangular solve and the matrix product
+ * updating the trailing tiles of the column. The tasks form a dependency
+ * graph run by sched, so the factorisation of panel k+1 starts as soon as
+ * its own tile column is updated, while the rest of the trailing update of
+ * panel k is still running (look-ahead). The graph has O((n/nb)^2) tasks
+ * and dependencies.
+ *
+ * It throws an exception when the matrix is singular, or std::length_error
+ * when its size does not fit the int pivots or the number of tasks the int
+ * task identifiers.
+ */
+void lu_fact_tiled(MathMatrix& a, Vector<int>& ipiv, TaskScheduler& sched,
+                   int nb = 128);
+
+/**
+ * @brief Multithreaded LU factorisation with partial pivoting.
+ * @param a Input matrix reference.
+ * @param l Reference to MathMatrix for storing lower triangular matrix.
+ * @param u Reference to MathMatrix for storing upper triangular matrix.
+ * @param p Reference to MathMatrix for storing permutation matrix.
+ * @param sched Scheduler which executes the tasks.
+ * @param nb Size of the tiles.
+ *
+ * Produces the factorisation PA = LU, so the system Ax = b can be solved by
+ * lu_solve(l, u, p * b, n, x).
+ */
+void lu_fact_tiled(const MathMatrix& a, MathMatrix& l, MathMatrix& u,
+                   MathMatrix& p, TaskScheduler& sched, int nb = 128);
+
+/**
+ * @brief Multithreaded LU factorisation with partial pivoting on the
+ * library thread pool.
+ * @param a Input matrix reference.
+ * @param l Reference to MathMatrix for storing lower triangular matrix.
+ * @param u Reference to MathMatrix for storing upper triangular matrix.
+ * @param p Reference to MathMatrix for storing permutation matrix.
+ * @param nb Size of the tiles.
+ *
+ * Same as the routine above, run by default_scheduler() (see Parallel.h).
+ */
+void lu_fact_tiled(const MathMatrix& a, MathMatrix& l, MathMatrix& u,
+                   MathMatrix& p, int nb = 128);
+
+#endif /* TILED_LU_H */
@@ -0,0 +1,202 @@
+#include "Trace.h"
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <string>
+
+std::atomic<bool> trace_on(false);
+
+// one complete event, times in microseconds
+struct TraceEvent {
+    const char* name;
+    double start, dur;
+};
+
+// ring buffer of one thread; only that thread writes the events and head,
+// other threads read them for export
+struct TraceBuffer {
+    TraceEvent events[TRACE_BUFFER_SIZE];
+    std::atomic<long long> head;   // number of events recorded
+    std::atomic<long long> first;  // first event not cleared
+    std::atomic<bool> finished;    // the thread has exited
+    int id;
+    std::string name;              // guarded by the registry mutex
+};
+
+// every buffer, of live and of finished threads; allocated once and never
+// freed, so it outlives the threads finishing during program exit
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<TraceBuffer*> buffers;
+    int next_id;
+};
+
+static TraceRegistry& registry()
+{
+    static TraceRegistry* r = new TraceRegistry();
+    return *r;
+}
+
+// buffer of the calling thread, created on its first event; the events stay
+// for export when the thread exits
+struct BufferHolder {
+    TraceBuffer* buffer;
+
+    BufferHolder() : buffer(0) {}
+    ~BufferHolder()
+    {
+        if (buffer)
+            buffer->finished.store(true);
+    }
+};
+
+static thread_local BufferHolder holder;
+
+static TraceBuffer* local_buffer()
+{
+    if (!holder.buffer)
+    {
+        TraceBuffer* b = new TraceBuffer;
+        b->head.store(0);
+        b->first.store(0);
+        b->finished.store(false);
+
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        b->id = r.next_id++;
+        r.buffers.push_back(b);
+        holder.buffer = b;
+    }
+    return holder.buffer;
+}
+
+// SWITCH AND CLOCK
+static const std::chrono::steady_clock::time_point epoch =
+    std::chrono::steady_clock::now();
+
+void trace_enable(bool on)
+{
+    trace_on.store(on);
+}
+
+double trace_now()
+{
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+// RECORDING
+void trace_record(const char* name, double start, double end)
+{
+    TraceBuffer* b = local_buffer();
+    long long h = b->head.load(std::memory_order_relaxed);
+
+    TraceEvent& e = b->events[h % TRACE_BUFFER_SIZE];
+    e.name = name;
+    e.start = start;
+    e.dur = end - start;
+
+    // publishes the event to the exporting thread
+    b->head.store(h + 1, std::memory_order_release);
+}
+
+void trace_thread_name(const char* name, int index)
+{
+    TraceBuffer* b = local_buffer();
+    std::string s = name;
+
+    if (index >= 0)
+        s += " " + std::to_string(index);
+
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    b->name = s;
+}
+
+// EXPORT
+// JSON string, the names need no escaping beyond quotes and backslashes
+static void write_string(std::ostream& os, const std::string& s)
+{
+    os << '"';
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '"' || s[i] == '\\')
+            os << '\\';
+        os << s[i];
+    }
+    os << '"';
+}
+
+void trace_export(std::ostream& os)
+{
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<TraceEvent> events;
+    bool first = true;
+
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os.setf(std::ios::fixed, std::ios::floatfield);
+    os.precision(3);
+
+    os << "{\"traceEvents\": [";
+    for (size_t i = 0; i < r.buffers.size(); ++i)
+    {
+        TraceBuffer* b = r.buffers[i];
+        long long k, lo, h = b->head.load(std::memory_order_acquire);
+
+        lo = b->first.load();
+        if (lo < h - TRACE_BUFFER_SIZE)
+            lo = h - TRACE_BUFFER_SIZE;
+        events.clear();
+        for (k = lo; k < h; ++k)
+            events.push_back(b->events[k % TRACE_BUFFER_SIZE]);
+
+        // events overwritten while copied are dropped
+        long long h2 = b->head.load(std::memory_order_acquire);
+        size_t skip = 0;
+        if (lo < h2 - TRACE_BUFFER_SIZE)
+            skip = h2 - TRACE_BUFFER_SIZE - lo;
+
+        os << (first ? "\n" : ",\n")
+           << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+           << "\"tid\": " << b->id << ", \"args\": {\"name\": ";
+        write_string(os, b->name.empty() ? "thread " + std::to_string(b->id)
+                                         : b->name);
+        os << "}}";
+        first = false;
+
+        for (size_t e = skip; e < events.size(); ++e)
+        {
+            os << ",\n{\"name\": ";
+            write_string(os, events[e].name);
+            os << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b->id
+               << ", \"ts\": " << events[e].start
+               << ", \"dur\": " << events[e].dur << "}";
+        }
+    }
+    os << "\n], \"displayTimeUnit\": \"ms\"}" << std::endl;
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void trace_clear()
+{
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<TraceBuffer*> live;
+
+    for (size_t i = 0; i < r.buffers.size(); ++i)
+    {
+        TraceBuffer* b = r.buffers[i];
+        if (b->finished.load())
+            delete b;
+        else
+        {
+            b->first.store(b->head.load(std::memory_order_acquire));
+            live.push_back(b);
+        }
+    }
+    r.buffers.swap(live);
+}
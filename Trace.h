@@ -0,0 +1,150 @@
+/**
+ * @file Trace.h
+ * @brief Header file containing the scoped tracing of the library.
+ *
+ * The major phases of the library routines (the passes of inverse(), the
+ * factorisations, the solves, the products, the tasks of the thread pool)
+ * are marked by MATH_TRACE_SCOPE(). When tracing is on, every marked scope
+ * records an event with its name, thread, start time and duration, which
+ * trace_export() writes as Chrome trace-event JSON, viewable in
+ * chrome://tracing or Perfetto.
+ *
+ * The scopes are compiled in only when MATH_TRACE is defined; otherwise
+ * they expand to nothing. When compiled in, tracing is still off until
+ * trace_enable() is called, and a scope then costs one relaxed atomic load.
+ *
+ * Every thread records into its own ring buffer of TRACE_BUFFER_SIZE events,
+ * written by that thread only, without locks; when it is full the oldest
+ * events are overwritten.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+#include <atomic>
+
+/**
+ * @brief Number of events of the ring buffer of every thread.
+ */
+const int TRACE_BUFFER_SIZE = 1 << 16;
+
+// tracing switch, read by trace_enabled()
+extern std::atomic<bool> trace_on;
+
+/**
+ * @brief Turns tracing on or off.
+ * @param on True to record events.
+ */
+void trace_enable(bool on);
+
+/**
+ * @brief Tells whether tracing is on.
+ * @return True when events are recorded.
+ */
+inline bool trace_enabled()
+{
+    return trace_on.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Current time of the trace clock.
+ * @return Microseconds since the start of the program.
+ */
+double trace_now();
+
+/**
+ * @brief Records a complete event in the ring buffer of the calling thread.
+ * @param name Name of the event, a string which outlives the trace (e.g. a
+ * string literal).
+ * @param start Start time, from trace_now().
+ * @param end End time, from trace_now().
+ */
+void trace_record(const char* name, double start, double end);
+
+/**
+ * @brief Names the calling thread in the trace.
+ * @param name Name, e.g. "worker".
+ * @param index Number appended to the name, or -1 for none.
+ *
+ * Threads not named are called "thread" followed by their number in the
+ * trace.
+ */
+void trace_thread_name(const char* name, int index = -1);
+
+/**
+ * @brief Writes the recorded events as Chrome trace-event JSON.
+ * @param os Output stream reference.
+ *
+ * Best called when the traced work has finished: events overwritten while
+ * they are written out are left out.
+ */
+void trace_export(std::ostream& os);
+
+/**
+ * @brief Discards the recorded events.
+ */
+void trace_clear();
+
+/**
+ * @brief Class meant to represent a traced scope.
+ *
+ * The constructor notes the start time when tracing is on, the destructor
+ * records the event. Use it through MATH_TRACE_SCOPE().
+ */
+class TraceScope {
+private:
+    const char* name;
+    double start;
+
+public:
+    /**
+     * @brief Constructor, opens the scope.
+     * @param name Name of the event, a string which outlives the trace.
+     */
+    explicit TraceScope(const char* name)
+        : name(trace_enabled() ? name : 0), start(0)
+    {
+        if (this->name)
+            start = trace_now();
+    }
+
+    /**
+     * @brief Destructor, closes the scope and records its event.
+     */
+    ~TraceScope()
+    {
+        if (name)
+            trace_record(name, start, trace_now());
+    }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+};
+
+/**
+ * @brief Traces the enclosing scope under the given name.
+ *
+ * Expands to nothing unless MATH_TRACE is defined.
+ */
+#ifdef MATH_TRACE
+#define MATH_TRACE_SCOPE(name) \
+    TraceScope MATH_TRACE_CAT(trace_scope_, __LINE__)(name)
+#define MATH_TRACE_CAT(a, b) MATH_TRACE_CAT2(a, b)
+#define MATH_TRACE_CAT2(a, b) a##b
+#else
+#define MATH_TRACE_SCOPE(name) ((void)0)
+#endif
+
+/**
+ * @brief Names the calling thread in the trace, see trace_thread_name().
+ *
+ * Expands to nothing unless MATH_TRACE is defined.
+ */
+#ifdef MATH_TRACE
+#define MATH_TRACE_THREAD(name, index) trace_thread_name(name, index)
+#else
+#define MATH_TRACE_THREAD(name, index) ((void)0)
+#endif
+
+#endif /* TRACE_H */
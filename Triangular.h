@@ -0,0 +1,637 @@
+/**
+ * @file Triangular.h
+ * @brief Header file containing the packed triangular matrices and their
+ * kernels: triangular multiplication (TRMM), solve and inverse.
+ *
+ * A triangular matrix stores only its triangle, packed row by row: about
+ * n^2 / 2 elements instead of n^2. The unit variants (the L of an LU
+ * factorisation) do not store their diagonal either, which is all ones. The
+ * kernels loop over the stored elements only, so they do half the work of
+ * their dense counterparts, or less: a triangular by dense product costs
+ * n^2 m flops instead of 2 n^2 m, the product L U of two triangles 2/3 n^3
+ * instead of 2 n^3.
+ *
+ * The rows are contiguous, so the inner loops of the kernels run along
+ * contiguous memory, in the packed matrix and in the row-major dense
+ * operands.
+ */
+#ifndef TRIANGULAR_H
+#define TRIANGULAR_H
+
+#include <iostream>
+#include <stdexcept>
+#include "MathBlas.h"
+#include "MathMatrix.h"
+#include "MathVector.h"
+#include "Parallel.h"
+#include "view.h"
+
+/**
+ * @brief Class meant to represent a square triangular matrix in packed
+ * storage.
+ *
+ * UPLO tells whether the lower or the upper triangle is stored, DIAG whether
+ * the diagonal is stored (NON_UNIT) or implicitly all ones (UNIT). Row i
+ * stores the columns [first(i), last(i)) contiguously; the elements outside
+ * them are zero, or one on the diagonal of a unit matrix.
+ */
+template <UpLo UPLO, Diag DIAG>
+class TriangularMatrix {
+private:
+    Vector<double> v;  // packed rows
+    Index n;           // size of the matrix
+
+    // position of the first element stored in row i
+    Index offset(Index i) const;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Default constructor, an empty matrix.
+     */
+    TriangularMatrix();
+
+    /**
+     * @brief Alternate constructor.
+     * @param n Size of the matrix.
+     * @param init Initialisation of the stored elements, zero-filled by
+     * default.
+     *
+     * It throws an exception when n is negative.
+     */
+    explicit TriangularMatrix(Index n, Initialization init = ZERO_INIT);
+
+    /**
+     * @brief Alternate constructor, copies the triangle of a square matrix.
+     * @param a View of the square matrix.
+     *
+     * The other elements of a, and its diagonal for a unit matrix, are not
+     * read. It throws an exception when a is not square.
+     */
+    explicit TriangularMatrix(MatrixView<const double> a);
+
+    // STORAGE
+    /**
+     * @brief Number of elements stored for a given size.
+     * @param n Size of the matrix.
+     * @return n (n + 1) / 2, or n (n - 1) / 2 for a unit matrix.
+     */
+    static Index packed_size(Index n);
+
+    /**
+     * @brief Returns size of a matrix.
+     * @return Size of a matrix.
+     */
+    Index get_size() const;
+
+    /**
+     * @brief First column stored in a row.
+     * @param i Row.
+     * @return 0 for a lower matrix, i or i + 1 (unit) for an upper one.
+     */
+    Index first(Index i) const;
+
+    /**
+     * @brief One past the last column stored in a row.
+     * @param i Row.
+     * @return i + 1 or i (unit) for a lower matrix, n for an upper one.
+     */
+    Index last(Index i) const;
+
+    /**
+     * @brief Stored elements of a row.
+     * @param i Row.
+     * @return Pointer to element (i, first(i)), followed by the elements up to
+     * column last(i) - 1.
+     */
+    double* row(Index i);
+
+    /**
+     * @brief Stored elements of a row.
+     * @param i Row.
+     * @return Pointer to element (i, first(i)).
+     */
+    const double* row(Index i) const;
+
+    /**
+     * @brief Returns pointer to the packed elements.
+     * @return Pointer to the packed_size() elements, row after row.
+     */
+    double* data();
+
+    /**
+     * @brief Returns pointer to the packed elements.
+     * @return Pointer to the packed_size() elements, row after row.
+     */
+    const double* data() const;
+
+    // ACCESS
+    /**
+     * @brief Element of the matrix.
+     * @param i Row.
+     * @param j Column.
+     * @return Element (i, j), zero outside the triangle.
+     *
+     * It throws an exception when given out of range index.
+     */
+    double operator()(Index i, Index j) const;
+
+    /**
+     * @brief Stored element of the matrix, for assigning values.
+     * @param i Row.
+     * @param j Column.
+     * @return Reference to element (i, j).
+     *
+     * Unlike operator(), it throws an exception when given an element which
+     * is not stored (outside the triangle, or on the diagonal of a unit
+     * matrix), as well as an out of range index.
+     */
+    double& element(Index i, Index j);
+
+    /**
+     * @brief Diagonal element.
+     * @param i Row.
+     * @return Element (i, i), 1 for a unit matrix.
+     */
+    double diagonal(Index i) const;
+
+    /**
+     * @brief Full matrix.
+     * @return Dense copy, zeros included.
+     */
+    MathMatrix dense() const;
+
+    // KERNELS
+    /**
+     * @brief Compute the inverse matrix.
+     * @return Inverse, triangular of the same kind.
+     *
+     * It throws an exception when the matrix is singular.
+     */
+    TriangularMatrix<UPLO, DIAG> inverse() const;
+
+    /**
+     * @brief Compute the inverse matrix.
+     * @param policy Execution policy.
+     * @return Inverse, triangular of the same kind.
+     *
+     * Every column of the inverse is a substitution along the packed rows,
+     * n^3 / 3 flops in all; with a parallel policy the columns are computed
+     * in parallel. It throws an exception when the matrix is singular.
+     */
+    TriangularMatrix<UPLO, DIAG> inverse(ExecutionPolicy policy) const;
+
+    /**
+     * @brief Solves the equation Tx = b.
+     * @param b Vector b.
+     * @return Solution x.
+     *
+     * It throws an exception when the sizes do not match or the matrix is
+     * singular.
+     */
+    MathVector solve(const MathVector& b) const;
+
+    /**
+     * @brief Matrix by vector multiplication.
+     * @param x Vector to multiply object with.
+     * @return Product Tx.
+     */
+    MathVector operator*(const MathVector& x) const;
+
+    /**
+     * @brief Matrix by matrix multiplication.
+     * @param b Dense matrix to multiply object with.
+     * @return Product TB, computed by trmm().
+     */
+    MathMatrix operator*(const MathMatrix& b) const;
+};
+
+/**
+ * @brief Lower triangular matrix.
+ */
+typedef TriangularMatrix<LOWER, NON_UNIT> LowerTriangular;
+
+/**
+ * @brief Lower triangular matrix of unit diagonal, eg. the L of an LU
+ * factorisation.
+ */
+typedef TriangularMatrix<LOWER, UNIT> UnitLowerTriangular;
+
+/**
+ * @brief Upper triangular matrix, eg. the U of an LU factorisation.
+ */
+typedef TriangularMatrix<UPPER, NON_UNIT> UpperTriangular;
+
+/**
+ * @brief Upper triangular matrix of unit diagonal.
+ */
+typedef TriangularMatrix<UPPER, UNIT> UnitUpperTriangular;
+
+// KERNELS
+/**
+ * @brief Triangular by dense matrix multiplication in place, B = T B.
+ * @param t Triangular matrix T.
+ * @param b View of the matrix B, n rows, overwritten by the product.
+ *
+ * It throws an exception when the sizes do not match.
+ */
+template <UpLo UPLO, Diag DIAG>
+void trmm(const TriangularMatrix<UPLO, DIAG>& t, MatrixView<double> b);
+
+/**
+ * @brief Triangular solve in place, B = T^-1 B.
+ * @param t Triangular matrix T.
+ * @param b View of the right-hand sides B, n rows, overwritten by the
+ * solutions.
+ *
+ * It throws an exception when the sizes do not match or T is singular.
+ */
+template <UpLo UPLO, Diag DIAG>
+void trsm(const TriangularMatrix<UPLO, DIAG>& t, MatrixView<double> b);
+
+/**
+ * @brief Product of a lower and an upper triangular matrix, or of an upper
+ * and a lower one.
+ * @param policy Execution policy.
+ * @param a Left-side triangular matrix.
+ * @param b Right-side triangular matrix, of the other triangle.
+ * @return Dense product.
+ *
+ * Only the products of stored elements are computed: 2/3 n^3 flops. With a
+ * parallel policy the rows of the product are computed in parallel. It
+ * throws an exception when the sizes do not match.
+ */
+template <UpLo UA, Diag DA, UpLo UB, Diag DB>
+MathMatrix multiply(ExecutionPolicy policy, const TriangularMatrix<UA, DA>& a,
+                    const TriangularMatrix<UB, DB>& b);
+
+/**
+ * @brief Product of a lower and an upper triangular matrix, or of an upper
+ * and a lower one, as multiply(SEQ, a, b).
+ * @param a Left-side triangular matrix.
+ * @param b Right-side triangular matrix, of the other triangle.
+ * @return Dense product.
+ */
+template <UpLo UA, Diag DA, UpLo UB, Diag DB>
+MathMatrix operator*(const TriangularMatrix<UA, DA>& a,
+                     const TriangularMatrix<UB, DB>& b);
+
+/**
+ * @brief Overloaded ostream operator for screen output.
+ * @param os Output stream reference.
+ * @param t Triangular matrix.
+ * @return Reference to the left-side operand stream.
+ *
+ * Prints the full matrix, as the output of Matrix.
+ */
+template <UpLo UPLO, Diag DIAG>
+std::ostream& operator<<(std::ostream& os,
+                         const TriangularMatrix<UPLO, DIAG>& t);
+
+// CONSTRUCTORS
+template <UpLo UPLO, Diag DIAG>
+TriangularMatrix<UPLO, DIAG>::TriangularMatrix() : n(0) {}
+
+template <UpLo UPLO, Diag DIAG>
+TriangularMatrix<UPLO, DIAG>::TriangularMatrix(Index n, Initialization init)
+    : n(n)
+{
+    if (n < 0)
+        throw std::invalid_argument("matrix size negative");
+
+    v = Vector<double>(packed_size(n), init);
+}
+
+template <UpLo UPLO, Diag DIAG>
+TriangularMatrix<UPLO, DIAG>::TriangularMatrix(MatrixView<const double> a)
+    : n(a.getNrows())
+{
+    if (a.getNcols() != n)
+        throw std::invalid_argument("matrix not square");
+
+    v = Vector<double>(packed_size(n), UNINITIALIZED);
+    for (Index i = 0; i < n; ++i)
+    {
+        double* r = row(i);
+        for (Index j = first(i); j < last(i); ++j)
+            r[j - first(i)] = a(i, j);
+    }
+}
+
+// STORAGE
+template <UpLo UPLO, Diag DIAG>
+Index TriangularMatrix<UPLO, DIAG>::packed_size(Index n)
+{
+    return n * (n + 1) / 2 - (DIAG == UNIT ? n : 0);
+}
+
+template <UpLo UPLO, Diag DIAG>
+Index TriangularMatrix<UPLO, DIAG>::get_size() const
+{
+    return n;
+}
+
+template <UpLo UPLO, Diag DIAG>
+Index TriangularMatrix<UPLO, DIAG>::first(Index i) const
+{
+    return UPLO == LOWER ? 0 : (DIAG == UNIT ? i + 1 : i);
+}
+
+template <UpLo UPLO, Diag DIAG>
+Index TriangularMatrix<UPLO, DIAG>::last(Index i) const
+{
+    return UPLO == UPPER ? n : (DIAG == UNIT ? i : i + 1);
+}
+
+// rows before i hold sum of (last(r) - first(r)) elements for r < i
+template <UpLo UPLO, Diag DIAG>
+Index TriangularMatrix<UPLO, DIAG>::offset(Index i) const
+{
+    Index d = DIAG == UNIT ? 1 : 0;
+
+    if (UPLO == LOWER)
+        return i * (i + 1) / 2 - d * i;
+    return i * (n - d) - i * (i - 1) / 2;
+}
+
+template <UpLo UPLO, Diag DIAG>
+double* TriangularMatrix<UPLO, DIAG>::row(Index i)
+{
+    return v.data() + offset(i);
+}
+
+// through the const data(), so that reading a shared matrix does not copy it
+template <UpLo UPLO, Diag DIAG>
+const double* TriangularMatrix<UPLO, DIAG>::row(Index i) const
+{
+    return data() + offset(i);
+}
+
+template <UpLo UPLO, Diag DIAG>
+double* TriangularMatrix<UPLO, DIAG>::data()
+{
+    return v.data();
+}
+
+template <UpLo UPLO, Diag DIAG>
+const double* TriangularMatrix<UPLO, DIAG>::data() const
+{
+    return v.data();
+}
+
+// ACCESS
+template <UpLo UPLO, Diag DIAG>
+double TriangularMatrix<UPLO, DIAG>::operator()(Index i, Index j) const
+{
+    if (i < 0 || j < 0 || i >= n || j >= n)
+        throw std::out_of_range("matrix access error");
+
+    if (j >= first(i) && j < last(i))
+        return row(i)[j - first(i)];
+    return i == j ? 1.0 : 0.0;  // only a unit diagonal is not stored
+}
+
+template <UpLo UPLO, Diag DIAG>
+double& TriangularMatrix<UPLO, DIAG>::element(Index i, Index j)
+{
+    if (i < 0 || j < 0 || i >= n || j >= n)
+        throw std::out_of_range("matrix access error");
+    if (j < first(i) || j >= last(i))
+        throw std::out_of_range("element not stored");
+
+    return row(i)[j - first(i)];
+}
+
+template <UpLo UPLO, Diag DIAG>
+double TriangularMatrix<UPLO, DIAG>::diagonal(Index i) const
+{
+    return DIAG == UNIT ? 1.0 : row(i)[i - first(i)];
+}
+
+template <UpLo UPLO, Diag DIAG>
+MathMatrix TriangularMatrix<UPLO, DIAG>::dense() const
+{
+    MathMatrix a(n);
+
+    for (Index i = 0; i < n; ++i)
+    {
+        const double* r = row(i);
+        for (Index j = first(i); j < last(i); ++j)
+            a(i, j) = r[j - first(i)];
+        if (DIAG == UNIT)
+            a(i, i) = 1;
+    }
+    return a;
+}
+
+// KERNELS
+template <UpLo UPLO, Diag DIAG>
+TriangularMatrix<UPLO, DIAG> TriangularMatrix<UPLO, DIAG>::inverse() const
+{
+    return inverse(SEQ);
+}
+
+// column j of the inverse by substitution: x_j = 1 / t_jj and, away from
+// the diagonal, x_i = -(sum over k between j and i of t_ik x_k) / t_ii,
+// i running down the column for a lower matrix, up for an upper one
+template <UpLo UPLO, Diag DIAG>
+TriangularMatrix<UPLO, DIAG> TriangularMatrix<UPLO, DIAG>::inverse(
+    ExecutionPolicy policy) const
+{
+    TriangularMatrix<UPLO, DIAG> inv(n, UNINITIALIZED);
+
+    for (Index i = 0; i < n; ++i)
+        if (diagonal(i) == 0)
+            throw std::runtime_error("matrix is singular");
+
+    int nch = policy == SEQ ? 1 : num_chunks(n, 16);
+    parallel_for(n, nch, [&](Index lo, Index hi, int) {
+        MathVector x(n, UNINITIALIZED);
+        for (Index j = lo; j < hi; ++j)
+        {
+            x[j] = 1 / diagonal(j);
+            if (DIAG == NON_UNIT)
+                inv.row(j)[j - first(j)] = x[j];
+
+            if (UPLO == LOWER)
+            {
+                for (Index i = j + 1; i < n; ++i)
+                {
+                    const double* r = row(i);
+                    double s = 0;
+                    for (Index k = j; k < i; ++k)
+                        s += r[k] * x[k];
+                    x[i] = -s / diagonal(i);
+                    inv.row(i)[j] = x[i];
+                }
+            }
+            else
+            {
+                for (Index i = j - 1; i >= 0; --i)
+                {
+                    const double* r = row(i);  // r[k - f] = t_ik
+                    Index f = first(i);
+                    double s = 0;
+                    for (Index k = i + 1; k <= j; ++k)
+                        s += r[k - f] * x[k];
+                    x[i] = -s / diagonal(i);
+                    inv.row(i)[j - f] = x[i];
+                }
+            }
+        }
+    });
+
+    return inv;
+}
+
+template <UpLo UPLO, Diag DIAG>
+MathVector TriangularMatrix<UPLO, DIAG>::solve(const MathVector& b) const
+{
+    if (b.size() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MathVector x(b);
+    trsm(*this, MatrixView<double>(x.data(), n, 1, 1));
+    return x;
+}
+
+template <UpLo UPLO, Diag DIAG>
+MathVector TriangularMatrix<UPLO, DIAG>::operator*(const MathVector& x) const
+{
+    if (x.size() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MathVector y(x);
+    trmm(*this, MatrixView<double>(y.data(), n, 1, 1));
+    return y;
+}
+
+template <UpLo UPLO, Diag DIAG>
+MathMatrix TriangularMatrix<UPLO, DIAG>::operator*(const MathMatrix& b) const
+{
+    if (b.getNrows() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MathMatrix c(b);
+    trmm(*this, view(c));
+    return c;
+}
+
+// row i of T B combines row i of B, scaled by the diagonal, with the rows k
+// of B for the t_ik off the diagonal; the rows not yet overwritten are those
+// above i for a lower matrix (done bottom up), below i for an upper one
+template <UpLo UPLO, Diag DIAG>
+void trmm(const TriangularMatrix<UPLO, DIAG>& t, MatrixView<double> b)
+{
+    Index n = t.get_size();
+
+    if (b.getNrows() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    for (Index s = 0; s < n; ++s)
+    {
+        Index i = UPLO == LOWER ? n - 1 - s : s;
+        const double* r = t.row(i);  // r[k - f] = t_ik
+        Index f = t.first(i);
+        Index k0 = UPLO == LOWER ? 0 : i + 1;
+        Index k1 = UPLO == LOWER ? i : n;
+
+        if (DIAG == NON_UNIT)
+            scal(r[i - f], b.row(i));
+        for (Index k = k0; k < k1; ++k)
+            axpy(r[k - f], b.row(k), b.row(i));
+    }
+}
+
+// forward substitution for a lower matrix, back substitution for an upper
+template <UpLo UPLO, Diag DIAG>
+void trsm(const TriangularMatrix<UPLO, DIAG>& t, MatrixView<double> b)
+{
+    Index n = t.get_size();
+
+    if (b.getNrows() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    for (Index s = 0; s < n; ++s)
+    {
+        Index i = UPLO == LOWER ? s : n - 1 - s;
+        const double* r = t.row(i);  // r[k - f] = t_ik
+        Index f = t.first(i);
+        Index k0 = UPLO == LOWER ? 0 : i + 1;
+        Index k1 = UPLO == LOWER ? i : n;
+
+        for (Index k = k0; k < k1; ++k)
+            axpy(-r[k - f], b.row(k), b.row(i));
+        if (DIAG == NON_UNIT)
+        {
+            if (r[i - f] == 0)
+                throw std::runtime_error("matrix is singular");
+            scal(1 / r[i - f], b.row(i));
+        }
+    }
+}
+
+// row i of the product sums the rows k of b, restricted to their stored
+// columns, weighted by the a_ik of row i of a
+template <UpLo UA, Diag DA, UpLo UB, Diag DB>
+MathMatrix multiply(ExecutionPolicy policy, const TriangularMatrix<UA, DA>& a,
+                    const TriangularMatrix<UB, DB>& b)
+{
+    static_assert(UA != UB, "multiply a lower and an upper matrix");
+
+    Index n = a.get_size();
+
+    if (b.get_size() != n)
+        throw std::invalid_argument("incompatible matrix sizes");
+
+    MathMatrix res(n);
+    int nch = policy == SEQ ? 1 : num_chunks(n, 16);
+
+    parallel_for(n, nch, [&](Index lo, Index hi, int) {
+        for (Index i = lo; i < hi; ++i)
+        {
+            double* c = &res(i, 0);
+            Index k0 = UA == LOWER ? 0 : i;
+            Index k1 = UA == LOWER ? i + 1 : n;
+
+            for (Index k = k0; k < k1; ++k)
+            {
+                double aik = k == i ? a.diagonal(i) : a(i, k);
+                const double* r = b.row(k);  // r[j - f] = b_kj
+                Index f = b.first(k);
+
+                for (Index j = f; j < b.last(k); ++j)
+                    c[j] += aik * r[j - f];
+                if (DB == UNIT)
+                    c[k] += aik;
+            }
+        }
+    });
+
+    return res;
+}
+
+template <UpLo UA, Diag DA, UpLo UB, Diag DB>
+MathMatrix operator*(const TriangularMatrix<UA, DA>& a,
+                     const TriangularMatrix<UB, DB>& b)
+{
+    return multiply(SEQ, a, b);
+}
+
+// screen output, user friendly
+template <UpLo UPLO, Diag DIAG>
+std::ostream& operator<<(std::ostream& os,
+                         const TriangularMatrix<UPLO, DIAG>& t)
+{
+    os << "The matrix elements are" << std::endl;
+    for (Index i = 0; i < t.get_size(); i++) {
+        for (Index j = 0; j < t.get_size(); j++) {
+            os << t(i, j) << " ";
+        }
+        os << "\n";
+    }
+    os << std::endl;
+    return os;
+}
+
+#endif /* TRIANGULAR_H */
@@ -0,0 +1,812 @@
+// Benchmarks of the library routines.
+//
+// usage: benchmark suite [max size] [repetitions] [warmup]
+//        benchmark lu [size]
+//        benchmark strassen [max size] [crossover]
+//        benchmark lstsq [rows] [columns]
+//        benchmark stream [length] [repetitions]
+//        benchmark backend [size]
+//        benchmark async [size] [small size]
+//        benchmark lufile [size] [file]
+//        benchmark conformance [size]
+//
+// suite (the default): every numeric and I/O entry point of the library over
+// a sweep of sizes, 32, 64, ... up to the given one (default 512); vectors
+// are swept over lengths n * n, the complex elementwise kernels (add,
+// multiply, multiply-subtract, divide) over the raw storage of the vectors,
+// as a vectorised loop runs. Every benchmark is run warmup times
+// (default 1), then timed repetitions times (default 11); a timed sample
+// repeats the call until it lasts at least a millisecond. The report, on the
+// standard output, is a JSON document with the median, 10th and 90th
+// percentiles, minimum and maximum time per call, and the GFLOP/s and GB/s
+// at the median. Flop counts are the nominal ones of each operation (e.g.
+// 2 n^3 for an inverse), not of its implementation, and byte counts the
+// minimal traffic (every operand read and the result written once), so that
+// reports of different library versions can be compared directly. When the
+// library is built with MATH_INSTRUMENT, every result also holds the nonzero
+// instrumentation counters of one call (see Instrument.h).
+//
+// lu: strong scaling, the tiled LU factorisation of a matrix of the given
+// size (default 1024) with 1, 2, 4, ... worker threads, compared with the
+// serial lu_fact(); weak scaling, the work per thread is kept constant, the
+// size of the matrix growing as the cube root of the number of threads.
+//
+// strassen: time of the Strassen-Winograd product against the classical
+// operator* for sizes up to the given one (default 2048), and the accuracy
+// of the result, max |C - C_classical| / max |C_classical|.
+//
+// lstsq: least squares min |A x - b| for a matrix of the given size (default
+// 2000 x 500), solved by the blocked QR factorisation and by the normal
+// equations A^T A x = A^T b (gemm(), then lu_fact() and lu_solve()), for
+// matrices of condition numbers 1, 10^2, ... 10^10; the accuracy reported is
+// max |x - x_true| for the consistent right-hand side b = A x_true. The
+// normal equations square the condition number, so their error grows twice
+// as fast.
+//
+// stream: memory bandwidth in GB/s of the four STREAM kernels (copy c = a,
+// scale b = s c, add c = a + b, triad a = b + s c) over vectors of the given
+// length (default 2^24 doubles, 128 MB each), for every placement policy of
+// their storage: zero-filled by one thread (the default of the
+// constructors), FIRST_TOUCH, interleaved over the NUMA nodes and bound to
+// each node. The kernels are split into chunks as the threaded routines of
+// the library; each is run the given number of times (default 10) and the
+// best time is reported, as STREAM does.
+//
+// backend: for every backend compiled in (see Backend.h), its conformance
+// with the reference (the largest relative difference of results, see
+// backend_conformance()) and the GFLOP/s of gemm() and lu_fact_pivoted() on
+// matrices of the given size (default 1024).
+//
+// async: latency in milliseconds of a small solve (default 64 x 64)
+// submitted as an asynchronous job (see Async.h) to an idle pool, then while
+// every worker runs the product of matrices of the given size (default 2048),
+// with NORMAL_PRIORITY and with URGENT_PRIORITY; and the time an inversion
+// of the given size takes to stop once cancelled.
+//
+// conformance: for every backend compiled in, its largest relative
+// difference from the reference on matrices of the given size (default 64),
+// checked against CONFORMANCE_TOLERANCE * n * DBL_EPSILON (see
+// backend_conforms()); the exit status is nonzero when a backend fails.
+//
+// lufile: time in milliseconds to factorise a matrix of the given size
+// (default 2048), to save the factorisation to the given file (default
+// lu.bin), and for a restarted process to checksum the matrix, load the
+// file and solve once (see LUFactorization.h).
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include "MathMatrix.h"
+#include "Complex.h"
+#include "Instrument.h"
+#include "TiledLU.h"
+#include "Strassen.h"
+#include "MathBlas.h"
+#include "QR.h"
+#include "Numa.h"
+#include "Backend.h"
+#include "Async.h"
+#include "LUFactorization.h"
+
+// diagonally dominant random matrix, so lu_fact() needs no pivoting
+static MathMatrix random_matrix(int n)
+{
+    MathMatrix a(n);
+
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+            a(i, j) = rand() / (double)RAND_MAX - 0.5;
+        a(i, i) += n;
+    }
+    return a;
+}
+
+// wall time of one call of f, in seconds
+template <typename F>
+static double time_it(F f)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start).count();
+}
+
+static double lu_gflops(int n, double seconds)
+{
+    return 2.0 / 3.0 * n * (double)n * n / seconds * 1e-9;
+}
+
+static void lu_scaling(int n)
+{
+    int maxthreads = std::thread::hardware_concurrency();
+    int p;
+
+    std::cout << "LU strong scaling, n = " << n << std::endl;
+    std::cout << "threads\ttime [s]\tGFLOP/s\tspeedup" << std::endl;
+
+    MathMatrix a = random_matrix(n), l, u, pm;
+
+    double serial = time_it([&] { lu_fact(a, l, u, n); });
+    std::cout << "serial\t" << serial << "\t" << lu_gflops(n, serial)
+              << "\t1" << std::endl;
+
+    for (p = 1; p <= maxthreads; p *= 2)
+    {
+        TaskScheduler sched(p);
+        double t = time_it([&] { lu_fact_tiled(a, l, u, pm, sched); });
+        std::cout << p << "\t" << t << "\t" << lu_gflops(n, t) << "\t"
+                  << serial / t << std::endl;
+    }
+
+    std::cout << std::endl << "LU weak scaling, n = " << n
+              << " per thread" << std::endl;
+    std::cout << "threads\tn\ttime [s]\tGFLOP/s\tefficiency" << std::endl;
+
+    double base = 0;
+    for (p = 1; p <= maxthreads; p *= 2)
+    {
+        int np = (int)(n * cbrt((double)p));
+        MathMatrix ap = random_matrix(np);
+        TaskScheduler sched(p);
+        double t = time_it([&] { lu_fact_tiled(ap, l, u, pm, sched); });
+        if (p == 1)
+            base = t;
+        std::cout << p << "\t" << np << "\t" << t << "\t"
+                  << lu_gflops(np, t) << "\t" << base / t << std::endl;
+    }
+}
+
+static void strassen_report(int maxn, int crossover)
+{
+    int n, i, j;
+
+    std::cout << "Strassen-Winograd, crossover = " << crossover << std::endl;
+    std::cout << "n\tclassical [s]\tstrassen [s]\tspeedup\tmax rel error"
+              << std::endl;
+
+    StrassenWorkspace ws(maxn, crossover);
+
+    for (n = 256; n <= maxn; n *= 2)
+    {
+        // an odd size too, to cover peeling
+        for (int m = n - 1; m <= n; ++m)
+        {
+            MathMatrix a = random_matrix(m), b = random_matrix(m), c, s;
+
+            double tc = time_it([&] { c = a * b; });
+            double ts = time_it([&] { strassen_multiply(a, b, s, ws,
+                                                         crossover); });
+
+            double err = 0, cmax = 0;
+            for (i = 0; i < m; ++i)
+                for (j = 0; j < m; ++j)
+                {
+                    err = fmax(err, fabs(s(i, j) - c(i, j)));
+                    cmax = fmax(cmax, fabs(c(i, j)));
+                }
+
+            std::cout << m << "\t" << tc << "\t" << ts << "\t" << tc / ts
+                      << "\t" << err / cmax << std::endl;
+        }
+    }
+}
+
+static void lstsq_report(int m, int n)
+{
+    int i, j, k;
+
+    std::cout << "Least squares, " << m << " x " << n << std::endl;
+    std::cout << "cond	QR [s]	normal [s]	QR error	normal error"
+              << std::endl;
+
+    for (k = 0; k <= 10; k += 2)
+    {
+        // A = U S V^T with U, V the orthonormal factors of random matrices
+        // and singular values S from 1 down to 10^-k
+        MathRectMatrix ru(m, n), rv(n, n), a(m, n);
+        for (i = 0; i < m; ++i)
+            for (j = 0; j < n; ++j)
+                ru(i, j) = rand() / (double)RAND_MAX - 0.5;
+        for (i = 0; i < n; ++i)
+            for (j = 0; j < n; ++j)
+                rv(i, j) = rand() / (double)RAND_MAX - 0.5;
+        MathRectMatrix us = QRFactorization(ru).economy_q();
+        MathRectMatrix v = QRFactorization(rv).economy_q();
+        for (j = 0; j < n; ++j)
+            scal(pow(10.0, -k * j / (n > 1 ? n - 1.0 : 1.0)), column(us, j));
+        gemm(NO_TRANS, TRANS, 1.0, us, v, 0.0, a);
+
+        MathVector x_true(n), b(m), xq, xn(n);
+        for (j = 0; j < n; ++j)
+            x_true[j] = 1;
+        gemv(NO_TRANS, 1.0, a, x_true, 0.0, b);
+
+        QRFactorization qr;
+        double tq = time_it([&] {
+            qr.factor(a);
+            xq = qr.solve(b);
+        });
+
+        MathMatrix ata(n), l, u;
+        MathVector atb(n);
+        double tn = time_it([&] {
+            gemm(TRANS, NO_TRANS, 1.0, a, a, 0.0, ata);
+            gemv(TRANS, 1.0, a, b, 0.0, atb);
+            lu_fact(ata, l, u, n);
+            lu_solve(l, u, atb, n, xn);
+        });
+
+        double eq = 0, en = 0;
+        for (j = 0; j < n; ++j)
+        {
+            eq = fmax(eq, fabs(xq[j] - x_true[j]));
+            en = fmax(en, fabs(xn[j] - x_true[j]));
+        }
+
+        std::cout << "1e" << k << "	" << tq << "	" << tn << "	" << eq
+                  << "	" << en << std::endl;
+    }
+}
+
+// STREAM
+// placement of the storage of the vectors
+enum Placement { SERIAL_ZERO, PARALLEL_FIRST_TOUCH, INTERLEAVE, BIND };
+
+// a vector of length n placed by policy p (node for BIND); applied tells
+// whether the NUMA placement could be set
+static MathVector placed_vector(Index n, Placement p, int node, bool& applied)
+{
+    applied = true;
+    if (p == SERIAL_ZERO)
+        return MathVector(n);
+    if (p == PARALLEL_FIRST_TOUCH)
+        return MathVector(n, FIRST_TOUCH);
+
+    MathVector v(n, UNINITIALIZED);
+    applied = p == INTERLEAVE ? numa_interleave(v) : numa_bind(v, node);
+    first_touch(v.data(), n, (Index)1);  // the pages are placed here
+    return v;
+}
+
+// best time of reps runs of a kernel split as the library's loops
+template <typename F>
+static double stream_best(Index n, int reps, F kernel)
+{
+    double best = 0;
+
+    for (int r = 0; r < reps; ++r)
+    {
+        double t = time_it([&] {
+            parallel_for(n, num_chunks(n, 4096), kernel);
+        });
+        if (r == 0 || t < best)
+            best = t;
+    }
+    return best;
+}
+
+static void stream_report(Index n, int reps)
+{
+    int nodes = numa_num_nodes();
+    const double s = 3.0;
+    const char* names[] = { "serial zero", "first touch", "interleave",
+                            "bind" };
+
+    std::cout << "STREAM, length " << n << ", " << get_num_threads()
+              << " threads, " << nodes << " NUMA nodes" << std::endl;
+    std::cout << "placement	copy	scale	add	triad [GB/s]" << std::endl;
+
+    for (int p = SERIAL_ZERO; p <= BIND; ++p)
+    {
+        for (int node = 0; node < (p == BIND ? nodes : 1); ++node)
+        {
+            bool applied_a, applied_b, applied_c;
+            MathVector a = placed_vector(n, (Placement)p, node, applied_a);
+            MathVector b = placed_vector(n, (Placement)p, node, applied_b);
+            MathVector c = placed_vector(n, (Placement)p, node, applied_c);
+            double* pa = a.data();
+            double* pb = b.data();
+            double* pc = c.data();
+
+            double t[4];
+
+            parallel_for(n, num_chunks(n, 4096), [=](Index lo, Index hi, int) {
+                for (Index i = lo; i < hi; ++i)
+                {
+                    pa[i] = 1.0;
+                    pb[i] = 2.0;
+                }
+            });
+
+            t[0] = stream_best(n, reps, [=](Index lo, Index hi, int) {
+                for (Index i = lo; i < hi; ++i)
+                    pc[i] = pa[i];  // copy
+            });
+            t[1] = stream_best(n, reps, [=](Index lo, Index hi, int) {
+                for (Index i = lo; i < hi; ++i)
+                    pb[i] = s * pc[i];  // scale
+            });
+            t[2] = stream_best(n, reps, [=](Index lo, Index hi, int) {
+                for (Index i = lo; i < hi; ++i)
+                    pc[i] = pa[i] + pb[i];  // add
+            });
+            t[3] = stream_best(n, reps, [=](Index lo, Index hi, int) {
+                for (Index i = lo; i < hi; ++i)
+                    pa[i] = pb[i] + s * pc[i];  // triad
+            });
+
+            // bytes moved: two vectors for copy and scale, three for the
+            // others
+            double gb = n * sizeof(double) * 1e-9;
+            std::cout << names[p];
+            if (p == BIND)
+                std::cout << " " << node;
+            if (!(applied_a && applied_b && applied_c))
+                std::cout << " (not applied)";
+            std::cout << "\t" << 2 * gb / t[0] << "\t" << 2 * gb / t[1]
+                      << "\t" << 3 * gb / t[2] << "\t" << 3 * gb / t[3]
+                      << std::endl;
+        }
+    }
+}
+
+// BACKENDS
+static void backend_report(int n)
+{
+    Backend saved = get_backend();
+    MathMatrix a = random_matrix(n), b = random_matrix(n), c(n), lu;
+    Vector<int> ipiv;
+
+    std::cout << "backend\tconformance\tgemm [GFLOP/s]\tlu [GFLOP/s]"
+              << std::endl;
+
+    for (int k = REFERENCE_BACKEND; k <= CBLAS_BACKEND; ++k)
+    {
+        Backend be = (Backend)k;
+        if (!backend_available(be))
+        {
+            std::cout << backend_name(be) << "\tnot available" << std::endl;
+            continue;
+        }
+
+        double conf = backend_conformance(be);
+        set_backend(be);
+        double tg = time_it([&] {
+            gemm(NO_TRANS, NO_TRANS, 1.0, a, b, 0.0, c);
+        });
+        lu = a;
+        double tl = time_it([&] { lu_fact_pivoted(view(lu), ipiv); });
+
+        std::cout << backend_name(be) << "\t" << conf << "\t"
+                  << 2.0 * n * (double)n * n / tg * 1e-9 << "\t"
+                  << lu_gflops(n, tl) << std::endl;
+    }
+
+    set_backend(saved);
+}
+
+// conformance of every available backend to the reference; false when one
+// exceeds the bound of backend_conforms()
+static bool conformance_report(int n)
+{
+    bool ok = true;
+
+    std::cout << "backend\tconformance\tbound\tresult" << std::endl;
+
+    for (int k = REFERENCE_BACKEND; k <= CBLAS_BACKEND; ++k)
+    {
+        Backend be = (Backend)k;
+        if (!backend_available(be))
+        {
+            std::cout << backend_name(be) << "\tnot available" << std::endl;
+            continue;
+        }
+
+        double conf = backend_conformance(be, n);
+        bool pass = backend_conforms(be, n);
+        ok = ok && pass;
+        std::cout << backend_name(be) << "\t" << conf << "\t"
+                  << CONFORMANCE_TOLERANCE * n * DBL_EPSILON << "\t"
+                  << (pass ? "ok" : "FAILED") << std::endl;
+    }
+
+    return ok;
+}
+
+// ASYNCHRONOUS JOBS
+// time of a small solve while every worker runs a product of big, in seconds
+static double small_job_latency(const MathMatrix& big, const MathMatrix& a,
+                                const MathVector& b, Priority priority)
+{
+    std::vector<Job<MathMatrix> > jobs;
+    int i;
+
+    for (i = 0; i < default_scheduler().num_threads(); ++i)
+        jobs.push_back(async_multiply(big, big));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    double t = time_it([&] { async_solve(a, b, priority).get(); });
+
+    for (i = 0; i < (int)jobs.size(); ++i)
+    {
+        jobs[i].cancel();
+        try {
+            jobs[i].get();
+        }
+        catch (JobCancelled&) {}
+    }
+    return t;
+}
+
+static void async_report(int n, int small)
+{
+    MathMatrix big = random_matrix(n), a = random_matrix(small);
+    MathVector b(small);
+
+    double alone = time_it([&] { async_solve(a, b).get(); });
+    double normal = small_job_latency(big, a, b, NORMAL_PRIORITY);
+    double urgent = small_job_latency(big, a, b, URGENT_PRIORITY);
+
+    Job<MathMatrix> job = async_inverse(big);
+    while (job.progress() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double stop = time_it([&] {
+        job.cancel();
+        try {
+            job.get();
+        }
+        catch (JobCancelled&) {}
+    });
+
+    std::cout << "small solve, n = " << small << ", behind products, n = "
+              << n << " [ms]" << std::endl
+              << "idle pool\t" << alone * 1e3 << std::endl
+              << "normal priority\t" << normal * 1e3 << std::endl
+              << "urgent priority\t" << urgent * 1e3 << std::endl
+              << "inversion cancelled in [ms]\t" << stop * 1e3 << std::endl;
+}
+
+// PERSISTED FACTORISATIONS
+static void lufile_report(int n, const std::string& name)
+{
+    MathMatrix a = random_matrix(n);
+    MathVector b(n), x;
+    LUFactorization f, g;
+    uint64_t sum = 0;
+
+    double tf = time_it([&] { f.factor(a); });
+    double ts = time_it([&] { f.save(name); });
+    double tc = time_it([&] { sum = matrix_checksum(a); });
+    double tl = time_it([&] { g.load(name, a); });
+    double tx = time_it([&] { x = g.solve(b); });
+
+    std::cout << "n = " << n << ", checksum " << std::hex << sum << std::dec
+              << " [ms]" << std::endl
+              << "factor\t" << tf * 1e3 << std::endl
+              << "save\t" << ts * 1e3 << std::endl
+              << "checksum\t" << tc * 1e3 << std::endl
+              << "load\t" << tl * 1e3 << (g.is_mapped() ? " (mapped)" : "")
+              << std::endl
+              << "first solve\t" << tx * 1e3 << std::endl;
+}
+
+// SUITE
+// timing statistics of one benchmark, in seconds per call
+struct Stats {
+    double median, p10, p90, min, max;
+    int inner;  // calls per timed sample
+};
+
+// a timed sample lasts at least that long, in seconds
+static const double MIN_SAMPLE = 1e-3;
+
+// results of the benchmarked calls are added here, so they are not optimised
+// away
+static volatile double sink;
+
+// q-th quantile of sorted values, interpolating between the closest ranks
+static double percentile(const std::vector<double>& sorted, double q)
+{
+    double pos = q * (sorted.size() - 1);
+    size_t lo = (size_t)pos;
+    size_t hi = lo + 1 < sorted.size() ? lo + 1 : lo;
+
+    return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+template <typename F>
+static Stats measure(F f, int warmup, int reps)
+{
+    Stats s;
+    std::vector<double> t(reps);
+    int i, k, inner = 1;
+
+    for (i = 0; i < warmup; ++i)
+        f();
+
+    // calls per sample, doubled until a sample is long enough
+    while (inner < (1 << 20) &&
+           time_it([&] { for (k = 0; k < inner; ++k) f(); }) < MIN_SAMPLE)
+        inner *= 2;
+
+    for (i = 0; i < reps; ++i)
+        t[i] = time_it([&] { for (k = 0; k < inner; ++k) f(); }) / inner;
+    std::sort(t.begin(), t.end());
+
+    s.median = percentile(t, 0.5);
+    s.p10 = percentile(t, 0.1);
+    s.p90 = percentile(t, 0.9);
+    s.min = t.front();
+    s.max = t.back();
+    s.inner = inner;
+    return s;
+}
+
+// JSON report, one object per benchmark in the "results" array
+class Report {
+private:
+    std::ostream& os;
+    int warmup, reps;
+    bool first;
+
+    // rate in units of 1e9 per second, null when nothing is counted
+    void rate(const char* key, double count, double seconds)
+    {
+        os << ", \"" << key << "\": ";
+        if (count > 0)
+            os << count / seconds * 1e-9;
+        else
+            os << "null";
+    }
+
+public:
+    Report(std::ostream& os, int warmup, int reps)
+        : os(os), warmup(warmup), reps(reps), first(true)
+    {
+        os << std::setprecision(6);
+        os << "{\n  \"threads\": " << default_scheduler().num_threads()
+           << ",\n  \"warmup\": " << warmup
+           << ",\n  \"repetitions\": " << reps
+           << ",\n  \"min_sample_s\": " << MIN_SAMPLE
+           << ",\n  \"results\": [";
+    }
+
+    ~Report()
+    {
+        os << "\n  ]\n}" << std::endl;
+    }
+
+    // time f on an operation of size n with given flop and byte counts
+    template <typename F>
+    void run(const char* name, int n, double flops, double bytes, F f)
+    {
+        Stats s = measure(f, warmup, reps);
+
+        os << (first ? "\n" : ",\n") << "    {\"name\": \"" << name
+           << "\", \"n\": " << n << ", \"inner\": " << s.inner
+           << ", \"median_s\": " << s.median << ", \"p10_s\": " << s.p10
+           << ", \"p90_s\": " << s.p90 << ", \"min_s\": " << s.min
+           << ", \"max_s\": " << s.max;
+        rate("gflops", flops, s.median);
+        rate("gbs", bytes, s.median);
+
+        if (instrument_enabled())
+        {
+            // counters of one more call
+            counter_reset();
+            f();
+            CounterSnapshot cs = counter_snapshot();
+            bool none = true;
+
+            os << ", \"counters\": {";
+            for (int c = 0; c < NUM_COUNTERS; ++c)
+                if (cs.value[c])
+                {
+                    os << (none ? "" : ", ") << "\"" << counter_name((Counter)c)
+                       << "\": " << cs.value[c];
+                    none = false;
+                }
+            os << "}";
+        }
+        os << "}" << std::flush;
+        first = false;
+    }
+};
+
+static MathVector random_vector(int n)
+{
+    MathVector v(n);
+
+    for (int i = 0; i < n; ++i)
+        v[i] = rand() / (double)RAND_MAX - 0.5;
+    return v;
+}
+
+static Vector<Complex> random_complex_vector(int n)
+{
+    Vector<Complex> v(n);
+
+    for (int i = 0; i < n; ++i)
+        v[i] = Complex(rand() / (double)RAND_MAX - 0.5,
+                       rand() / (double)RAND_MAX - 0.5);
+    return v;
+}
+
+// size of a file in bytes
+static double file_size(const char* name)
+{
+    std::ifstream ifs(name, std::ios::binary | std::ios::ate);
+
+    return (double)ifs.tellg();
+}
+
+static void suite(int maxn, int reps, int warmup)
+{
+    const char* tmp = "benchmark.tmp";  // scratch file of the I/O benchmarks
+    const double d = sizeof(double), z = sizeof(Complex);
+    int n;
+
+    if (maxn < 1 || reps < 1 || warmup < 0)
+        throw std::invalid_argument("benchmark parameters out of range");
+
+    Report report(std::cout, warmup, reps);
+
+    for (n = 32; n <= maxn; n *= 2)
+    {
+        double n2 = (double)n * n, n3 = n2 * n;
+        MathMatrix a = random_matrix(n), b = random_matrix(n), c, l, u, p;
+        MathVector v = random_vector(n), x;
+
+        report.run("matrix_multiply", n, 2 * n3, 3 * n2 * d,
+                   [&] { c = a * b; });
+        report.run("matrix_vector_multiply", n, 2 * n2, (n2 + 2 * n) * d,
+                   [&] { x = a * v; });
+        report.run("lu_fact", n, 2 * n3 / 3, 3 * n2 * d,
+                   [&] { lu_fact(a, l, u, n); });
+        report.run("lu_solve", n, 2 * n2, (2 * n2 + 2 * n) * d,
+                   [&] { lu_solve(l, u, v, n, x); });
+        report.run("reorder", n, 2 * n3 / 3, 2 * n2 * d,
+                   [&] { reorder(a, n, p); });
+        report.run("inverse", n, 2 * n3, 2 * n2 * d,
+                   [&] { c = a.inverse(); });
+        report.run("condition_num", n, 2 * n3 + 2 * n2, 2 * n2 * d,
+                   [&] { sink = sink + a.condition_num(); });
+        report.run("matrix_one_norm", n, n2, n2 * d,
+                   [&] { sink = sink + a.one_norm(); });
+        report.run("matrix_two_norm", n, 2 * n2, n2 * d,
+                   [&] { sink = sink + a.two_norm(); });
+        report.run("matrix_uniform_norm", n, n2, n2 * d,
+                   [&] { sink = sink + a.uniform_norm(); });
+
+        // vectors of the same number of elements as the matrices
+        int m = n * n;
+        MathVector w = random_vector(m);
+        Vector<Complex> cx = random_complex_vector(m),
+                        cy = random_complex_vector(m), cz(m);
+
+        report.run("vector_one_norm", m, m, m * d,
+                   [&] { sink = sink + w.one_norm(); });
+        report.run("vector_two_norm", m, 2.0 * m, m * d,
+                   [&] { sink = sink + w.two_norm(); });
+        report.run("vector_uniform_norm", m, m, m * d,
+                   [&] { sink = sink + w.uniform_norm(); });
+        report.run("complex_vector_copy", m, 0, 2 * m * z,
+                   [&] { cz = cx; });
+        report.run("complex_vector_equal", m, 0, 2 * m * z,
+                   [&] { sink = sink + (cz == cx); });
+        report.run("complex_vector_multiply_add", m, 8.0 * m, 3 * m * z,
+                   [&] {
+                       for (int i = 0; i < m; ++i)
+                           cz[i] += cx[i] * cy[i];
+                   });
+
+        // elementwise throughput, the loops written over the storage as a
+        // vectorised kernel would be (no range check, no copy on write)
+        const Complex* px = cx.data();
+        const Complex* py = cy.data();
+        Complex* pz = cz.data();
+        report.run("complex_elementwise_add", m, 2.0 * m, 3 * m * z, [&] {
+            for (int i = 0; i < m; ++i)
+                pz[i] = px[i] + py[i];
+        });
+        report.run("complex_elementwise_multiply", m, 6.0 * m, 3 * m * z,
+                   [&] {
+                       for (int i = 0; i < m; ++i)
+                           pz[i] = px[i] * py[i];
+                   });
+        report.run("complex_elementwise_multiply_sub", m, 8.0 * m, 3 * m * z,
+                   [&] {
+                       for (int i = 0; i < m; ++i)
+                           pz[i] -= px[i] * py[i];
+                   });
+        report.run("complex_elementwise_divide", m, 11.0 * m, 3 * m * z,
+                   [&] {
+                       for (int i = 0; i < m; ++i)
+                           pz[i] = px[i] / py[i];
+                   });
+
+        // text files, the byte counts are the sizes of the files
+        {
+            std::ofstream ofs(tmp);
+            ofs << a;
+        }
+        double matrix_bytes = file_size(tmp);
+        report.run("matrix_file_write", n, 0, matrix_bytes, [&] {
+            std::ofstream ofs(tmp);
+            ofs << a;
+        });
+        report.run("matrix_file_read", n, 0, matrix_bytes, [&] {
+            std::ifstream ifs(tmp);
+            ifs >> c;
+        });
+
+        {
+            std::ofstream ofs(tmp);
+            ofs << cx;
+        }
+        double vector_bytes = file_size(tmp);
+        report.run("complex_vector_file_write", m, 0, vector_bytes, [&] {
+            std::ofstream ofs(tmp);
+            ofs << cx;
+        });
+        report.run("complex_vector_file_read", m, 0, vector_bytes, [&] {
+            std::ifstream ifs(tmp);
+            ifs >> cz;
+        });
+        std::remove(tmp);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "suite";
+
+    try {
+        if (mode == "suite")
+            suite(argc > 2 ? atoi(argv[2]) : 512, argc > 3 ? atoi(argv[3]) : 11,
+                  argc > 4 ? atoi(argv[4]) : 1);
+        else if (mode == "lu")
+            lu_scaling(argc > 2 ? atoi(argv[2]) : 1024);
+        else if (mode == "strassen")
+            strassen_report(argc > 2 ? atoi(argv[2]) : 2048,
+                            argc > 3 ? atoi(argv[3]) : 256);
+        else if (mode == "lstsq")
+            lstsq_report(argc > 2 ? atoi(argv[2]) : 2000,
+                         argc > 3 ? atoi(argv[3]) : 500);
+        else if (mode == "stream")
+            stream_report(argc > 2 ? atol(argv[2]) : 1L << 24,
+                          argc > 3 ? atoi(argv[3]) : 10);
+        else if (mode == "backend")
+            backend_report(argc > 2 ? atoi(argv[2]) : 1024);
+        else if (mode == "async")
+            async_report(argc > 2 ? atoi(argv[2]) : 2048,
+                         argc > 3 ? atoi(argv[3]) : 64);
+        else if (mode == "conformance") {
+            if (!conformance_report(argc > 2 ? atoi(argv[2]) : 64))
+                return 1;
+        }
+        else if (mode == "lufile")
+            lufile_report(argc > 2 ? atoi(argv[2]) : 2048,
+                          argc > 3 ? argv[3] : "lu.bin");
+        else {
+            std::cerr << "unknown benchmark " << mode << std::endl;
+            return 1;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "What: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -9,47 +9,70 @@
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 #include "vector.h"  //we use Vector in Matrix implementation
+#include "Layout.h"
 
 // g++ compiler requires this approach
 // (http://en.wikibooks.org/wiki/More_C%2B%2B_Idioms/Making_New_Friends)
 
-template <typename T>
+template <typename T, typename L = RowMajor>
 class Matrix;
 
-template <typename T>
-std::istream& operator>>(std::istream& is, Matrix<T>& m);
+template <typename T, typename L>
+std::istream& operator>>(std::istream& is, Matrix<T, L>& m);
 
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const Matrix<T>& m);
+template <typename T, typename L>
+std::ostream& operator<<(std::ostream& os, const Matrix<T, L>& m);
 
-template <typename T>
-std::ifstream& operator>>(std::ifstream& ifs, Matrix<T>& m);
+template <typename T, typename L>
+std::ifstream& operator>>(std::ifstream& ifs, Matrix<T, L>& m);
 
-template <typename T>
-std::ofstream& operator<<(std::ofstream& ofs, const Matrix<T>& m);
+template <typename T, typename L>
+std::ofstream& operator<<(std::ofstream& ofs, const Matrix<T, L>& m);
 
 /**
  * @brief Template class meant to represent a 2-dimensional matrix of objects of
  * user specified type.
+ *
+ * The layout L (see Layout.h) tells where element (i, j) is stored: RowMajor
+ * by default, ColMajor or Tiled. Matrices of different layouts are distinct
+ * types; convert() moves the elements from one layout to another.
  */
-template <typename T>
+template <typename T, typename L>
 class Matrix {
+    // matrices of other layouts, for convert()
+    template <typename U, typename M>
+    friend class Matrix;
+
 protected:
     /**
-     * @brief Vector used to store the matrix elements.
+     * @brief Vector used to store the matrix elements, in layout L.
      */
     Vector<T> v;
 
     /**
      * @brief Number of rows of the matrix.
      */
-    int nrows;
+    Index nrows;
 
     /**
      * @brief Number of columns of the matrix.
      */
-    int ncols;
+    Index ncols;
+
+    /**
+     * @brief Private function since user should not call it.
+     * @param Nrows Number of rows.
+     * @param Ncols Number of columns.
+     * @return Number of elements stored, Nrows * Ncols plus the padding of
+     * the layout.
+     *
+     * It throws an exception when given negative index, and
+     * std::length_error when the number of elements would overflow.
+     */
+    static Index checked_size(Index Nrows, Index Ncols);
 
 public:
     // CONSTRUCTORS
@@ -63,10 +86,16 @@ public:
      * @param Nrows Number of rows.
      * @param Ncols Number of columns.
      *
+     * @param init Initialisation of the elements, zero-filled by default.
+     *
      * Constructs a Matrix of given size.
-     * It throws an exception when given negative index.
+     * It throws an exception when given negative index, and
+     * std::length_error when the number of elements would overflow.
+     *
+     * With FIRST_TOUCH the rows are zero-filled in parallel, by the same
+     * blocks of rows as the threaded routines work on (see first_touch()).
      */
-    Matrix(int Nrows, int Ncols);
+    Matrix(Index Nrows, Index Ncols, Initialization init = ZERO_INIT);
 
     /**
      * @brief Build a matrix from a vector.
@@ -81,22 +110,53 @@ public:
      * @brief Copy constructor.
      * @param m Matrix.
      *
-     * This constructor copies data from Matrix m to newly allocated memory.
+     * This constructor shares the elements of Matrix m, which are copied
+     * when either matrix is first written (see Vector).
      */
-    Matrix(const Matrix<T>& m);
+    Matrix(const Matrix<T, L>& m);
+
+    /**
+     * @brief Move constructor.
+     * @param m Matrix, left empty.
+     *
+     * Takes the elements of m, nothing is copied.
+     */
+    Matrix(Matrix<T, L>&& m);
 
     // ACCESSOR METHODS
     /**
      * @brief Get the number of rows.
      * @return Number of rows.
      */
-    int getNrows() const;
+    Index getNrows() const;
 
     /**
      * @brief Get the number of columns.
      * @return Number of columns.
      */
-    int getNcols() const;
+    Index getNcols() const;
+
+    /**
+     * @brief Get pointer to the matrix elements.
+     * @return Pointer to the element in row 0 and column 0.
+     *
+     * Element (i, j) is at offset L::offset(i, j, getNrows(), getNcols()),
+     * i * getNcols() + j for the default row-major layout. The elements are
+     * copied first when they are shared.
+     */
+    T* data();
+
+    /**
+     * @brief Get pointer to the matrix elements for reading.
+     * @return Pointer to the element in row 0 and column 0.
+     */
+    const T* data() const;
+
+    /**
+     * @brief Deep copy.
+     * @return Copy of the matrix which shares no elements with it.
+     */
+    Matrix<T, L> clone() const;
 
     // OVERLOADED FUNCTION CALL OPERATORS
     /**
@@ -105,9 +165,11 @@ public:
      * @param j Row.
      * @return Value stored in row i and column j.
      *
-     * It throws an exception when given out of range index.
+     * It throws an exception when given out of range index. Like
+     * Vector::operator[] it checks whether the elements are shared on every
+     * call; loops writing many elements use data() instead.
      */
-    T& operator()(int i, int j);
+    T& operator()(Index i, Index j);
 
     /**
      * @brief Function call overload (-,-) for read.
@@ -117,21 +179,43 @@ public:
      *
      * It throws an exception when given out of range index.
      */
-    T operator()(int i, int j) const;
+    T operator()(Index i, Index j) const;
 
     /**
      * @brief Overloaded assignment operator.
      * @param m Right-side operand matrix.
      * @return Left-side operand.
      */
-    Matrix<T>& operator=(const Matrix<T>& m);
+    Matrix<T, L>& operator=(const Matrix<T, L>& m);
+
+    /**
+     * @brief Move assignment operator.
+     * @param m Right-side operand matrix, left empty.
+     * @return Left-side operand.
+     */
+    Matrix<T, L>& operator=(Matrix<T, L>&& m);
 
     /**
      * @brief Overloaded comparison operator.
      * @param m Right-side operand matrix.
      * @return True only if two matrices are the same.
      */
-    bool operator==(const Matrix<T>& m) const;
+    bool operator==(const Matrix<T, L>& m) const;
+
+    // LAYOUT CONVERSION
+    /**
+     * @brief Moves the elements into a matrix of another layout.
+     * @param m Matrix receiving the elements, in layout L2.
+     *
+     * m takes the size and the elements of this matrix, which is left empty.
+     * When neither layout pads (always the case for RowMajor and ColMajor,
+     * and for Tiled when the sizes are multiples of the tile), the elements
+     * are permuted in place, in the same storage, with one bit of extra
+     * memory per element. Otherwise they are copied into new storage, with
+     * the padding zero-filled.
+     */
+    template <typename L2>
+    void convert(Matrix<T, L2>& m);
 
     // KEYBOARD/SCREEN INPUT AND OUTPUT
     /**
@@ -143,7 +227,7 @@ public:
      * Since this operator returns reference to its left-side operand, it can be
      * used multiple times in one statement (e.g. std::cin >> m1 >> m2 >> m3;).
      */
-    friend std::istream& operator>><>(std::istream& is, Matrix<T>& m);
+    friend std::istream& operator>><>(std::istream& is, Matrix<T, L>& m);
 
     /**
      * @brief Overloaded stream output operator for screen output.
@@ -154,7 +238,8 @@ public:
      * Since this operator returns reference to its left-side operand, it can be
      * used multiple times in one statement (e.g. std::cout << m1 << m2 << m3;).
      */
-    friend std::ostream& operator<<<>(std::ostream& os, const Matrix<T>& m);
+    friend std::ostream& operator<<<>(std::ostream& os,
+                                      const Matrix<T, L>& m);
 
     // FILE INPUT AND OUTPUT
     /**
@@ -169,7 +254,7 @@ public:
      * The file input operator is compatible with file output operator,
      * ie. everything written can be read later.
      */
-    friend std::ifstream& operator>><>(std::ifstream& ifs, Matrix<T>& m);
+    friend std::ifstream& operator>><>(std::ifstream& ifs, Matrix<T, L>& m);
 
     /**
      * @brief Overloaded file output operator.
@@ -183,7 +268,8 @@ public:
      * The file output operator is compatible with file input operator,
      * ie. everything written can be read later.
      */
-    friend std::ofstream& operator<<<>(std::ofstream& ofs, const Matrix<T>& m);
+    friend std::ofstream& operator<<<>(std::ofstream& ofs,
+                                       const Matrix<T, L>& m);
 };
 
 // Note: There is no strict need for a copy constructor or
@@ -196,81 +282,130 @@ public:
 
 // CONSTRUCTORS
 // Default constructor (empty matrix)
-template <typename T>
-Matrix<T>::Matrix()
+template <typename T, typename L>
+Matrix<T, L>::Matrix()
     : v(0), nrows(0), ncols(0)
 {
 }
 
-// Alternate constructor - creates a matrix with the given values
-template <typename T>
-Matrix<T>::Matrix(int Nrows, int Ncols)
+// number of elements of a matrix, checked
+template <typename T, typename L>
+Index Matrix<T, L>::checked_size(Index Nrows, Index Ncols)
 {
     // check input
     if (Nrows < 0 || Ncols < 0)
         throw std::invalid_argument("matrix size negative");
-    nrows = Nrows;
-    ncols = Ncols;
-    // if rownumber <= 0 or colnumber <= 0 then the program creates a 0-sized
-    // vector
-    if (nrows <= 0 || ncols <= 0)
-        v = Vector<T>(0);  // empty matrix, nothing to allocate
-    else
-        v = Vector<T>(nrows * ncols);
+    // nrows * ncols has to be representable
+    if (Nrows > 0 && Ncols > PTRDIFF_MAX / Nrows)
+        throw std::length_error("matrix size overflow");
+    return L::size(Nrows, Ncols);
+}
+
+// Alternate constructor - creates a matrix with the given values
+template <typename T, typename L>
+Matrix<T, L>::Matrix(Index Nrows, Index Ncols, Initialization init)
+    : v(checked_size(Nrows, Ncols), init == FIRST_TOUCH ? UNINITIALIZED : init),
+      nrows(Nrows), ncols(Ncols)
+{
+    // the elements are allocated in place, a temporary vector assigned to v
+    // would be copied by one thread; storage with padding is split evenly
+    if (init == FIRST_TOUCH && v.size() == nrows * ncols)
+        first_touch(v.data(), nrows, ncols);
+    else if (init == FIRST_TOUCH)
+        first_touch(v.data(), v.size(), (Index)1);
 }
 
 // Alternate constructor - creates a matrix from a vector
-template <typename T>
-Matrix<T>::Matrix(const Vector<T>& x)
+template <typename T, typename L>
+Matrix<T, L>::Matrix(const Vector<T>& x)
     : v(x), nrows(x.size()), ncols(1)
 {
+    // a column is stored in order by the strided layouts, not by tiles
+    if (v.size() != L::size(nrows, ncols))
+    {
+        v = Vector<T>(L::size(nrows, ncols));
+        for (Index i = 0; i < nrows; i++)
+            v[L::offset(i, 0, nrows, ncols)] = x[i];
+    }
 }
 
 // Copy constructor
-template <typename T>
-Matrix<T>::Matrix(const Matrix<T>& m)
+template <typename T, typename L>
+Matrix<T, L>::Matrix(const Matrix<T, L>& m)
     : v(m.v), nrows(m.getNrows()), ncols(m.getNcols())
 {
 }
 
+// Move constructor
+template <typename T, typename L>
+Matrix<T, L>::Matrix(Matrix<T, L>&& m)
+    : v(std::move(m.v)), nrows(m.nrows), ncols(m.ncols)
+{
+    m.nrows = 0;
+    m.ncols = 0;
+}
+
 // ACCESSOR METHODS
 // Get back matrix rows
-template <typename T>
-int Matrix<T>::getNrows() const
+template <typename T, typename L>
+Index Matrix<T, L>::getNrows() const
 {
     return nrows;
 }
 
 // Get back matrix cols
-template <typename T>
-int Matrix<T>::getNcols() const
+template <typename T, typename L>
+Index Matrix<T, L>::getNcols() const
 {
     return ncols;
 }
 
+// Get back pointer to the elements for writing
+template <typename T, typename L>
+T* Matrix<T, L>::data()
+{
+    return v.data();
+}
+
+// Get back pointer to the elements for reading
+template <typename T, typename L>
+const T* Matrix<T, L>::data() const
+{
+    return v.data();
+}
+
+// Deep copy
+template <typename T, typename L>
+Matrix<T, L> Matrix<T, L>::clone() const
+{
+    Matrix<T, L> m(*this);
+    m.v = v.clone();
+    return m;
+}
+
 // OVERLOADED FUNCTION CALL OPERATORS
 // Operator() - returns with a specified value of matrix for write
-template <typename T>
-T& Matrix<T>::operator()(int i, int j)
+template <typename T, typename L>
+T& Matrix<T, L>::operator()(Index i, Index j)
 {
     if (i > nrows - 1 || j > ncols - 1 || i < 0 || j < 0)
         throw std::out_of_range("matrix access error");
-    return v[i * ncols + j];
+    return v[L::offset(i, j, nrows, ncols)];
 }
 
 // Operator() - returns with a specified value of matrix for read
-template <typename T>
-T Matrix<T>::operator()(int i, int j) const
+template <typename T, typename L>
+T Matrix<T, L>::operator()(Index i, Index j) const
 {
     // if the given parameters (coordinates) are out of range
     if (i > nrows - 1 || j > ncols - 1 || i < 0 || j < 0)
         throw std::out_of_range("matrix access error");
-    return v[i * ncols + j];
+    return v[L::offset(i, j, nrows, ncols)];
 }
 
 // Operator= - assignment
-template <typename T>
-Matrix<T>& Matrix<T>::operator=(const Matrix<T>& m)
+template <typename T, typename L>
+Matrix<T, L>& Matrix<T, L>::operator=(const Matrix<T, L>& m)
 {
     nrows = m.nrows;
     ncols = m.ncols;
@@ -280,17 +415,33 @@ Matrix<T>& Matrix<T>::operator=(const Matrix<T>& m)
     return *this;
 }
 
+// Operator= - move assignment
+template <typename T, typename L>
+Matrix<T, L>& Matrix<T, L>::operator=(Matrix<T, L>&& m)
+{
+    if (this == &m)
+        return *this;
+
+    nrows = m.nrows;
+    ncols = m.ncols;
+    v = std::move(m.v);
+    m.nrows = 0;
+    m.ncols = 0;
+
+    return *this;
+}
+
 // equiv - comparison function, returns true if the given matrices are the same
-template <typename T>
-bool Matrix<T>::operator==(const Matrix<T>& a) const
+template <typename T, typename L>
+bool Matrix<T, L>::operator==(const Matrix<T, L>& a) const
 {
     // if the sizes do not match return false
     if ((nrows != a.nrows) || (ncols != a.ncols))
         return false;
 
     // compare all of the elements
-    for (int i = 0; i < nrows; i++) {
-        for (int j = 0; j < ncols; j++) {
+    for (Index i = 0; i < nrows; i++) {
+        for (Index j = 0; j < ncols; j++) {
             if ((*this)(i, j) != a(i, j))
                 return false;
         }
@@ -299,12 +450,71 @@ bool Matrix<T>::operator==(const Matrix<T>& a) const
     return true;
 }
 
+// LAYOUT CONVERSION
+template <typename T, typename L>
+template <typename L2>
+void Matrix<T, L>::convert(Matrix<T, L2>& m)
+{
+    Index r = nrows, c = ncols, size = r * c;
+
+    if ((void*)&m == (void*)this)
+        return;
+
+    if (v.size() == size && L2::size(r, c) == size)
+    {
+        // permutation in place: the element at position k moves to position
+        // L2::offset() of its (i, j), following each cycle of the
+        // permutation once
+        std::vector<bool> done(size);
+        T* p = v.data();
+        Index i, j, k, pos;
+
+        for (Index start = 0; start < size; ++start)
+        {
+            if (done[start])
+                continue;
+            T carry = p[start];
+            pos = start;
+            do {
+                L::position(pos, r, c, i, j);
+                k = L2::offset(i, j, r, c);
+                std::swap(carry, p[k]);
+                done[k] = true;
+                pos = k;
+            } while (pos != start);
+        }
+
+        // hand the storage over to m
+        m.v = Vector<T>();
+        m.v.swap(v);
+    }
+    else
+    {
+        // every element is written below, so the destination is left
+        // uninitialised, unless it has padding, which stays zero; the
+        // elements are read without unsharing them
+        m = Matrix<T, L2>(r, c,
+                          L2::size(r, c) == size ? UNINITIALIZED : ZERO_INIT);
+        const T* src = static_cast<const Vector<T>&>(v).data();
+        T* dst = m.v.data();
+        for (Index i = 0; i < r; ++i)
+            for (Index j = 0; j < c; ++j)
+                dst[L2::offset(i, j, r, c)] = src[L::offset(i, j, r, c)];
+        v = Vector<T>();
+    }
+
+    m.nrows = r;
+    m.ncols = c;
+    nrows = 0;
+    ncols = 0;
+}
+
 // INPUT AND OUTPUT
 // keyboard input , user friendly
-template <typename T>
-std::istream& operator>>(std::istream& is, Matrix<T>& m)
+template <typename T, typename L>
+std::istream& operator>>(std::istream& is, Matrix<T, L>& m)
 {
-    int nrows, ncols;
+    Index nrows, ncols;
     if (!m.nrows) {
         std::cout << "input the number of rows for the matrix" << std::endl;
         is >> nrows;
@@ -315,25 +525,26 @@ std::istream& operator>>(std::istream& is, Matrix<T>& m)
             throw std::invalid_argument("read error - negative matrix size");
 
         // prepare the matrix to hold n elements
-        m = Matrix<T>(nrows, ncols);
+        m = Matrix<T, L>(nrows, ncols);
     }
-    // input the elements
+    // input the elements, row by row whatever the layout
     std::cout << "input " << m.nrows* m.ncols << " matrix elements"
               << std::endl;
-    for (int i = 0; i < m.nrows * m.ncols; i++)
-        is >> m.v[i];
+    for (Index i = 0; i < m.nrows; i++)
+        for (Index j = 0; j < m.ncols; j++)
+            is >> m(i, j);
     // return the stream object
     return is;
 }
 
 // screen output, user friendly
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const Matrix<T>& m)
+template <typename T, typename L>
+std::ostream& operator<<(std::ostream& os, const Matrix<T, L>& m)
 {
     if (&m.v) {
         os << "The matrix elements are" << std::endl;
-        for (int i = 0; i < m.nrows; i++) {
-            for (int j = 0; j < m.ncols; j++) {
+        for (Index i = 0; i < m.nrows; i++) {
+            for (Index j = 0; j < m.ncols; j++) {
                 os << m(i, j) << " ";
             }
             os << "\n";
@@ -347,10 +558,10 @@ std::ostream& operator<<(std::ostream& os, const Matrix<T>& m)
 }
 
 // file input - raw data, compatible with file writing operator
-template <typename T>
-std::ifstream& operator>>(std::ifstream& ifs, Matrix<T>& m)
+template <typename T, typename L>
+std::ifstream& operator>>(std::ifstream& ifs, Matrix<T, L>& m)
 {
-    int nrows, ncols;
+    Index nrows, ncols;
 
     // read size from the file
     ifs >> nrows;
@@ -360,27 +571,28 @@ std::ifstream& operator>>(std::ifstream& ifs, Matrix<T>& m)
         throw std::invalid_argument("file read error - negative matrix size");
 
     // prepare the vector to hold n elements
-    m = Matrix<T>(nrows, ncols);
+    m = Matrix<T, L>(nrows, ncols);
 
-    // input the elements
-    for (int i = 0; i < nrows * ncols; i++)
-        ifs >> m.v[i];
+    // input the elements, written row by row whatever the layout
+    for (Index i = 0; i < nrows; i++)
+        for (Index j = 0; j < ncols; j++)
+            ifs >> m(i, j);
 
     // return the stream object
     return ifs;
 }
 
 // file output - raw data, comaptible with file reading operator
-template <typename T>
-std::ofstream& operator<<(std::ofstream& ofs, const Matrix<T>& m)
+template <typename T, typename L>
+std::ofstream& operator<<(std::ofstream& ofs, const Matrix<T, L>& m)
 {
     // put matrix rownumber in first line (even if it is zero)
     ofs << m.nrows << std::endl;
     // put matrix columnnumber in second line (even if it is zero)
     ofs << m.ncols << std::endl;
     // put data in third line (if size==zero nothing will be put)
-    for (int i = 0; i < m.nrows; i++) {
-        for (int j = 0; j < m.ncols; j++)
+    for (Index i = 0; i < m.nrows; i++) {
+        for (Index j = 0; j < m.ncols; j++)
             ofs << m(i, j) << " ";
         ofs << std::endl;
     }
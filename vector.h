@@ -6,9 +6,13 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
+#include "Index.h"
+#include "Instrument.h"
+#include "Parallel.h"
 
 // g++ compiler requires undermentioned declarations
 // (http://en.wikibooks.org/wiki/More_C%2B%2B_Idioms/Making_New_Friends)
@@ -28,9 +32,32 @@ std::ifstream& operator>>(std::ifstream& ifs, Vector<T>& v);
 template <typename T>
 std::ofstream& operator<<(std::ofstream& ofs, const Vector<T>& v);
 
+/**
+ * @brief How the elements of a newly constructed vector or matrix are
+ * initialised.
+ */
+enum Initialization {
+    ZERO_INIT,      ///< Zero-filled by the constructing thread.
+    UNINITIALIZED,  ///< Left uninitialised, the memory is not touched.
+    FIRST_TOUCH     ///< Zero-filled in parallel (see first_touch()).
+};
+
 /**
  * @brief Template class meant to represent a vector of objects of user
  * specified type.
+ *
+ * Copies share the elements (copy-on-write): copying a vector costs O(1),
+ * and the elements are copied only when a vector sharing them is first
+ * accessed for writing, through the non-const data() or operator[]. The
+ * count of vectors sharing the elements is atomic, so copies can be read
+ * and written by different threads; clone() makes a copy which shares
+ * nothing.
+ *
+ * A pointer or reference to the elements obtained for writing must not be
+ * written through once the vector has been copied, since the copy still
+ * shares the elements: obtain it again. For the same reason one vector
+ * written by several threads, on different elements, has to be unshared
+ * first, e.g. by taking data() before starting the threads.
  */
 template <typename T>
 class Vector {
@@ -38,21 +65,40 @@ protected:
     /**
      * @brief Number of elements.
      */
-    int num;
+    Index num;
 
     /**
      * @brief Pointer to the data.
      */
     T* pdata;
 
+    /**
+     * @brief Number of vectors sharing the data, 0 when the vector is empty.
+     */
+    std::atomic<long>* refs;
+
     /**
      * @brief Private function since user should not call it.
      * @param Num Number of elements in new vector.
+     * @param init Initialisation of the elements.
      *
      * Initialises data, called by the constructors.
-     * It throws an exception when given negative index.
+     * It throws an exception when given negative index, and
+     * std::length_error when the size in bytes would overflow.
+     */
+    void Init(Index Num, Initialization init = ZERO_INIT);
+
+    /**
+     * @brief Gives up the data, freeing them when no other vector shares
+     * them, and leaves the vector empty.
      */
-    void Init(int Num);
+    void release();
+
+    /**
+     * @brief Copies the data when other vectors share them, called before
+     * every access for writing.
+     */
+    void detach();
 
 public:
     // CONSTRUCTORS
@@ -64,23 +110,39 @@ public:
     /**
      * @brief Alternate constructor.
      * @param Num Number of elements in new vector.
+     * @param init Initialisation of the elements, zero-filled by default.
      *
      * Construct Vector of given size. It is explicit since implicit type
      * conversion int to Vector doesn't make sense.
+     *
+     * A large vector filled later by a parallel routine is better constructed
+     * UNINITIALIZED (the filling routine places its pages) or FIRST_TOUCH,
+     * since zero-filling on one thread places all its memory on the NUMA node
+     * of that thread.
      */
-    explicit Vector(int Num);
+    explicit Vector(Index Num, Initialization init = ZERO_INIT);
 
     /**
      * @brief Copy constructor.
      * @param v Vector.
      *
-     * This constructor copies data from Vector v to newly allocated memory.
+     * This constructor shares the data of Vector v, nothing is copied until
+     * either vector is written.
      */
     Vector(const Vector<T>& v);
 
+    /**
+     * @brief Move constructor.
+     * @param v Vector, left empty.
+     *
+     * Takes the elements of v, nothing is copied.
+     */
+    Vector(Vector<T>&& v);
+
     // DESTRUCTOR
     /**
-     * @brief Destructor. Deletes allocated memory.
+     * @brief Destructor. Deletes allocated memory unless other vectors share
+     * it.
      *
      * Destructor is virtual since it is a good thing to have virtual destructor
      * in base class.
@@ -94,7 +156,45 @@ public:
      *
      * It a is const member function since it does not modify object data.
      */
-    int size() const;
+    Index size() const;
+
+    /**
+     * @brief Get pointer to the vector elements.
+     * @return Pointer to the first element (0 when the vector is empty).
+     *
+     * Meant for numeric kernels which walk the elements directly, without the
+     * range checking done by operator[]. The elements are copied first when
+     * they are shared, so this is the unchecked accessor for writing: take
+     * the pointer once, before a loop, rather than writing through
+     * operator[], which checks the range and the share count per element.
+     */
+    T* data();
+
+    /**
+     * @brief Get pointer to the vector elements for reading.
+     * @return Pointer to the first element (0 when the vector is empty).
+     */
+    const T* data() const;
+
+    /**
+     * @brief Deep copy.
+     * @return Copy of the vector which shares no data with it.
+     */
+    Vector<T> clone() const;
+
+    /**
+     * @brief Tells whether other vectors share the elements.
+     * @return True when the next access for writing copies the elements.
+     */
+    bool is_shared() const;
+
+    /**
+     * @brief Exchanges the elements of two vectors.
+     * @param v Vector.
+     *
+     * Only the pointers to the elements are exchanged, nothing is copied.
+     */
+    void swap(Vector<T>& v);
 
     // OVERLOADED OPERATORS
     /**
@@ -102,19 +202,31 @@ public:
      * @param v Right-side operand vector.
      * @return Reference to left-side operand.
      *
-     * It copies data from Vector v to newly allocated memory. Does nothing when
-     * the same object is on its both sides.
+     * It shares the data of Vector v, as the copy constructor. Does nothing
+     * when the same object is on its both sides.
      */
     Vector<T>& operator=(const Vector& v);
 
+    /**
+     * @brief Move assignment operator.
+     * @param v Right-side operand vector, left empty.
+     * @return Reference to left-side operand.
+     *
+     * Frees the elements of the left-side operand and takes those of v,
+     * nothing is copied.
+     */
+    Vector<T>& operator=(Vector&& v);
+
     /**
      * @brief Overloaded array access operator for writing.
      * @param i Vector element index.
      * @return Reference to left-side operand.
      *
-     * It throws an exception when given out of range index.
+     * It throws an exception when given out of range index. The elements are
+     * copied first when they are shared, which is checked on every call;
+     * loops writing many elements use data() instead.
      */
-    T& operator[](int i);
+    T& operator[](Index i);
 
     /**
      * @brief Overloaded array access operator for reading.
@@ -123,7 +235,7 @@ public:
      *
      * It throws an exception when given out of range index.
      */
-    T operator[](int i) const;
+    T operator[](Index i) const;
 
     /**
      * @brief Overloaded comparison operator.
@@ -191,50 +303,119 @@ public:
 // default constructor (empty vector)
 template <typename T>
 Vector<T>::Vector()
-    : num(0), pdata(0)
+    : num(0), pdata(0), refs(0)
 {
 }
 
 // initialise data, called by the constructors
 template <typename T>
-void Vector<T>::Init(int Num)
+void Vector<T>::Init(Index Num, Initialization init)
 {
     // check input sanity
     if (Num < 0)
         throw std::invalid_argument("vector size negative");
+    if ((size_t)Num > PTRDIFF_MAX / sizeof(T))
+        throw std::length_error("vector size overflow");
     num = Num;
+    refs = 0;
     if (num <= 0)
         pdata = 0;  // empty vector, nothing to allocate
     else {
         pdata = new T[num];  // allocate memory for vector
-        for (int i = 0; i < num; i++)
-            pdata[i] = 0.0;
+        try {
+            refs = new std::atomic<long>(1);
+        }
+        catch (...) {
+            delete[] pdata;
+            throw;
+        }
+        MATH_COUNT(ALLOCATIONS, 1);
+        MATH_COUNT(BYTES_ALLOCATED, num * sizeof(T));
+        if (init == ZERO_INIT)
+            for (Index i = 0; i < num; i++)
+                pdata[i] = 0.0;
+        else if (init == FIRST_TOUCH)
+            first_touch(pdata, num, (Index)1);
     }
 }
 
 // alternate constructor
 template <typename T>
-Vector<T>::Vector(int Num)
+Vector<T>::Vector(Index Num, Initialization init)
 {
-    Init(Num);
+    Init(Num, init);
 }
 
-// copy constructor
+// copy constructor, shares the data
 template <typename T>
 Vector<T>::Vector(const Vector<T>& copy)
+    : num(copy.num), pdata(copy.pdata), refs(copy.refs)
 {
-    Init(copy.size());  // allocate the memory
+    if (refs)
+        refs->fetch_add(1, std::memory_order_relaxed);
+}
 
-    // copy the data members (if vector is empty then pdata==0 and num==0)
-    for (int i = 0; i < num; i++)
-        pdata[i] = copy.pdata[i];
+// move constructor
+template <typename T>
+Vector<T>::Vector(Vector<T>&& v)
+    : num(v.num), pdata(v.pdata), refs(v.refs)
+{
+    v.num = 0;
+    v.pdata = 0;
+    v.refs = 0;
 }
 
 // DESTRUCTOR
 template <typename T>
 Vector<T>::~Vector()
 {
-    delete[] pdata;  // free the dynamic memory
+    release();  // free the dynamic memory
+}
+
+// SHARING
+// give up the data, the last vector sharing them frees them
+template <typename T>
+void Vector<T>::release()
+{
+    // the writes of the other vectors to the data happen before the delete
+    if (refs && refs->fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete[] pdata;
+        delete refs;
+    }
+    num = 0;
+    pdata = 0;
+    refs = 0;
+}
+
+// copy the data before writing when they are shared
+template <typename T>
+void Vector<T>::detach()
+{
+    if (refs && refs->load(std::memory_order_acquire) != 1)
+    {
+        Vector<T> copy = clone();
+        swap(copy);  // copy gives up the shared data
+    }
+}
+
+// deep copy
+template <typename T>
+Vector<T> Vector<T>::clone() const
+{
+    Vector<T> copy(num, UNINITIALIZED);
+
+    for (Index i = 0; i < num; i++)
+        copy.pdata[i] = pdata[i];
+    MATH_COUNT(BYTES_COPIED, num * sizeof(T));
+
+    return copy;
+}
+
+template <typename T>
+bool Vector<T>::is_shared() const
+{
+    return refs && refs->load(std::memory_order_acquire) != 1;
 }
 
 // OVERLOADED OPERATORS
@@ -246,28 +427,51 @@ Vector<T>& Vector<T>::operator=(const Vector<T>& copy)
     if (this == &copy)
         return *this;
 
-    delete[] pdata;     // delete existing memory
-    Init(copy.size());  // create new memory then copy data
-    for (int i = 0; i < num; i++)
-        pdata[i] = copy.pdata[i];
+    // share the data of copy, taking the reference before giving up the
+    // existing memory, which copy may share
+    if (copy.refs)
+        copy.refs->fetch_add(1, std::memory_order_relaxed);
+    release();
+    num = copy.num;
+    pdata = copy.pdata;
+    refs = copy.refs;
+
+    return *this;
+}
+
+// move assignment operator
+template <typename T>
+Vector<T>& Vector<T>::operator=(Vector<T>&& v)
+{
+    if (this == &v)
+        return *this;
+
+    release();
+    num = v.num;
+    pdata = v.pdata;
+    refs = v.refs;
+    v.num = 0;
+    v.pdata = 0;
+    v.refs = 0;
 
     return *this;
 }
 
 // array access operator for assigning values
 template <typename T>
-T& Vector<T>::operator[](int i)
+T& Vector<T>::operator[](Index i)
 {
     // check the range, throw appropriate exception
     if (i < 0 || i >= num)
         throw std::out_of_range("vector access error");
 
+    detach();
     return pdata[i];
 }
 
 // array access operator for reading values
 template <typename T>
-T Vector<T>::operator[](int i) const
+T Vector<T>::operator[](Index i) const
 {
     // check the range, throw appropriate exception
     if (i < 0 || i >= num)
@@ -279,11 +483,57 @@ T Vector<T>::operator[](int i) const
 // SIZE
 // return the size of the vector
 template <typename T>
-int Vector<T>::size() const
+Index Vector<T>::size() const
 {
     return num;
 }
 
+// DATA
+// return pointer to the elements for writing
+template <typename T>
+T* Vector<T>::data()
+{
+    detach();
+    return pdata;
+}
+
+// return pointer to the elements for reading
+template <typename T>
+const T* Vector<T>::data() const
+{
+    return pdata;
+}
+
+// exchange the elements with another vector
+template <typename T>
+void Vector<T>::swap(Vector<T>& v)
+{
+    Index n = num;
+    T* p = pdata;
+    std::atomic<long>* r = refs;
+
+    num = v.num;
+    pdata = v.pdata;
+    refs = v.refs;
+    v.num = n;
+    v.pdata = p;
+    v.refs = r;
+}
+
+/**
+ * @brief Exchanges two vectors of any sizes, as Vector::swap().
+ * @param a Vector.
+ * @param b Vector.
+ *
+ * Found by argument-dependent lookup, so "using std::swap; swap(a, b)" and
+ * the standard algorithms exchange the pointers and never throw.
+ */
+template <typename T>
+void swap(Vector<T>& a, Vector<T>& b)
+{
+    a.swap(b);
+}
+
 // COMPARISON
 template <typename T>
 bool Vector<T>::operator==(const Vector& v) const
@@ -291,7 +541,7 @@ bool Vector<T>::operator==(const Vector& v) const
     if (num != v.num)
         return false;
 
-    for (int i = 0; i < num; i++)
+    for (Index i = 0; i < num; i++)
         if ((*this)[i] != v[i])
             return false;
 
@@ -304,7 +554,7 @@ template <typename T>
 std::istream& operator>>(std::istream& is, Vector<T>& v)
 {
     if (!v.num) {
-        int n;
+        Index n;
 
         std::cout << "input the size for the vector" << std::endl;
         is >> n;
@@ -317,7 +567,7 @@ std::istream& operator>>(std::istream& is, Vector<T>& v)
     }
     // input the elements
     std::cout << "input " << v.num << " vector elements" << std::endl;
-    for (int i = 0; i < v.num; i++)
+    for (Index i = 0; i < v.num; i++)
         is >> v[i];
 
     // return the stream object
@@ -328,7 +578,7 @@ std::istream& operator>>(std::istream& is, Vector<T>& v)
 template <typename T>
 std::ifstream& operator>>(std::ifstream& ifs, Vector<T>& v)
 {
-    int n;
+    Index n;
 
     // read size from the file
     ifs >> n;
@@ -340,7 +590,7 @@ std::ifstream& operator>>(std::ifstream& ifs, Vector<T>& v)
     v = Vector<T>(n);
 
     // input the elements
-    for (int i = 0; i < n; i++)
+    for (Index i = 0; i < n; i++)
         ifs >> v[i];
 
     // return the stream object
@@ -352,7 +602,7 @@ template <typename T>
 std::ostream& operator<<(std::ostream& os, const Vector<T>& v)
 {
     if (v.pdata) {
-        for (int i = 0; i < v.size(); i++)
+        for (Index i = 0; i < v.size(); i++)
             os << v[i] << " ";
         os << std::endl;
     }
@@ -370,7 +620,7 @@ std::ofstream& operator<<(std::ofstream& ofs, const Vector<T>& v)
     // put vector size in first line (even if it is zero)
     ofs << v.size() << std::endl;
     // put data in second line (if size==zero nothing will be put)
-    for (int i = 0; i < v.size(); i++)
+    for (Index i = 0; i < v.size(); i++)
         ofs << v[i] << " ";
     ofs << std::endl;
 
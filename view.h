@@ -0,0 +1,476 @@
+/**
+ * @file view.h
+ * @brief Header file containing VectorView and MatrixView template class
+ * definitions and their implementation.
+ */
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <stdexcept>
+#include "vector.h"
+#include "matrix.h"
+
+/**
+ * @brief Template class meant to represent a non-owning, strided view of
+ * vector elements stored elsewhere.
+ *
+ * A view does not allocate memory, it only refers to elements of a Vector or
+ * Matrix (eg. a row, a column or a diagonal). It has to be used only while
+ * the object it refers to exists and is not resized. Use VectorView<const T>
+ * for read-only access.
+ */
+template <typename T>
+class VectorView {
+private:
+    T* p;          // first element
+    Index num;     // number of elements
+    Index stride;  // distance between consecutive elements
+
+public:
+    /**
+     * @brief Default constructor, creates an empty view.
+     */
+    VectorView() : p(0), num(0), stride(1) {}
+
+    /**
+     * @brief Alternate constructor.
+     * @param p Pointer to the first element.
+     * @param num Number of elements.
+     * @param stride Distance between consecutive elements.
+     *
+     * It throws an exception when given negative size.
+     */
+    VectorView(T* p, Index num, Index stride = 1)
+        : p(p), num(num), stride(stride)
+    {
+        if (num < 0)
+            throw std::invalid_argument("view size negative");
+    }
+
+    /**
+     * @brief Conversion of a view for writing into a read-only view.
+     * @param v View of the same elements.
+     */
+    template <typename U>
+    VectorView(const VectorView<U>& v)
+        : p(v.data()), num(v.size()), stride(v.getStride())
+    {
+    }
+
+    /**
+     * @brief Get number of elements in the view.
+     * @return Number of elements.
+     */
+    Index size() const { return num; }
+
+    /**
+     * @brief Get distance between consecutive elements.
+     * @return Stride.
+     */
+    Index getStride() const { return stride; }
+
+    /**
+     * @brief Get pointer to the first element.
+     * @return Pointer to the first element.
+     */
+    T* data() const { return p; }
+
+    /**
+     * @brief Overloaded array access operator.
+     * @param i Element index.
+     * @return Reference to the element.
+     *
+     * It throws an exception when given out of range index.
+     */
+    T& operator[](Index i) const
+    {
+        if (i < 0 || i >= num)
+            throw std::out_of_range("view access error");
+        return p[i * stride];
+    }
+};
+
+/**
+ * @brief Template class meant to represent a non-owning, strided view of a
+ * 2-dimensional block of elements stored elsewhere.
+ *
+ * Element (i, j) of the view is stored at data()[i * getRowStride() + j *
+ * getColStride()], so a block, a transposition or a row or column of a matrix
+ * are all views of the matrix storage and none of them copies it. The same
+ * lifetime rules as for VectorView apply. Use MatrixView<const T> for
+ * read-only access.
+ */
+template <typename T>
+class MatrixView {
+private:
+    T* p;         // element (0, 0)
+    Index nrows;  // number of rows
+    Index ncols;  // number of columns
+    Index rs;     // distance between rows
+    Index cs;     // distance between columns
+
+public:
+    /**
+     * @brief Default constructor, creates an empty view.
+     */
+    MatrixView() : p(0), nrows(0), ncols(0), rs(0), cs(1) {}
+
+    /**
+     * @brief Alternate constructor.
+     * @param p Pointer to element (0, 0).
+     * @param nrows Number of rows.
+     * @param ncols Number of columns.
+     * @param rs Distance between rows.
+     * @param cs Distance between columns.
+     *
+     * It throws an exception when given negative size.
+     */
+    MatrixView(T* p, Index nrows, Index ncols, Index rs, Index cs = 1)
+        : p(p), nrows(nrows), ncols(ncols), rs(rs), cs(cs)
+    {
+        if (nrows < 0 || ncols < 0)
+            throw std::invalid_argument("view size negative");
+    }
+
+    /**
+     * @brief Conversion of a view for writing into a read-only view.
+     * @param m View of the same elements.
+     */
+    template <typename U>
+    MatrixView(const MatrixView<U>& m)
+        : p(m.data()), nrows(m.getNrows()), ncols(m.getNcols()),
+          rs(m.getRowStride()), cs(m.getColStride())
+    {
+    }
+
+    // ACCESSOR METHODS
+    /**
+     * @brief Get the number of rows.
+     * @return Number of rows.
+     */
+    Index getNrows() const { return nrows; }
+
+    /**
+     * @brief Get the number of columns.
+     * @return Number of columns.
+     */
+    Index getNcols() const { return ncols; }
+
+    /**
+     * @brief Get distance between consecutive rows.
+     * @return Row stride.
+     */
+    Index getRowStride() const { return rs; }
+
+    /**
+     * @brief Get distance between consecutive columns.
+     * @return Column stride.
+     */
+    Index getColStride() const { return cs; }
+
+    /**
+     * @brief Get pointer to element (0, 0).
+     * @return Pointer to element (0, 0).
+     */
+    T* data() const { return p; }
+
+    /**
+     * @brief Function call overload (-,-).
+     * @param i Row.
+     * @param j Column.
+     * @return Reference to the element in row i and column j.
+     *
+     * It throws an exception when given out of range index.
+     */
+    T& operator()(Index i, Index j) const
+    {
+        if (i < 0 || j < 0 || i >= nrows || j >= ncols)
+            throw std::out_of_range("view access error");
+        return p[i * rs + j * cs];
+    }
+
+    // SUBVIEWS
+    /**
+     * @brief View of a block.
+     * @param i First row of the block.
+     * @param j First column of the block.
+     * @param r Number of rows of the block.
+     * @param c Number of columns of the block.
+     * @return View of the block.
+     *
+     * It throws an exception when the block does not fit in the view.
+     */
+    MatrixView<T> block(Index i, Index j, Index r, Index c) const
+    {
+        if (i < 0 || j < 0 || r < 0 || c < 0 || i + r > nrows ||
+            j + c > ncols)
+            throw std::out_of_range("view block out of range");
+        return MatrixView<T>(p + i * rs + j * cs, r, c, rs, cs);
+    }
+
+    /**
+     * @brief View of a row.
+     * @param i Row.
+     * @return View of the row.
+     */
+    VectorView<T> row(Index i) const
+    {
+        if (i < 0 || i >= nrows)
+            throw std::out_of_range("view row out of range");
+        return VectorView<T>(p + i * rs, ncols, cs);
+    }
+
+    /**
+     * @brief View of a column.
+     * @param j Column.
+     * @return View of the column.
+     */
+    VectorView<T> column(Index j) const
+    {
+        if (j < 0 || j >= ncols)
+            throw std::out_of_range("view column out of range");
+        return VectorView<T>(p + j * cs, nrows, rs);
+    }
+
+    /**
+     * @brief View of the main diagonal.
+     * @return View of the diagonal.
+     */
+    VectorView<T> diagonal() const
+    {
+        return VectorView<T>(p, nrows < ncols ? nrows : ncols, rs + cs);
+    }
+
+    /**
+     * @brief Transposed view.
+     * @return View of the same elements with rows and columns swapped.
+     */
+    MatrixView<T> transpose() const
+    {
+        return MatrixView<T>(p, ncols, nrows, cs, rs);
+    }
+};
+
+// VIEWS OF VECTOR AND MATRIX OBJECTS
+/**
+ * @brief View of a whole vector.
+ * @param v Vector.
+ * @return View of v.
+ */
+template <typename T>
+VectorView<T> view(Vector<T>& v)
+{
+    return VectorView<T>(v.data(), v.size());
+}
+
+/**
+ * @brief Read-only view of a whole vector.
+ * @param v Vector.
+ * @return View of v.
+ */
+template <typename T>
+VectorView<const T> view(const Vector<T>& v)
+{
+    return VectorView<const T>(v.data(), v.size());
+}
+
+/**
+ * @brief View of a whole matrix.
+ * @param m Matrix.
+ * @return View of m.
+ *
+ * Defined for the strided layouts, RowMajor and ColMajor; the tiles of a
+ * Tiled matrix are viewed one by one with tile().
+ */
+template <typename T, typename L>
+MatrixView<T> view(Matrix<T, L>& m)
+{
+    Index r = m.getNrows(), c = m.getNcols();
+
+    return MatrixView<T>(m.data(), r, c, L::row_stride(r, c),
+                         L::col_stride(r, c));
+}
+
+/**
+ * @brief Read-only view of a whole matrix.
+ * @param m Matrix.
+ * @return View of m.
+ */
+template <typename T, typename L>
+MatrixView<const T> view(const Matrix<T, L>& m)
+{
+    Index r = m.getNrows(), c = m.getNcols();
+
+    return MatrixView<const T>(m.data(), r, c, L::row_stride(r, c),
+                               L::col_stride(r, c));
+}
+
+/**
+ * @brief View of a block of a matrix.
+ * @param m Matrix.
+ * @param i First row of the block.
+ * @param j First column of the block.
+ * @param r Number of rows of the block.
+ * @param c Number of columns of the block.
+ * @return View of the block.
+ */
+template <typename T, typename L>
+MatrixView<T> block(Matrix<T, L>& m, Index i, Index j, Index r, Index c)
+{
+    return view(m).block(i, j, r, c);
+}
+
+/**
+ * @brief Read-only view of a block of a matrix.
+ * @param m Matrix.
+ * @param i First row of the block.
+ * @param j First column of the block.
+ * @param r Number of rows of the block.
+ * @param c Number of columns of the block.
+ * @return View of the block.
+ */
+template <typename T, typename L>
+MatrixView<const T> block(const Matrix<T, L>& m, Index i, Index j, Index r,
+                          Index c)
+{
+    return view(m).block(i, j, r, c);
+}
+
+/**
+ * @brief View of a row of a matrix.
+ * @param m Matrix.
+ * @param i Row.
+ * @return View of the row.
+ */
+template <typename T, typename L>
+VectorView<T> row(Matrix<T, L>& m, Index i)
+{
+    return view(m).row(i);
+}
+
+/**
+ * @brief Read-only view of a row of a matrix.
+ * @param m Matrix.
+ * @param i Row.
+ * @return View of the row.
+ */
+template <typename T, typename L>
+VectorView<const T> row(const Matrix<T, L>& m, Index i)
+{
+    return view(m).row(i);
+}
+
+/**
+ * @brief View of a column of a matrix.
+ * @param m Matrix.
+ * @param j Column.
+ * @return View of the column.
+ */
+template <typename T, typename L>
+VectorView<T> column(Matrix<T, L>& m, Index j)
+{
+    return view(m).column(j);
+}
+
+/**
+ * @brief Read-only view of a column of a matrix.
+ * @param m Matrix.
+ * @param j Column.
+ * @return View of the column.
+ */
+template <typename T, typename L>
+VectorView<const T> column(const Matrix<T, L>& m, Index j)
+{
+    return view(m).column(j);
+}
+
+/**
+ * @brief View of the main diagonal of a matrix.
+ * @param m Matrix.
+ * @return View of the diagonal.
+ */
+template <typename T, typename L>
+VectorView<T> diagonal(Matrix<T, L>& m)
+{
+    return view(m).diagonal();
+}
+
+/**
+ * @brief Read-only view of the main diagonal of a matrix.
+ * @param m Matrix.
+ * @return View of the diagonal.
+ */
+template <typename T, typename L>
+VectorView<const T> diagonal(const Matrix<T, L>& m)
+{
+    return view(m).diagonal();
+}
+
+/**
+ * @brief Transposed view of a matrix.
+ * @param m Matrix.
+ * @return View of m with rows and columns swapped.
+ */
+template <typename T, typename L>
+MatrixView<T> transpose(Matrix<T, L>& m)
+{
+    return view(m).transpose();
+}
+
+/**
+ * @brief Read-only transposed view of a matrix.
+ * @param m Matrix.
+ * @return View of m with rows and columns swapped.
+ */
+template <typename T, typename L>
+MatrixView<const T> transpose(const Matrix<T, L>& m)
+{
+    return view(m).transpose();
+}
+
+/**
+ * @brief View of a tile of a tiled matrix.
+ * @param m Matrix.
+ * @param bi Row of the tile.
+ * @param bj Column of the tile.
+ * @return View of the elements (bi B + i, bj B + j) of the tile.
+ *
+ * A tile is a B x B row-major block, but the tiles of the last row and the
+ * last column of tiles are cut to the size of the matrix. It throws an
+ * exception when the tile is out of range.
+ */
+template <typename T, int B>
+MatrixView<T> tile(Matrix<T, Tiled<B> >& m, Index bi, Index bj)
+{
+    Index r = m.getNrows(), c = m.getNcols();
+
+    if (bi < 0 || bj < 0 || bi * B >= r || bj * B >= c)
+        throw std::out_of_range("tile out of range");
+    return MatrixView<T>(m.data() + Tiled<B>::offset(bi * B, bj * B, r, c),
+                         r - bi * B < B ? r - bi * B : B,
+                         c - bj * B < B ? c - bj * B : B, B);
+}
+
+/**
+ * @brief Read-only view of a tile of a tiled matrix.
+ * @param m Matrix.
+ * @param bi Row of the tile.
+ * @param bj Column of the tile.
+ * @return View of the elements (bi B + i, bj B + j) of the tile.
+ *
+ * It throws an exception when the tile is out of range.
+ */
+template <typename T, int B>
+MatrixView<const T> tile(const Matrix<T, Tiled<B> >& m, Index bi, Index bj)
+{
+    Index r = m.getNrows(), c = m.getNcols();
+
+    if (bi < 0 || bj < 0 || bi * B >= r || bj * B >= c)
+        throw std::out_of_range("tile out of range");
+    return MatrixView<const T>(m.data() + Tiled<B>::offset(bi * B, bj * B,
+                                                           r, c),
+                               r - bi * B < B ? r - bi * B : B,
+                               c - bj * B < B ? c - bj * B : B, B);
+}
+
+#endif /* VIEW_H */